@@ -7,6 +7,77 @@ macro( PangolinRegisterFactory interface_name)
     endforeach()
 endmacro()
 
+# Add drivers to component, or with BUILD_PANGOLIN_PLUGINS build them into a
+# separate module which FactoryRegistry only loads once one of SCHEMES is used,
+# or a file:// uri with one of FILE_EXTENSIONS (lowercase, with the dot).
+# Sets ${plugin_name}_TARGET to the target to add SDK dependencies to.
+#
+#   PangolinFactoryPlugin(component plugin_name
+#       SOURCES file.cpp ...
+#       SCHEMES scheme ...
+#       [FILE_EXTENSIONS .ext ...]
+#       FACTORIES InterfaceA FactoryA1 FactoryA2 [InterfaceB FactoryB1 ...]
+#   )
+macro( PangolinFactoryPlugin component plugin_name)
+    cmake_parse_arguments(_plugin "" "" "SOURCES;SCHEMES;FILE_EXTENSIONS;FACTORIES" ${ARGN})
+
+    # Split FACTORIES into per-interface lists
+    set(_plugin_interfaces "")
+    foreach(_plugin_arg ${_plugin_FACTORIES})
+        if(_plugin_arg MATCHES "Interface$")
+            set(_plugin_interface ${_plugin_arg})
+            list(APPEND _plugin_interfaces ${_plugin_interface})
+            set(_plugin_factories_${_plugin_interface} "")
+        else()
+            list(APPEND _plugin_factories_${_plugin_interface} ${_plugin_arg})
+        endif()
+    endforeach()
+
+    if(BUILD_PANGOLIN_PLUGINS)
+        set(${plugin_name}_TARGET pango_plugin_${plugin_name})
+        set(_plugin_entry "${CMAKE_CURRENT_BINARY_DIR}/plugin_src/${plugin_name}_plugin.cpp")
+        set(_plugin_manifest "${PANGOLIN_PLUGIN_BUILD_DIR}/${plugin_name}.plugin.json")
+
+        set(_plugin_src "// CMake generated file. Do Not Edit.\n\nnamespace pangolin {\n")
+        set(_plugin_body "")
+        foreach(_plugin_interface ${_plugin_interfaces})
+            foreach(_plugin_factory ${_plugin_factories_${_plugin_interface}})
+                string(APPEND _plugin_src "  bool Register${_plugin_factory}Factory();\n")
+                string(APPEND _plugin_body "    success &= pangolin::Register${_plugin_factory}Factory();\n")
+            endforeach()
+        endforeach()
+        string(APPEND _plugin_src "}\n\n")
+        string(APPEND _plugin_src "#if defined(_WIN_)\n__declspec(dllexport)\n#endif\n")
+        string(APPEND _plugin_src "extern \"C\" bool PangolinRegisterPlugin()\n{\n    bool success = true;\n${_plugin_body}    return success;\n}\n")
+        file(GENERATE OUTPUT ${_plugin_entry} CONTENT "${_plugin_src}")
+
+        string(REPLACE ";" "\", \"" _plugin_schemes "${_plugin_SCHEMES}")
+        set(_plugin_extensions "")
+        if(_plugin_FILE_EXTENSIONS)
+            string(REPLACE ";" "\", \"" _plugin_extensions "${_plugin_FILE_EXTENSIONS}")
+            set(_plugin_extensions ",\n  \"file_extensions\": [\"${_plugin_extensions}\"]")
+        endif()
+        file(GENERATE OUTPUT ${_plugin_manifest} CONTENT
+            "{\n  \"library\": \"$<TARGET_FILE_NAME:${${plugin_name}_TARGET}>\",\n  \"schemes\": [\"${_plugin_schemes}\"]${_plugin_extensions}\n}\n"
+        )
+
+        add_library(${${plugin_name}_TARGET} MODULE ${_plugin_SOURCES} ${_plugin_entry})
+        target_link_libraries(${${plugin_name}_TARGET} PRIVATE ${component})
+        set_target_properties(${${plugin_name}_TARGET} PROPERTIES
+            LIBRARY_OUTPUT_DIRECTORY ${PANGOLIN_PLUGIN_BUILD_DIR}
+            RUNTIME_OUTPUT_DIRECTORY ${PANGOLIN_PLUGIN_BUILD_DIR}
+        )
+        install(TARGETS ${${plugin_name}_TARGET} LIBRARY DESTINATION ${PANGOLIN_PLUGIN_INSTALL_DIR} RUNTIME DESTINATION ${PANGOLIN_PLUGIN_INSTALL_DIR})
+        install(FILES ${_plugin_manifest} DESTINATION ${PANGOLIN_PLUGIN_INSTALL_DIR})
+    else()
+        set(${plugin_name}_TARGET ${component})
+        target_sources(${component} PRIVATE ${_plugin_SOURCES})
+        foreach(_plugin_interface ${_plugin_interfaces})
+            PangolinRegisterFactory(${_plugin_interface} ${_plugin_factories_${_plugin_interface}})
+        endforeach()
+    endif()
+endmacro()
+
 # Actually Create the method call file
 macro(create_factory_registry_file_now filename namespace interface_name)
     list(APPEND factory_names ${ARGN})
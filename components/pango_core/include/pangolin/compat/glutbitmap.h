@@ -29,6 +29,7 @@
 
 #include <pangolin/gl/glplatform.h>
 #include <pangolin/gl/glfont.h>
+#include <pangolin/gl/viewport.h>
 
 #ifdef HAVE_GLES
 GLfloat g_raster_pos[4];
@@ -78,6 +79,12 @@ inline void glutBitmapString(void * /*font*/, const unsigned char *str)
     float g_raster_pos[4];
     glGetFloatv(GL_CURRENT_RASTER_POSITION, g_raster_pos);
 #endif
+
+    // The raster position is relative to the render origin
+    GLint origin[2];
+    pangolin::Viewport::GetRenderOrigin(origin[0], origin[1]);
+    g_raster_pos[0] += origin[0];
+    g_raster_pos[1] += origin[1];
     
     pangolin::GlFont::I().Text( (const char *)str ).DrawWindow(
         g_raster_pos[0], g_raster_pos[1], g_raster_pos[2]
@@ -34,6 +34,7 @@
 #include <typeindex>
 #include <regex>
 #include <exception>
+#include <mutex>
 
 #include <pangolin/factory/factory.h>
 
@@ -58,6 +59,7 @@ public:
     template<typename T>
     bool RegisterFactory( const std::shared_ptr<TypedFactoryInterface<T>>& factory )
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
         TypeRegistry& registry = type_registries[typeid(T)];
         registry.push_back(factory);
         return true;
@@ -68,6 +70,7 @@ public:
     template<typename T>
     void UnregisterFactory(TypedFactoryInterface<T>* factory)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
         TypeRegistry& registry = type_registries[typeid(T)];
 
         registry.erase(
@@ -79,6 +82,7 @@ public:
     /// Remove all Factories from all types
     void UnregisterAllFactories()
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
         type_registries.clear();
     }
 
@@ -88,44 +92,15 @@ public:
     template<typename T>
     std::unique_ptr<T> Construct(const Uri& uri)
     {
-        TypeRegistry& registry = type_registries[typeid(T)];
-
-        TypeRegistry candidates;
-        std::copy_if(registry.begin(), registry.end(), std::back_inserter(candidates), [&](auto& factory){
-            const auto schemes = factory->Schemes();
-            return schemes.find(uri.scheme) != schemes.end();
-        });
-
-        if(candidates.size() == 0) {
-            throw NoMatchingSchemeException( uri);
-        }
-
-        // Order candidates by precedence.
-        std::sort(candidates.begin(), candidates.end(), [&](auto& lhs, auto& rhs){
-            // We know that all candidates contain scheme
-            return lhs->Schemes()[uri.scheme] < rhs->Schemes()[uri.scheme];
-        });
-
-        // Try candidates in order
-        for(auto& factory : candidates) {
-            std::unordered_set<std::string> orphan_params = ParamReader( factory->Params(), uri ).FindUnrecognizedUriParams();
-            if( orphan_params.size() == 0 )
-            {
-                TypedFactoryInterface<T>* factoryT = dynamic_cast<TypedFactoryInterface<T>*>(factory.get());
-                if(factoryT) {
-                    std::unique_ptr<T> video = factoryT->Open(uri);
-                    if(video) return video;
-                }
-            }else{
-                throw ParameterMismatchException(uri, orphan_params);
-            }
-        }
-
-        throw NoFactorySucceededException(uri);
+        // Plugins offering this scheme or file type may provide better
+        // matches than any factory registered so far, so load them first.
+        LoadPluginsForUri(uri);
+        return ConstructFromRegistered<T>(uri);
     }
 
     const TypeRegistry& GetFactories(std::type_index type) const
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
         const auto& ifac = type_registries.find(type);
         if(ifac != type_registries.end()) {
             return ifac->second;
@@ -139,6 +114,25 @@ public:
         return GetFactories(typeid(T));
     }
 
+    /// Plugins are modules containing factories which are only loaded once a
+    /// uri with one of their schemes is first constructed. Each is described
+    /// by a `<name>.plugin.json` manifest of the form
+    ///   { "library": "libpango_plugin_name.so", "schemes": ["a", "b"],
+    ///     "file_extensions": [".mp4"] }
+    /// found in a directory of the PANGOLIN_PLUGIN_PATH environment variable,
+    /// or in the directory plugins were built or installed to. The library
+    /// must export `extern "C" bool PangolinRegisterPlugin()`.
+    /// \return true iff any plugin was newly loaded.
+    bool LoadPluginsForScheme(const std::string& scheme);
+
+    /// Load plugins for uri's scheme and, for file:// and files:// uris,
+    /// those whose optional "file_extensions" include the file's extension.
+    /// \return true iff any plugin was newly loaded.
+    bool LoadPluginsForUri(const Uri& uri);
+
+    /// Load all available plugins, e.g. to list every factory in help.
+    void LoadAllPlugins();
+
     /// Base class for FactoryRegistry Exceptions
     class Exception : public std::exception {
     public:
@@ -184,7 +178,72 @@ public:
     };
 
 private:
+    struct Plugin {
+        std::string library_path;
+        std::vector<std::string> schemes;
+        std::vector<std::string> file_extensions;
+        bool attempted;
+    };
+
+    /// Construct using factories registered so far, in order of precedence
+    template<typename T>
+    std::unique_ptr<T> ConstructFromRegistered(const Uri& uri)
+    {
+        // Factories are opened unlocked, since they may block or construct
+        // other objects themselves.
+        TypeRegistry candidates;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            const TypeRegistry& registry = type_registries[typeid(T)];
+            std::copy_if(registry.begin(), registry.end(), std::back_inserter(candidates), [&](auto& factory){
+                const auto schemes = factory->Schemes();
+                return schemes.find(uri.scheme) != schemes.end();
+            });
+        }
+
+        if(candidates.size() == 0) {
+            throw NoMatchingSchemeException( uri);
+        }
+
+        // Order candidates by precedence.
+        std::sort(candidates.begin(), candidates.end(), [&](auto& lhs, auto& rhs){
+            // We know that all candidates contain scheme
+            return lhs->Schemes()[uri.scheme] < rhs->Schemes()[uri.scheme];
+        });
+
+        // Try candidates in order
+        for(auto& factory : candidates) {
+            std::unordered_set<std::string> orphan_params = ParamReader( factory->Params(), uri ).FindUnrecognizedUriParams();
+            if( orphan_params.size() == 0 )
+            {
+                TypedFactoryInterface<T>* factoryT = dynamic_cast<TypedFactoryInterface<T>*>(factory.get());
+                if(factoryT) {
+                    std::unique_ptr<T> video = factoryT->Open(uri);
+                    if(video) return video;
+                }
+            }else{
+                throw ParameterMismatchException(uri, orphan_params);
+            }
+        }
+
+        throw NoFactorySucceededException(uri);
+    }
+
+    void FindPlugins();
+    bool LoadPlugin(Plugin& plugin);
+
+    bool plugins_found = false;
+    std::vector<Plugin> plugins;
+
+    // Declared before type_registries so that plugin code outlives the
+    // factories it provided.
+    std::vector<std::shared_ptr<void>> plugin_libraries;
+
     std::map<std::type_index, TypeRegistry> type_registries;
+
+    // Guards plugins and type_registries. Recursive, since plugins register
+    // their factories whilst they are loaded.
+    mutable std::recursive_mutex mutex;
 };
 
 /// Macro to define factory entry point. Add a corresponding line in your cmake:
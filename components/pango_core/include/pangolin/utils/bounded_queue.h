@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace pangolin
+{
+
+// Blocking FIFO with fixed capacity, for connecting the stages of a
+// multi-threaded pipeline. Producers block while the queue is full and
+// consumers while it is empty, which bounds the work (and memory) in flight.
+// Closing the queue wakes everyone: Push then fails, and Pop fails once the
+// remaining items have been drained.
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity(capacity), closed(false)
+    {
+    }
+
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        not_full.wait(l, [this](){ return closed || items.size() < capacity; });
+        if(closed) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& item)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        not_empty.wait(l, [this](){ return closed || !items.empty(); });
+        if(items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    bool IsClosed() const
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        return closed;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        return items.size();
+    }
+
+    size_t Capacity() const
+    {
+        return capacity;
+    }
+
+private:
+    const size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    mutable std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+}
@@ -52,4 +52,31 @@ protected:
     }
 };
 
+// Read-only streambuf over existing memory, which must outlive it
+struct imemstreambuf : public std::streambuf
+{
+public:
+    imemstreambuf(const char* data, size_t size)
+    {
+        char* p = const_cast<char*>(data);
+        setg(p, p, p + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if(!(which & std::ios_base::in)) return pos_type(off_type(-1));
+        char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+        char* p = base + off;
+        if(p < eback() || p > egptr()) return pos_type(off_type(-1));
+        setg(eback(), p, egptr());
+        return pos_type(p - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace pangolin
+{
+
+// Hands items produced out of order, such as frames finished by a pool of
+// workers, back in sequence. Producers Put each item with its sequence number
+// and the consumer Gets them one number after another. Finish marks how many
+// items there will be, and Abort wakes everyone so that Get fails.
+template<typename T>
+class ReorderQueue
+{
+public:
+    ReorderQueue()
+        : end(std::numeric_limits<size_t>::max()), aborted(false)
+    {
+    }
+
+    void Put(size_t seq, T item)
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        items[seq] = std::move(item);
+        cv.notify_all();
+    }
+
+    // Returns false once all items have been returned, on abort, or if item
+    // seq isn't ready and wait is false.
+    bool Get(size_t seq, T& item, bool wait = true)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        auto ready = [&](){ return aborted || seq >= end || items.count(seq); };
+        if(wait) {
+            cv.wait(l, ready);
+        }else if(!ready()) {
+            return false;
+        }
+        if(aborted || seq >= end) return false;
+        auto it = items.find(seq);
+        item = std::move(it->second);
+        items.erase(it);
+        return true;
+    }
+
+    bool Ready(size_t seq) const
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        return items.count(seq) > 0;
+    }
+
+    void Finish(size_t num_items)
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        end = num_items;
+        cv.notify_all();
+    }
+
+    void Abort()
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        aborted = true;
+        cv.notify_all();
+    }
+
+private:
+    std::map<size_t, T> items;
+    size_t end;
+    bool aborted;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+};
+
+}
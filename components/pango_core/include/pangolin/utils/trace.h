@@ -0,0 +1,133 @@
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/utils/timer.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pangolin {
+
+// Process-wide recorder of timed scopes, for seeing where a pipeline spends
+// its time. Each thread records into a ring buffer of its own, keeping its
+// most recent events, and the lot can be written out in the Chrome trace
+// event format, which chrome://tracing and Perfetto (ui.perfetto.dev) open.
+//
+// Tracing is off until Start() is called, and costs a single atomic load per
+// scope whilst off. A thread's buffer is only created once it records an
+// event, and is released once the thread has exited and its events have been
+// written out (or discarded by Start()). Setting the environment variable PANGOLIN_TRACE=file.json
+// starts it when the library is loaded and writes the trace at exit.
+class PANGOLIN_EXPORT Tracer
+{
+public:
+    static constexpr size_t DefaultEventsPerThread = 64 * 1024;
+
+    struct Event
+    {
+        // Must outlive the tracer, e.g. string literals
+        const char* category;
+        const char* name;
+        basetime start;
+        basetime end;
+    };
+
+    static Tracer& Instance();
+
+    static bool Enabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Discard anything recorded so far and start recording, keeping the
+    // latest events_per_thread events on each thread.
+    void Start(size_t events_per_thread = DefaultEventsPerThread);
+
+    // Stop recording, keeping what has been recorded
+    void Stop();
+
+    // Record a scope on the calling thread, if tracing
+    void Record(const char* category, const char* name, basetime start, basetime end);
+
+    // Label the calling thread in the trace. Cheap whilst tracing is off.
+    void SetThreadName(const std::string& name);
+
+    // Write events recorded so far, then release the buffers of threads which
+    // have exited. Throws std::runtime_error if the file can't be written.
+    void WriteChromeTrace(std::ostream& os);
+    void WriteChromeTrace(const std::string& filename);
+
+    // Number of threads with buffers held by the tracer
+    size_t NumThreadBuffers() const;
+
+private:
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t next;
+        size_t size;
+        size_t id;
+        std::string name;
+        std::atomic<bool> exited;
+    };
+
+    // Per thread state, which marks its buffer as reclaimable on thread exit
+    struct ThreadState
+    {
+        ~ThreadState();
+        std::string name;
+        std::shared_ptr<ThreadBuffer> buffer;
+    };
+
+    Tracer();
+    Tracer(const Tracer&) = delete;
+
+    static ThreadState& LocalState();
+    ThreadBuffer& LocalBuffer();
+    void ReleaseExited();
+
+    static std::atomic<bool> enabled;
+
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    size_t next_id;
+    std::atomic<size_t> events_per_thread;
+    basetime epoch;
+};
+
+// Records the time between its construction and destruction
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name)
+        : category(category), name(name), active(Tracer::Enabled())
+    {
+        if(active) start = TimeNow();
+    }
+
+    ~TraceScope()
+    {
+        if(active) Tracer::Instance().Record(category, name, start, TimeNow());
+    }
+
+private:
+    const char* category;
+    const char* name;
+    bool active;
+    basetime start;
+};
+
+#define PANGO_TRACE_CONCAT_IMPL(a, b) a##b
+#define PANGO_TRACE_CONCAT(a, b) PANGO_TRACE_CONCAT_IMPL(a, b)
+
+// Trace the rest of the enclosing scope. category and name must be string
+// literals (or otherwise outlive the tracer).
+#define PANGO_TRACE_SCOPE(category, name) \
+    pangolin::TraceScope PANGO_TRACE_CONCAT(pango_trace_scope_, __LINE__)(category, name)
+
+}
@@ -1,5 +1,15 @@
 #include "pangolin/factory/factory_registry.h"
 
+#include <pangolin/utils/file_extension.h>
+#include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/log.h>
+#include <pangolin/utils/picojson.h>
+
+#include <dynalo/dynalo.hpp>
+
+#include <cstdlib>
+#include <fstream>
+
 namespace pangolin {
 
 std::shared_ptr<FactoryRegistry> FactoryRegistry::I()
@@ -8,4 +18,125 @@ std::shared_ptr<FactoryRegistry> FactoryRegistry::I()
     return registry;
 }
 
+namespace {
+
+std::vector<std::string> PluginSearchPaths()
+{
+#ifdef _WIN_
+    const char sep = ';';
+#else
+    const char sep = ':';
+#endif
+
+    std::vector<std::string> paths;
+    if(const char* env = std::getenv("PANGOLIN_PLUGIN_PATH")) {
+        paths = Split(env, sep);
+    }
+#ifdef PANGOLIN_PLUGIN_BUILD_DIR
+    paths.push_back(PANGOLIN_PLUGIN_BUILD_DIR);
+#endif
+#ifdef PANGOLIN_PLUGIN_INSTALL_DIR
+    paths.push_back(PANGOLIN_PLUGIN_INSTALL_DIR);
+#endif
+    return paths;
+}
+
+}
+
+void FactoryRegistry::FindPlugins()
+{
+    if(plugins_found) return;
+    plugins_found = true;
+
+    for(const std::string& dir : PluginSearchPaths()) {
+        std::vector<std::string> manifests;
+        if(dir.empty() || !FileExists(dir) || !FilesMatchingWildcard(dir + "/*.plugin.json", manifests)) {
+            continue;
+        }
+
+        for(const std::string& manifest : manifests) {
+            std::ifstream ifs(manifest);
+            picojson::value json;
+            const std::string err = picojson::parse(json, ifs);
+            if(!err.empty() || !json.contains("library") || !json.contains("schemes")) {
+                pango_print_warn("Ignoring invalid plugin manifest '%s'. %s\n", manifest.c_str(), err.c_str());
+                continue;
+            }
+
+            Plugin plugin;
+            plugin.library_path = PathParent(manifest) + "/" + json["library"].get<std::string>();
+            plugin.attempted = false;
+            for(const picojson::value& scheme : json["schemes"].get<picojson::array>()) {
+                plugin.schemes.push_back(scheme.get<std::string>());
+            }
+            if(json.contains("file_extensions")) {
+                for(const picojson::value& ext : json["file_extensions"].get<picojson::array>()) {
+                    plugin.file_extensions.push_back(ext.get<std::string>());
+                }
+            }
+            plugins.push_back(plugin);
+        }
+    }
+}
+
+bool FactoryRegistry::LoadPlugin(Plugin& plugin)
+{
+    if(plugin.attempted) return false;
+    plugin.attempted = true;
+
+    try {
+        auto library = std::make_shared<dynalo::library>(plugin.library_path);
+        auto register_plugin = library->get_function<bool()>("PangolinRegisterPlugin");
+        plugin_libraries.push_back(library);
+        if(!register_plugin()) {
+            pango_print_warn("Plugin '%s' failed to register all of its factories.\n", plugin.library_path.c_str());
+        }
+        return true;
+    }catch(const std::exception& e) {
+        // e.g. the SDK it depends on is no longer installed
+        pango_print_warn("Unable to load plugin '%s': %s\n", plugin.library_path.c_str(), e.what());
+        return false;
+    }
+}
+
+bool FactoryRegistry::LoadPluginsForScheme(const std::string& scheme)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    FindPlugins();
+
+    bool loaded = false;
+    for(Plugin& plugin : plugins) {
+        if(std::find(plugin.schemes.begin(), plugin.schemes.end(), scheme) != plugin.schemes.end()) {
+            loaded |= LoadPlugin(plugin);
+        }
+    }
+    return loaded;
+}
+
+bool FactoryRegistry::LoadPluginsForUri(const Uri& uri)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bool loaded = LoadPluginsForScheme(uri.scheme);
+
+    if(uri.scheme == "file" || uri.scheme == "files") {
+        const std::string ext = FileLowercaseExtention(uri.url);
+        for(Plugin& plugin : plugins) {
+            if(!ext.empty() && std::find(plugin.file_extensions.begin(), plugin.file_extensions.end(), ext) != plugin.file_extensions.end()) {
+                loaded |= LoadPlugin(plugin);
+            }
+        }
+    }
+    return loaded;
+}
+
+void FactoryRegistry::LoadAllPlugins()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    FindPlugins();
+
+    for(Plugin& plugin : plugins) {
+        LoadPlugin(plugin);
+    }
+}
+
 }
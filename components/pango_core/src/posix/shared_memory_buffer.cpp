@@ -69,6 +69,11 @@ public:
     return _ptr;
   }
 
+  size_t size() override
+  {
+    return _size;
+  }
+
   std::string name() override
   {
     return _name;
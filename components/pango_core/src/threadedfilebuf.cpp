@@ -28,6 +28,7 @@
 #include <pangolin/utils/threadedfilebuf.h>
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/sigstate.h>
+#include <pangolin/utils/trace.h>
 
 #include <cstring>
 #include <stdexcept>
@@ -192,8 +193,11 @@ std::streamsize threadedfilebuf::xsputn(const char* data, std::streamsize num_by
         std::unique_lock<std::mutex> lock(update_mutex);
 
         // wait until there is space to write into buffer
-        while( mem_size + num_bytes > mem_max_size ) {
-            cond_dequeued.wait(lock);
+        if( mem_size + num_bytes > mem_max_size ) {
+            PANGO_TRACE_SCOPE("io", "threadedfilebuf::WaitForSpace");
+            while( mem_size + num_bytes > mem_max_size ) {
+                cond_dequeued.wait(lock);
+            }
         }
 
         // add image to end of mem_buffer
@@ -264,6 +268,7 @@ std::streampos threadedfilebuf::seekoff(
 
 void threadedfilebuf::operator()()
 {
+    Tracer::Instance().SetThreadName("threadedfilebuf");
     std::streamsize data_to_write = 0;
 
     while(true)
@@ -326,6 +331,7 @@ void threadedfilebuf::operator()()
 #endif
 
         // Write data through to disk.
+        PANGO_TRACE_SCOPE("io", "threadedfilebuf::Write");
 #ifdef USE_POSIX_FILE_IO
         int bytes_written = ::write(filenum, mem_buffer + mem_start, data_to_write);
         if(bytes_written == -1)
@@ -0,0 +1,224 @@
+#include <pangolin/utils/trace.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace pangolin {
+
+namespace {
+
+double Microseconds(basetime epoch, basetime t)
+{
+    return std::chrono::duration<double, std::micro>(t - epoch).count();
+}
+
+void WriteJsonString(std::ostream& os, const std::string& str)
+{
+    os << '"';
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            os << '\\' << c;
+        }else if((unsigned char)c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            os << escaped;
+        }else{
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+std::string trace_at_exit_filename;
+
+void WriteTraceAtExit()
+{
+    try {
+        Tracer::Instance().Stop();
+        Tracer::Instance().WriteChromeTrace(trace_at_exit_filename);
+    }catch(const std::exception& e) {
+        std::fprintf(stderr, "Unable to write trace: %s\n", e.what());
+    }
+}
+
+// Start tracing when the library is loaded if asked to by PANGOLIN_TRACE
+const bool trace_from_env = [](){
+    if(const char* env = std::getenv("PANGOLIN_TRACE")) {
+        trace_at_exit_filename = env;
+        if(!trace_at_exit_filename.empty()) {
+            Tracer::Instance().Start();
+            std::atexit(WriteTraceAtExit);
+            return true;
+        }
+    }
+    return false;
+}();
+
+}
+
+std::atomic<bool> Tracer::enabled(false);
+
+Tracer& Tracer::Instance()
+{
+    // Never destroyed, so that threads still running during exit can record
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+}
+
+Tracer::Tracer()
+    : next_id(1), events_per_thread(DefaultEventsPerThread), epoch(TimeNow())
+{
+}
+
+void Tracer::Start(size_t events)
+{
+    std::lock_guard<std::mutex> l(mutex);
+    events_per_thread = std::max<size_t>(events, 1);
+    ReleaseExited();
+    for(auto& buffer : buffers) {
+        std::lock_guard<std::mutex> lb(buffer->mutex);
+        buffer->events.clear();
+        buffer->next = 0;
+        buffer->size = 0;
+    }
+    enabled = true;
+}
+
+void Tracer::Stop()
+{
+    enabled = false;
+}
+
+Tracer::ThreadState::~ThreadState()
+{
+    if(buffer) buffer->exited = true;
+}
+
+Tracer::ThreadState& Tracer::LocalState()
+{
+    thread_local ThreadState state;
+    return state;
+}
+
+Tracer::ThreadBuffer& Tracer::LocalBuffer()
+{
+    // Shared with the tracer, so that events outlive the thread
+    ThreadState& state = LocalState();
+    if(!state.buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->next = 0;
+        buffer->size = 0;
+        buffer->name = state.name;
+        buffer->exited = false;
+
+        std::lock_guard<std::mutex> l(mutex);
+        buffer->id = next_id++;
+        buffers.push_back(buffer);
+        state.buffer = buffer;
+    }
+    return *state.buffer;
+}
+
+void Tracer::ReleaseExited()
+{
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+        [](const std::shared_ptr<ThreadBuffer>& b){ return b->exited.load(); }), buffers.end());
+}
+
+void Tracer::Record(const char* category, const char* name, basetime start, basetime end)
+{
+    if(!Enabled()) return;
+
+    ThreadBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> l(buffer.mutex);
+
+    // Capacity is only known once tracing has started
+    if(buffer.events.empty()) {
+        buffer.events.resize(events_per_thread);
+    }
+
+    buffer.events[buffer.next] = {category, name, start, end};
+    buffer.next = (buffer.next + 1) % buffer.events.size();
+    buffer.size = std::min(buffer.size + 1, buffer.events.size());
+}
+
+void Tracer::SetThreadName(const std::string& name)
+{
+    // Kept until the thread first records, if it ever does
+    ThreadState& state = LocalState();
+    state.name = name;
+    if(state.buffer) {
+        std::lock_guard<std::mutex> l(state.buffer->mutex);
+        state.buffer->name = name;
+    }
+}
+
+size_t Tracer::NumThreadBuffers() const
+{
+    std::lock_guard<std::mutex> l(mutex);
+    return buffers.size();
+}
+
+void Tracer::WriteChromeTrace(std::ostream& os)
+{
+    // Threads which have exited by now can't record anything more, so their
+    // buffers can go once written
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        threads = buffers;
+        ReleaseExited();
+    }
+
+    const std::ios::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(const auto& buffer : threads) {
+        std::lock_guard<std::mutex> l(buffer->mutex);
+
+        if(!buffer->name.empty()) {
+            os << (first ? "\n" : ",\n");
+            os << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+            WriteJsonString(os, buffer->name);
+            os << "}}";
+            first = false;
+        }
+
+        // Oldest first
+        const size_t capacity = buffer->events.size();
+        for(size_t i = 0; i < buffer->size; ++i) {
+            const Event& e = buffer->events[(buffer->next + capacity - buffer->size + i) % capacity];
+            os << (first ? "\n" : ",\n");
+            os << "{\"ph\":\"X\",\"cat\":";
+            WriteJsonString(os, e.category);
+            os << ",\"name\":";
+            WriteJsonString(os, e.name);
+            os << ",\"pid\":1,\"tid\":" << buffer->id
+               << ",\"ts\":" << Microseconds(epoch, e.start)
+               << ",\"dur\":" << Microseconds(e.start, e.end) << "}";
+            first = false;
+        }
+    }
+    os << "\n]}\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Tracer::WriteChromeTrace(const std::string& filename)
+{
+    std::ofstream f(filename);
+    WriteChromeTrace(f);
+    if(!f) {
+        throw std::runtime_error("Unable to write trace to " + filename);
+    }
+}
+
+}
@@ -0,0 +1,95 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/utils/trace.h>
+#include <pangolin/utils/picojson.h>
+
+#include <sstream>
+#include <thread>
+
+TEST_CASE( "Traced scopes are written as Chrome trace events" )
+{
+    pangolin::Tracer& tracer = pangolin::Tracer::Instance();
+    {
+        PANGO_TRACE_SCOPE("test", "before start");
+    }
+
+    tracer.Start(4);
+    REQUIRE(pangolin::Tracer::Enabled());
+
+    std::thread t([](){
+        pangolin::Tracer::Instance().SetThreadName("worker \"1\"");
+        PANGO_TRACE_SCOPE("test", "worker");
+    });
+    t.join();
+
+    // Only the latest events per thread are kept
+    for(int i=0; i < 10; ++i) {
+        PANGO_TRACE_SCOPE("test", "main");
+    }
+    tracer.Stop();
+    {
+        PANGO_TRACE_SCOPE("test", "after stop");
+    }
+
+    std::stringstream ss;
+    tracer.WriteChromeTrace(ss);
+    picojson::value trace;
+    const std::string err = picojson::parse(trace, ss);
+    REQUIRE(err.empty());
+
+    size_t num_main = 0, num_worker = 0, num_names = 0;
+    for(const picojson::value& e : trace["traceEvents"].get<picojson::array>()) {
+        const std::string ph = e["ph"].get<std::string>();
+        if(ph == "M") {
+            REQUIRE(e["args"]["name"].get<std::string>() == "worker \"1\"");
+            ++num_names;
+            continue;
+        }
+        REQUIRE(ph == "X");
+        REQUIRE(e["cat"].get<std::string>() == "test");
+        REQUIRE(e["dur"].get<double>() >= 0.0);
+        const std::string name = e["name"].get<std::string>();
+        if(name == "main") ++num_main;
+        else if(name == "worker") ++num_worker;
+        else FAIL("Unexpected event " << name);
+    }
+    REQUIRE(num_main == 4);
+    REQUIRE(num_worker == 1);
+    REQUIRE(num_names == 1);
+}
+
+TEST_CASE( "Thread buffers are only kept while needed" )
+{
+    pangolin::Tracer& tracer = pangolin::Tracer::Instance();
+    tracer.Start(4);
+    std::stringstream discard;
+    tracer.WriteChromeTrace(discard);
+    tracer.Stop();
+    const size_t num_buffers = tracer.NumThreadBuffers();
+
+    // Naming threads whilst not tracing doesn't create buffers
+    for(int i=0; i < 10; ++i) {
+        std::thread([](){ pangolin::Tracer::Instance().SetThreadName("idle"); }).join();
+    }
+    REQUIRE(tracer.NumThreadBuffers() == num_buffers);
+
+    tracer.Start(4);
+    std::thread t([](){
+        pangolin::Tracer::Instance().SetThreadName("exited");
+        PANGO_TRACE_SCOPE("test", "exited");
+    });
+    t.join();
+    tracer.Stop();
+    REQUIRE(tracer.NumThreadBuffers() == num_buffers + 1);
+
+    // Written once more, then released
+    std::stringstream ss;
+    tracer.WriteChromeTrace(ss);
+    REQUIRE(ss.str().find("\"exited\"") != std::string::npos);
+    REQUIRE(tracer.NumThreadBuffers() == num_buffers);
+}
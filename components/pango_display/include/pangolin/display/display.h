@@ -80,6 +80,22 @@ namespace pangolin
   PANGOLIN_EXPORT
   void FinishFrame();
 
+  /// Only redraw when requested, instead of continuously. FinishFrame() then
+  /// blocks, servicing window events, until input arrives or RequestRedraw()
+  /// is called. Also settable with the window param render_on_demand=1.
+  PANGOLIN_EXPORT
+  void SetRenderOnDemand(bool on_demand);
+
+  /// Limit the rate at which FinishFrame() returns, still servicing window
+  /// events whilst waiting. 0 for unlimited (default), or window param max_fps.
+  PANGOLIN_EXPORT
+  void SetMaxFrameRate(double fps);
+
+  /// Request that the current window is redrawn, or all windows if called
+  /// from a thread without a bound context. Safe to call from any thread.
+  PANGOLIN_EXPORT
+  void RequestRedraw();
+
   /// Request that the window close.
   PANGOLIN_EXPORT
   void Quit();
@@ -47,12 +47,24 @@ class PANGOLIN_EXPORT ImageView : public pangolin::View, public pangolin::ImageV
 
     std::pair<float, float>& GetOffsetScale();
 
+    // Fractions of darkest and brightest samples to saturate when auto-gain
+    // sets the offset and scale ('a'). The default 0,1 uses the min / max.
+    ImageView& SetAutoGainPercentiles(float low, float high);
+
+    // Continually adjust the offset and scale as new images are set ('A')
+    ImageView& SetAutoGain(bool continuous);
+
     bool MouseReleased() const;
 
     bool MousePressed() const;
 
     void SetRenderOverlay(const bool& val);
 
+    void UpdateAutoGain(const Image<unsigned char>& img, const GlPixFormat& img_fmt);
+
+    // Upload to tex from the GL thread, without invalidating the view
+    void UploadImage(void* ptr, size_t w, size_t h, size_t pitch, const GlPixFormat& img_fmt);
+
 //  private:
     // img_to_load contains image data that should be uploaded to the texture on
     // the next render cycle. The data is owned by this object and should be
@@ -61,6 +73,16 @@ class PANGOLIN_EXPORT ImageView : public pangolin::View, public pangolin::ImageV
     pangolin::GlPixFormat img_fmt_to_load;
 
     std::pair<float, float> offset_scale;
+    float auto_gain_low;
+    float auto_gain_high;
+    bool auto_gain;
+    // Smoothed range tracked whilst auto_gain is enabled, and the offset and
+    // scale for it that the next Render() should apply. Guarded by texlock,
+    // since images are usually set from another thread.
+    std::pair<float, float> auto_gain_range;
+    bool auto_gain_range_valid;
+    std::pair<float, float> auto_gain_offset_scale;
+    bool auto_gain_pending;
     pangolin::GlPixFormat fmt;
     pangolin::GlTexture tex;
     bool lastPressed;
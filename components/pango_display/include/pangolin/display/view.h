@@ -27,7 +27,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include <pangolin/gl/viewport.h>
@@ -59,12 +61,14 @@ struct Handler;
 
 class OpenGlRenderState;
 
+struct ViewRenderCache;
+
 /// A Display manages the location and resizing of an OpenGl viewport.
 struct PANGOLIN_EXPORT View
 {
     View(double aspect=0.0)
         : aspect(aspect), top(1.0),left(0.0),right(1.0),bottom(0.0), hlock(LockCenter),vlock(LockCenter),
-          layout(LayoutOverlay), scroll_offset(0), show(1), zorder(0), handler(0), scroll_show(1) {}
+          layout(LayoutOverlay), scroll_offset(0), show(1), zorder(0), handler(0), invalidated(true), scroll_show(1) {}
     
     virtual ~View() {}
     
@@ -115,6 +119,23 @@ struct PANGOLIN_EXPORT View
     
     //! Instruct all children to render themselves if appropriate
     virtual void RenderChildren();
+
+    //! Draw this view and its children into an offscreen buffer which is only
+    //! redrawn once invalidated, and is otherwise copied straight to the window.
+    //! The copy is opaque over the view's client area, so this suits views
+    //! which fill their area, such as images, plots and 3D scenes.
+    View& SetRenderCached(bool cached = true);
+
+    //! Returns true if this view is drawn through an offscreen cache
+    bool IsRenderCached() const;
+
+    //! Mark the content of this view (and optionally of its children) as
+    //! changed, so that it is redrawn rather than taken from a cache.
+    //! Input events invalidate every view. Safe to call from any thread.
+    void Invalidate(bool include_children = false);
+
+    //! Returns true if this view or any child has been invalidated since drawn
+    bool IsInvalidated() const;
     
     //! Set this view as the active View to receive input
     View& SetFocus();
@@ -213,6 +234,12 @@ struct PANGOLIN_EXPORT View
     // External draw function
     std::function<void(View&)> extern_draw_function;
 
+    // Offscreen buffer for this view, if render cached
+    std::shared_ptr<ViewRenderCache> render_cache;
+
+    // Content changed since last drawn
+    std::atomic<bool> invalidated;
+
     ////////////////////////////////////////////////
 
     PANGOLIN_DEPRECATED("Use pangolin::SaveWindowOnRender(...) instead.")
@@ -224,6 +251,11 @@ struct PANGOLIN_EXPORT View
 private:
     // Private copy constructor
     View(View&) { /* Do Not copy - take reference instead*/ }
+
+    // Draw through the offscreen cache, refreshing it if invalidated
+    void RenderCached();
+
+    void ClearInvalidated();
     
     bool scroll_show;
 };
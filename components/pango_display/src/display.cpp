@@ -106,9 +106,13 @@ WindowInterface& CreateWindowAndBind(std::string window_title, int w, int h, con
     win_uri.scheme = win_uri.Get("scheme", win_uri.scheme);
     const std::string default_font = win_uri.Get<std::string>("default_font","");
     const int default_font_size = win_uri.Get("default_font_size", 18);
+    const bool render_on_demand = win_uri.Get("render_on_demand", false);
+    const double max_fps = win_uri.Get("max_fps", 0.0);
     win_uri.Remove("scheme");
     win_uri.Remove("default_font");
     win_uri.Remove("default_font_size");
+    win_uri.Remove("render_on_demand");
+    win_uri.Remove("max_fps");
 
     // Additional arguments we will send to factory
     win_uri.Set("w", w);
@@ -119,27 +123,39 @@ WindowInterface& CreateWindowAndBind(std::string window_title, int w, int h, con
     context->window = ConstructWindow(win_uri);
     assert(context->window);
 
+    context->render_on_demand = render_on_demand;
+    context->max_fps = max_fps;
+
     RegisterNewContext(window_title, context);
 
+    // Any input may change what is drawn, so redraw in response. The
+    // context owns the window, so outlives these connections.
+    PangolinGl* ctx = context.get();
     context->window->CloseSignal.connect( [](){
         pangolin::Quit();
     });
-    context->window->ResizeSignal.connect( [](WindowResizeEvent event){
+    context->window->ResizeSignal.connect( [ctx](WindowResizeEvent event){
+        ctx->redraw_requested = true;
         process::Resize(event.width, event.height);
     });
-    context->window->KeyboardSignal.connect( [](KeyboardEvent event) {
+    context->window->KeyboardSignal.connect( [ctx](KeyboardEvent event) {
+        ctx->redraw_requested = true;
         process::Keyboard(event.key, event.x, event.y, event.pressed, event.key_modifiers);
     });
-    context->window->MouseSignal.connect( [](MouseEvent event){
+    context->window->MouseSignal.connect( [ctx](MouseEvent event){
+        ctx->redraw_requested = true;
         process::Mouse(event.button, event.pressed, event.x, event.y, event.key_modifiers);
     });
-    context->window->MouseMotionSignal.connect( [](MouseMotionEvent event){
+    context->window->MouseMotionSignal.connect( [ctx](MouseMotionEvent event){
+        ctx->redraw_requested = true;
         process::MouseMotion(event.x, event.y, event.key_modifiers);
     });
-    context->window->PassiveMouseMotionSignal.connect( [](MouseMotionEvent event){
+    context->window->PassiveMouseMotionSignal.connect( [ctx](MouseMotionEvent event){
+        ctx->redraw_requested = true;
         process::PassiveMouseMotion(event.x, event.y, event.key_modifiers);
     });
-    context->window->SpecialInputSignal.connect( [](SpecialInputEvent event){
+    context->window->SpecialInputSignal.connect( [ctx](SpecialInputEvent event){
+        ctx->redraw_requested = true;
         process::SpecialInput(event.inType, event.x, event.y, event.p[0], event.p[1], event.p[2], event.p[3], event.key_modifiers);
     });
 
@@ -235,8 +251,35 @@ void Quit()
 
 void QuitAll()
 {
+    std::unique_lock<std::recursive_mutex> l(contexts_mutex);
     for(const auto& nc : contexts) {
         nc.second->quit = true;
+        if(nc.second->window) nc.second->window->Wake();
+    }
+}
+
+void SetRenderOnDemand(bool on_demand)
+{
+    if(context) {
+        context->render_on_demand = on_demand;
+        context->redraw_requested = true;
+    }
+}
+
+void SetMaxFrameRate(double fps)
+{
+    if(context) context->max_fps = fps;
+}
+
+void RequestRedraw()
+{
+    if(context) {
+        context->RequestRedraw();
+    }else{
+        std::unique_lock<std::recursive_mutex> l(contexts_mutex);
+        for(const auto& nc : contexts) {
+            nc.second->RequestRedraw();
+        }
     }
 }
 
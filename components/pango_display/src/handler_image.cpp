@@ -1,6 +1,8 @@
 #include <pangolin/handler/handler_image.h>
 #include <pangolin/display/default_font.h>
 
+#include <cmath>
+
 namespace pangolin
 {
 
@@ -211,14 +213,21 @@ void ImageViewHandler::glRenderOverlay()
     glColor4f(1.0,1.0,1.0,1.0);
     glPopMatrix();
 
-    const bool have_text = std::abs(selxy.Area()) > 0 || !title.empty();
+    // No selection is an empty range, with an infinite area
+    const bool have_selection = std::abs(selxy.Area()) > 0 && std::isfinite(selxy.Area());
+    const bool have_text = have_selection || !title.empty();
 
     GLboolean gl_blend_enabled;
     pangolin::Viewport v;
 
     if( have_text ) {
 
+        // Text is drawn in window coordinates
         glGetIntegerv( GL_VIEWPORT, &v.l );
+        GLint origin[2];
+        pangolin::Viewport::GetRenderOrigin(origin[0], origin[1]);
+        v.l += origin[0];
+        v.b += origin[1];
 
         // Save previous value
         glGetBooleanv(GL_BLEND, &gl_blend_enabled);
@@ -229,7 +238,7 @@ void ImageViewHandler::glRenderOverlay()
 
     }
 
-    if( std::abs(selxy.Area()) > 0) {
+    if( have_selection ) {
         // Render text
         float xpix, ypix;
         ImageToScreen(v, selxy.x.max, selxy.y.max, xpix, ypix);
@@ -1,3 +1,4 @@
+#include <pangolin/display/display.h>
 #include <pangolin/display/image_view.h>
 #include <pangolin/image/image_utils.h>
 #include <pangolin/image/image_convert.h>
@@ -7,7 +8,10 @@ namespace pangolin
 {
 
 ImageView::ImageView(const std::string & title)
-    : pangolin::ImageViewHandler(title), offset_scale(0.0f, 1.0f), lastPressed(false), mouseReleased(false), mousePressed(false), overlayRender(true)
+    : pangolin::ImageViewHandler(title), offset_scale(0.0f, 1.0f),
+      auto_gain_low(0.0f), auto_gain_high(1.0f), auto_gain(false), auto_gain_range_valid(false),
+      auto_gain_offset_scale(0.0f, 1.0f), auto_gain_pending(false),
+      lastPressed(false), mouseReleased(false), mousePressed(false), overlayRender(true)
 {
     SetHandler(this);
 }
@@ -85,7 +89,19 @@ void ImageView::Keyboard(View& view, unsigned char key, int x, int y, bool press
         // Download texture so that we can take min / max
         pangolin::TypedImage img;
         tex.Download(img);
-        offset_scale = pangolin::GetOffsetScale(img, pangolin::Round(froi), img.fmt);
+        if(auto_gain_low <= 0.0f && auto_gain_high >= 1.0f) {
+            offset_scale = pangolin::GetOffsetScale(img, pangolin::Round(froi), img.fmt);
+        }else{
+            const std::pair<float,float> range = pangolin::GetPercentileRange(img, pangolin::Round(froi), img.fmt, auto_gain_low, auto_gain_high);
+            offset_scale = pangolin::GetOffsetScale(range, img.fmt);
+        }
+        Invalidate();
+    }
+    else if(key == 'A')
+    {
+        if(pressed) {
+            SetAutoGain(!auto_gain);
+        }
     }
     else if(key == 'b')
     {
@@ -123,6 +139,11 @@ ImageView& ImageView::SetImage(void* ptr, size_t w, size_t h, size_t pitch, pang
 
     const bool convert_first = (img_fmt.gltype == GL_DOUBLE);
 
+    // Pending images were already measured when they were set
+    if(!IsDevicePtr(ptr) && ptr != img_to_load.ptr) {
+        UpdateAutoGain(Image<unsigned char>((unsigned char*)ptr, w, h, pitch), img_fmt);
+    }
+
     if(delayed_upload || !pangolin::GetBoundWindow() || IsDevicePtr(ptr) || convert_first )
     {
         texlock.lock();
@@ -138,9 +159,23 @@ ImageView& ImageView::SetImage(void* ptr, size_t w, size_t h, size_t pitch, pang
             pango_print_warn("TextureView: Unable to display image.\n");
         }
         texlock.unlock();
+
+        // Typically set from a producer thread, so wake the display
+        Invalidate();
+        RequestRedraw();
         return *this;
     }
 
+    UploadImage(ptr, w, h, pitch, img_fmt);
+    Invalidate();
+    return *this;
+}
+
+void ImageView::UploadImage(void* ptr, size_t w, size_t h, size_t pitch, const GlPixFormat& img_fmt)
+{
+    const size_t pix_bytes =
+            pangolin::GlFormatChannels(img_fmt.glformat) * pangolin::GlDataTypeBytes(img_fmt.gltype);
+
     PANGO_ASSERT(pitch % pix_bytes == 0);
     const size_t stride = pitch / pix_bytes;
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -161,7 +196,6 @@ ImageView& ImageView::SetImage(void* ptr, size_t w, size_t h, size_t pitch, pang
     }
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    return *this;
 }
 
 ImageView& ImageView::SetImage(const pangolin::Image<unsigned char>& img, const pangolin::GlPixFormat& glfmt, bool delayed_upload )
@@ -188,24 +222,30 @@ ImageView& ImageView::SetImage(const pangolin::GlTexture& texture)
     glCopyImageSubData(
             texture.tid, GL_TEXTURE_2D, 0, 0, 0, 0, tex.tid, GL_TEXTURE_2D, 0, 0, 0, 0, tex.width, tex.height, 1);
 
+    Invalidate();
     return *this;
 }
 
 void ImageView::LoadPending()
 {
+    // Already invalidated when they were set
+    std::lock_guard<std::mutex> lock(texlock);
     if(img_to_load.ptr)
     {
-        // Scoped lock
-        texlock.lock();
-        SetImage(img_to_load, img_fmt_to_load, false);
+        UploadImage(img_to_load.ptr, img_to_load.w, img_to_load.h, img_to_load.pitch, img_fmt_to_load);
         img_to_load.Deallocate();
-        texlock.unlock();
+    }
+    if(auto_gain_pending)
+    {
+        offset_scale = auto_gain_offset_scale;
+        auto_gain_pending = false;
     }
 }
 
 ImageView& ImageView::Clear()
 {
     tex.Delete();
+    Invalidate();
     return *this;
 }
 
@@ -213,6 +253,63 @@ std::pair<float, float>& ImageView::GetOffsetScale() {
     return offset_scale;
 }
 
+ImageView& ImageView::SetAutoGainPercentiles(float low, float high)
+{
+    std::lock_guard<std::mutex> lock(texlock);
+    auto_gain_low = low;
+    auto_gain_high = high;
+    return *this;
+}
+
+ImageView& ImageView::SetAutoGain(bool continuous)
+{
+    std::lock_guard<std::mutex> lock(texlock);
+    auto_gain = continuous;
+    auto_gain_range_valid = false;
+    auto_gain_pending = false;
+    if(!auto_gain) {
+        offset_scale = std::pair<float,float>(0.0f, 1.0f);
+        Invalidate();
+    }
+    return *this;
+}
+
+void ImageView::UpdateAutoGain(const Image<unsigned char>& img, const GlPixFormat& img_fmt)
+{
+    std::unique_lock<std::mutex> lock(texlock);
+    if(!auto_gain) return;
+    const float low = auto_gain_low;
+    const float high = auto_gain_high;
+    lock.unlock();
+
+    // Subsample rows of large images since we only need an estimate each frame
+    const size_t max_samples = 1 << 18;
+    const size_t row_step = std::max<size_t>(1, img.Area() / max_samples);
+
+    const bool have_selection = std::isfinite(GetSelection().Area()) && std::abs(GetSelection().Area()) >= 4;
+    const XYRangei roi = have_selection ? pangolin::Round(GetSelection()) : XYRangei(0, (int)img.w-1, 0, (int)img.h-1);
+    const std::pair<float,float> range = pangolin::GetPercentileRange(img, roi, img_fmt, low, high, row_step);
+    if(!(range.first < range.second)) return;
+
+    // Applied by the next Render(), on the GL thread
+    lock.lock();
+    if(!auto_gain) return;
+
+    // Smooth so that noise between frames doesn't cause flicker
+    const float alpha = 0.3f;
+    if(auto_gain_range_valid) {
+        auto_gain_range.first += alpha * (range.first - auto_gain_range.first);
+        auto_gain_range.second += alpha * (range.second - auto_gain_range.second);
+    }else{
+        auto_gain_range = range;
+        auto_gain_range_valid = true;
+    }
+
+    auto_gain_offset_scale = pangolin::GetOffsetScale(auto_gain_range, img_fmt);
+    auto_gain_pending = true;
+    Invalidate();
+}
+
 bool ImageView::MouseReleased() const {
     return mouseReleased;
 }
@@ -28,13 +28,20 @@
 #include "pangolin_gl.h"
 #include <pangolin/display/display.h>
 #include <pangolin/console/ConsoleView.h>
+#include <pangolin/utils/trace.h>
+#include <pangolin/var/varstate.h>
 
 namespace pangolin
 {
 
 PangolinGl::PangolinGl()
-    : user_app(0), quit(false), mouse_state(0),activeDisplay(0)
+    : user_app(0), quit(false), mouse_state(0),
+      render_on_demand(false), max_fps(0.0), redraw_requested(true),
+      activeDisplay(0)
 {
+    var_changed_connection = VarState::I().RegisterForVarChanges(
+        [this](const std::shared_ptr<VarValueGeneric>&){ RequestRedraw(); }
+    );
 }
 
 PangolinGl::~PangolinGl()
@@ -56,12 +63,14 @@ void PangolinGl::MakeCurrent()
 
 void PangolinGl::RenderViews()
 {
+    PANGO_TRACE_SCOPE("display", "RenderViews");
     Viewport::DisableScissor();
     base.Render();
 }
 
 void PangolinGl::FinishFrame()
 {
+    PANGO_TRACE_SCOPE("display", "FinishFrame");
     RenderViews();
 
     while(screen_capture.size()) {
@@ -71,13 +80,51 @@ void PangolinGl::FinishFrame()
     }
 
     if(window) {
-        window->SwapBuffers();
-        window->ProcessEvents();
+        {
+            PANGO_TRACE_SCOPE("display", "SwapBuffers");
+            window->SwapBuffers();
+        }
+        WaitForNextFrame();
     }
 
     Viewport::DisableScissor();
 }
 
+void PangolinGl::RequestRedraw()
+{
+    // Only wake once per frame, however often redraws are requested
+    if(!redraw_requested.exchange(true) && window) {
+        window->Wake();
+    }
+}
+
+void PangolinGl::WaitForNextFrame()
+{
+    PANGO_TRACE_SCOPE("display", "WaitForNextFrame");
+    using Clock = std::chrono::steady_clock;
+
+    window->ProcessEvents();
+
+    // Honour the frame rate cap whilst continuing to service events
+    if(max_fps > 0.0) {
+        const Clock::time_point next_frame = last_frame +
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / max_fps));
+        for(Clock::time_point now = Clock::now(); !quit && now < next_frame; now = Clock::now()) {
+            if(window->WaitEvents(std::chrono::duration<double>(next_frame - now).count())) {
+                redraw_requested = true;
+            }
+        }
+    }
+
+    if(render_on_demand) {
+        while(!quit && !redraw_requested.exchange(false)) {
+            if(window->WaitEvents(-1.0)) break;
+        }
+    }
+
+    last_frame = Clock::now();
+}
+
 void PangolinGl::SetOnRender(std::function<void ()> on_render) {
     this->on_render = on_render;
 }
@@ -32,6 +32,9 @@
 
 #include <pangolin/display/view.h>
 #include <pangolin/display/user_app.h>
+#include <pangolin/utils/signal_slot.h>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 
@@ -63,6 +66,12 @@ struct PANGOLIN_EXPORT PangolinGl
 
     void SetOnRender(std::function<void()> on_render);
 
+    // Mark the window for redraw and wake it if waiting. Thread safe.
+    void RequestRedraw();
+
+    // Service window events until the next frame should be drawn
+    void WaitForNextFrame();
+
     // Callback for render loop
     std::function<void()> on_render;
 
@@ -81,6 +90,14 @@ struct PANGOLIN_EXPORT PangolinGl
     // State relating to interactivity
     bool quit;
     int mouse_state;
+
+    // Frame pacing. When rendering on demand, FinishFrame() blocks until
+    // a redraw is requested. max_fps of 0 is unlimited.
+    bool render_on_demand;
+    double max_fps;
+    std::atomic<bool> redraw_requested;
+    std::chrono::steady_clock::time_point last_frame;
+
     View* activeDisplay;
     
     std::queue<std::pair<std::string,Viewport> > screen_capture;
@@ -89,6 +106,10 @@ struct PANGOLIN_EXPORT PangolinGl
     std::shared_ptr<GlFont> font;
 
     std::unique_ptr<ConsoleView> console_view;
+
+    // Redraws when Vars are changed from code. Declared last so that it is
+    // disconnected first.
+    sigslot::scoped_connection var_changed_connection;
 };
 
 PangolinGl* GetCurrentContext();
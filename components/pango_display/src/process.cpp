@@ -37,6 +37,12 @@ namespace process
 float last_x = 0;
 float last_y = 0;
 
+// Input may change anything drawn, so bypass any render caches
+void InvalidateViews(PangolinGl* context)
+{
+    context->base.Invalidate(true);
+}
+
 void Resize( int width, int height )
 {
     PangolinGl* context = GetCurrentContext();
@@ -49,6 +55,8 @@ void Keyboard(unsigned char key, int x, int y, bool pressed, KeyModifierBitmask
 {
     PangolinGl* context = GetCurrentContext();
 
+    InvalidateViews(context);
+
     // Force coords to match OpenGl Window Coords
     y = context->base.v.h - y;
 
@@ -80,6 +88,8 @@ void Mouse( int button_raw, bool pressed, int x, int y, KeyModifierBitmask key_m
 {
     PangolinGl* context = GetCurrentContext();
 
+    InvalidateViews(context);
+
     // Force coords to match OpenGl Window Coords
     y = context->base.v.h - y;
 
@@ -114,6 +124,8 @@ void MouseMotion( int x, int y, KeyModifierBitmask key_modifiers)
 {
     PangolinGl* context = GetCurrentContext();
 
+    InvalidateViews(context);
+
     // Force coords to match OpenGl Window Coords
     y = context->base.v.h - y;
 
@@ -149,6 +161,8 @@ void SpecialInput(InputSpecial inType, float x, float y, float p1, float p2, flo
 {
     PangolinGl* context = GetCurrentContext();
 
+    InvalidateViews(context);
+
     // Force coords to match OpenGl Window Coords
     y = context->base.v.h - y;
 
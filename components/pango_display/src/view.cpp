@@ -246,10 +246,130 @@ void View::RenderChildren()
 {
     for(std::vector<View*>::iterator iv = views.begin(); iv != views.end(); ++iv )
     {
-        if((*iv)->show && (*iv)->scroll_show) (*iv)->Render();
+        if((*iv)->show && (*iv)->scroll_show) {
+            if((*iv)->render_cache) {
+                (*iv)->RenderCached();
+            }else{
+                (*iv)->Render();
+            }
+        }
     }
 }
 
+struct ViewRenderCache
+{
+    GlTexture colour;
+    GlRenderBuffer depth;
+    GlFramebuffer fbo;
+    Viewport region;
+};
+
+View& View::SetRenderCached(bool cached)
+{
+#ifndef HAVE_GLES
+    if(cached && !render_cache) {
+        render_cache = std::make_shared<ViewRenderCache>();
+        invalidated = true;
+    }else if(!cached) {
+        render_cache.reset();
+    }
+#else
+    (void)cached;
+#endif
+    return *this;
+}
+
+bool View::IsRenderCached() const
+{
+    return (bool)render_cache;
+}
+
+void View::Invalidate(bool include_children)
+{
+    invalidated = true;
+    if(include_children) {
+        for(View* child : views) child->Invalidate(true);
+    }
+}
+
+bool View::IsInvalidated() const
+{
+    if(invalidated) return true;
+    for(const View* child : views) {
+        if(child->IsInvalidated()) return true;
+    }
+    return false;
+}
+
+void View::ClearInvalidated()
+{
+    invalidated = false;
+    for(View* child : views) child->ClearInvalidated();
+}
+
+void View::RenderCached()
+{
+#ifndef HAVE_GLES
+    ViewRenderCache& cache = *render_cache;
+    const Viewport region = vp;
+    if(region.w <= 0 || region.h <= 0) return;
+
+    // Blitting into a multisampled target isn't possible
+    GLint sample_buffers = 0;
+    glGetIntegerv(GL_SAMPLE_BUFFERS, &sample_buffers);
+    if(sample_buffers > 0) {
+        Render();
+        return;
+    }
+
+    GLint prev_fbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    GLint prev_origin[2];
+    Viewport::GetRenderOrigin(prev_origin[0], prev_origin[1]);
+
+    if(!cache.fbo.fbid || cache.colour.width != region.w || cache.colour.height != region.h) {
+        cache.colour.Reinitialise(region.w, region.h, GL_RGBA8, true, 0, GL_RGBA, GL_UNSIGNED_BYTE);
+        // Matches the usual window depth format, so depth can be copied too
+        cache.depth.Reinitialise(region.w, region.h, GL_DEPTH24_STENCIL8);
+        cache.fbo.Reinitialise();
+        cache.fbo.attachments = 0;
+        cache.fbo.AttachColour(cache.colour);
+        cache.fbo.AttachDepth(cache.depth);
+        invalidated = true;
+    }
+
+    if(cache.region.l != region.l || cache.region.b != region.b) {
+        cache.region = region;
+        invalidated = true;
+    }
+
+    if(IsInvalidated()) {
+        // Draw in window coordinates, offset into the cache
+        cache.fbo.Bind();
+        Viewport::SetRenderOrigin(region.l, region.b);
+        Viewport::DisableScissor();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        ClearInvalidated();
+        Render();
+        Viewport::SetRenderOrigin(prev_origin[0], prev_origin[1]);
+        cache.fbo.Unbind();
+        glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo);
+    }
+
+    const GLint x = region.l - prev_origin[0];
+    const GLint y = region.b - prev_origin[1];
+    Viewport::DisableScissor();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, cache.fbo.fbid);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prev_fbo);
+    glBlitFramebuffer(0, 0, region.w, region.h, x, y, x + region.w, y + region.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // Keep depth for picking, which is only possible if the formats match
+    glBlitFramebuffer(0, 0, region.w, region.h, x, y, x + region.w, y + region.h, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo);
+#else
+    Render();
+#endif
+}
+
 void View::Activate() const
 {
     v.Activate();
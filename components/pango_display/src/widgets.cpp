@@ -55,34 +55,25 @@ const static GLfloat colour_dn[4] = {1.0f, 0.7f, 0.7f, 1.0f};
 // TODO: It doesn't look like this is doing anything meaningful right now...
 std::mutex display_mutex;
 
-// Render at (x,y) in window coordinates.
-inline void DrawWindow(GlText& text, GLfloat x, GLfloat y, GLfloat z = 0.0)
-{
-    // Backup viewport
-    GLint    view[4];
-    glGetIntegerv(GL_VIEWPORT, view );
-
-    auto& d = DisplayBase();
-    d.Activate();
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    // Pixel continuous coords
-    ProjectionMatrixOrthographic(-0.5, d.v.w-0.5, -0.5, d.v.h-0.5, -1.0, 1.0).Load();
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    glTranslatef( std::floor(x), std::floor(y), z);
-    text.Draw();
+// Number of Panels currently rendering their children on this thread.
+static thread_local int panel_render_depth = 0;
 
-    // Restore viewport
-    glViewport(view[0],view[1],view[2],view[3]);
+// Queue text at (x,y) in window coordinates. Widget text is batched and
+// drawn by FlushText() once the widget (or its owning Panel) has rendered.
+inline void DrawWindow(const GlText& text, GLfloat x, GLfloat y)
+{
+    default_font().Batch().Add(text, std::floor(x), std::floor(y), colour_tx);
+}
 
-    // Restore modelview / project matrices
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
+// Draw queued widget text now, unless an enclosing Panel will draw it
+// after its remaining children.
+inline void FlushText(bool force = false)
+{
+    GlTextBatch& batch = default_font().Batch();
+    if((force || panel_render_depth == 0) && !batch.Empty()) {
+        DisplayBase().ActivatePixelOrthographic();
+        batch.Flush();
+    }
 }
 
 static inline int cb_height()
@@ -97,7 +88,7 @@ static inline int tab_h()
 
 static inline float x_width()
 {
-  return default_font().Text("x").Width();
+  return default_font().CachedText("x").Width();
 }
 
 template<typename T>
@@ -194,6 +185,7 @@ void Panel::NewVarCallback(const VarState::Event& e)
         RemoveVariable(name);
         break;
     }
+    RequestRedraw();
 }
 
 void Panel::AddVariable(const std::string& name, const std::shared_ptr<VarValueGeneric>& var)
@@ -275,7 +267,11 @@ void Panel::Render()
     glRect(v);
     DrawShadowRect(v);
 
+    ++panel_render_depth;
     RenderChildren();
+    --panel_render_depth;
+
+    FlushText(true);
 
 #ifndef HAVE_GLES
     glPopAttrib();
@@ -334,6 +330,7 @@ void Button::Render()
     }
     DrawWindow(gltext, raster[0],raster[1]-down);
     DrawShadowRect(v, down);
+    FlushText();
 }
 
 void Button::ResizeChildren()
@@ -374,6 +371,7 @@ void FunctionButton::Render()
     }
     DrawWindow(gltext, raster[0],raster[1]-down);
     DrawShadowRect(v, down);
+    FlushText();
 }
 
 void FunctionButton::ResizeChildren()
@@ -425,6 +423,7 @@ void Checkbox::Render()
     }
     DrawWindow(gltext, raster[0], raster[1]);
     DrawShadowRect(vcb, val);
+    FlushText();
 }
 
 inline bool IsIntegral(const char* typeidname)
@@ -577,9 +576,10 @@ void Slider::Render()
     std::ostringstream oss;
     oss << setprecision(4) << val;
     string str = oss.str();
-    GlText glval = default_font().Text(str);
+    const GlText& glval = default_font().CachedText(str);
     const float l = glval.Width() + 2.0f;
     DrawWindow(glval,  v.l + v.w - l, raster[1] );
+    FlushText();
 }
 
 
@@ -677,7 +677,7 @@ void TextInput::Mouse(View& /*view*/, MouseButton button, int x, int /*y*/, bool
             }else{
                 for( unsigned i=0; i<edit_visible.length(); ++i )
                 {
-                    const int tl = (int)(rl + default_font().Text(edit_visible.substr(0,i)).Width());
+                    const int tl = (int)(rl + default_font().CachedText(edit_visible.substr(0,i)).Width());
                     if(x < tl+2)
                     {
                         ep = i;
@@ -717,7 +717,7 @@ void TextInput::MouseMotion(View&, int x, int /*y*/, int /*mouse_state*/)
         }else{
             for( unsigned i=0; i<edit.length(); ++i )
             {
-                const int tl = (int)(rl + default_font().Text(edit_visible.substr(0,i)).Width());
+                const int tl = (int)(rl + default_font().CachedText(edit_visible.substr(0,i)).Width());
                 if(x < tl+2)
                 {
                     ep = i;
@@ -744,7 +744,7 @@ void TextInput::CalcVisibleEditPart()
 {
     edit_visible_part[0] =  0;
 
-    if(default_font().Text(edit).Width() > input_width)
+    if(default_font().CachedText(edit).Width() > input_width)
     {
       if(sel[1] >= 0 )
       {
@@ -763,15 +763,17 @@ void TextInput::Render()
     if(can_edit) glRect(input_v);
 
     std::string edit_visible = edit.substr(edit_visible_part[0], edit_visible_part[1]);
-    gledit = default_font().Text(edit_visible);
+    if(gledit.Text() != edit_visible) {
+        gledit = default_font().Text(edit_visible);
+    }
 
     const int sl = (int)gledit.Width() + horizontal_margin;
     const int rl = v.l + v.w - sl;
 
     if( do_edit && sel[0] >= 0)
     {
-        const int tl = (int)(rl + default_font().Text(edit_visible.substr(0,sel[0] - edit_visible_part[0])).Width());
-        const int tr = (int)(rl + default_font().Text(edit_visible.substr(0,sel[1] - edit_visible_part[0])).Width());
+        const int tl = (int)(rl + default_font().CachedText(edit_visible.substr(0,sel[0] - edit_visible_part[0])).Width());
+        const int tr = (int)(rl + default_font().CachedText(edit_visible.substr(0,sel[1] - edit_visible_part[0])).Width());
         glColor4fv(colour_dn);
         glRect(Viewport(tl,input_v.b,tr-tl,input_v.h));
 
@@ -785,6 +787,7 @@ void TextInput::Render()
 
     DrawWindow(gledit, (GLfloat)(rl), input_v.b + vertical_margin);
     if(can_edit) DrawShadowRect(input_v);
+    FlushText();
 }
 
 }
@@ -0,0 +1,172 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/display/default_font.h>
+#include <pangolin/display/display.h>
+#include <pangolin/display/image_view.h>
+#include <pangolin/display/widgets.h>
+#include <pangolin/image/managed_image.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+std::vector<unsigned char> RenderWindow(int w, int h)
+{
+    glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    pangolin::DisplayBase().Render();
+    glFinish();
+
+    std::vector<unsigned char> pixels(w * h * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+// Render offscreen, unless told otherwise. False if there's no GL.
+bool CreateTestWindow(int w, int h)
+{
+    setenv("PANGOLIN_WINDOW_URI", "headless://", 0);
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    pangolin::CreateWindowAndBind("render_cache", w, h);
+    if(!glGetString(GL_VERSION)) {
+        pangolin::DestroyWindow("render_cache");
+        return false;
+    }
+    return true;
+}
+
+pangolin::ManagedImage<unsigned char> TestImage(unsigned char offset)
+{
+    pangolin::ManagedImage<unsigned char> image(64, 48);
+    for(size_t y = 0; y < image.h; ++y) {
+        for(size_t x = 0; x < image.w; ++x) {
+            image(x, y) = (unsigned char)(x * 4 + y + offset);
+        }
+    }
+    return image;
+}
+
+size_t CountRgbDifferences(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+{
+    size_t differences = 0;
+    for(size_t i = 0; i < a.size(); i += 4) {
+        if(a[i] != b[i] || a[i+1] != b[i+1] || a[i+2] != b[i+2]) ++differences;
+    }
+    return differences;
+}
+
+}
+
+TEST_CASE( "Cached ImageView renders the same as uncached" )
+{
+    const int w = 320;
+    const int h = 240;
+    if(!CreateTestWindow(w, h)) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+
+    {
+        const pangolin::ManagedImage<unsigned char> image = TestImage(0);
+
+        // Away from the window origin, so that the cache is rendered offset
+        pangolin::ImageView view("title");
+        view.SetImage(image);
+        view.SetBounds(0.25, 1.0, 0.25, 1.0);
+        pangolin::DisplayBase().AddDisplay(view);
+        pangolin::DisplayBase().Resize(pangolin::Viewport(0, 0, w, h));
+
+        const std::vector<unsigned char> uncached = RenderWindow(w, h);
+
+        view.SetRenderCached(true);
+        const std::vector<unsigned char> first = RenderWindow(w, h);
+        const std::vector<unsigned char> reused = RenderWindow(w, h);
+
+        CHECK(CountRgbDifferences(uncached, first) == 0);
+        CHECK(CountRgbDifferences(uncached, reused) == 0);
+
+        pangolin::DisplayBase().views.clear();
+    }
+
+    pangolin::DestroyWindow("render_cache");
+}
+
+TEST_CASE( "Cached ImageView shows each new image" )
+{
+    const int w = 320;
+    const int h = 240;
+    if(!CreateTestWindow(w, h)) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+
+    {
+        const pangolin::ManagedImage<unsigned char> first = TestImage(0);
+        const pangolin::ManagedImage<unsigned char> second = TestImage(100);
+
+        pangolin::ImageView view;
+        view.SetBounds(0.25, 1.0, 0.25, 1.0);
+        pangolin::DisplayBase().AddDisplay(view);
+        pangolin::DisplayBase().Resize(pangolin::Viewport(0, 0, w, h));
+
+        view.SetImage(second);
+        const std::vector<unsigned char> expected = RenderWindow(w, h);
+
+        view.SetRenderCached(true);
+        view.SetImage(first);
+        RenderWindow(w, h);
+
+        // Uploaded straight away, and delayed until the next render
+        view.SetImage(second);
+        CHECK(CountRgbDifferences(expected, RenderWindow(w, h)) == 0);
+        view.SetImage(first, true);
+        RenderWindow(w, h);
+        view.SetImage(second, true);
+        CHECK(CountRgbDifferences(expected, RenderWindow(w, h)) == 0);
+
+        pangolin::DisplayBase().views.clear();
+    }
+
+    pangolin::DestroyWindow("render_cache");
+}
+
+TEST_CASE( "Cached widget outside a Panel keeps its text" )
+{
+    const int w = 320;
+    const int h = 240;
+    if(!CreateTestWindow(w, h)) {
+        WARN("No OpenGL context available, skipping");
+        return;
+    }
+
+    {
+        pangolin::Var<bool> checked("render_cache.checked", true);
+        pangolin::Checkbox checkbox("checked", checked.Ref());
+        checkbox.SetBounds(0.5, 1.0, 0.25, 1.0);
+        pangolin::DisplayBase().AddDisplay(checkbox);
+        pangolin::DisplayBase().Resize(pangolin::Viewport(0, 0, w, h));
+
+        const std::vector<unsigned char> uncached = RenderWindow(w, h);
+        CHECK(pangolin::default_font().Batch().Empty());
+
+        checkbox.SetRenderCached(true);
+        const std::vector<unsigned char> first = RenderWindow(w, h);
+        const std::vector<unsigned char> reused = RenderWindow(w, h);
+        CHECK(pangolin::default_font().Batch().Empty());
+
+        CHECK(CountRgbDifferences(uncached, first) == 0);
+        CHECK(CountRgbDifferences(uncached, reused) == 0);
+
+        pangolin::DisplayBase().views.clear();
+    }
+
+    pangolin::DestroyWindow("render_cache");
+}
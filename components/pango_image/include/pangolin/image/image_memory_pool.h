@@ -0,0 +1,98 @@
+#pragma once
+
+#include <pangolin/platform.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace pangolin {
+
+// Process-wide cache of aligned image buffers. Released buffers are kept,
+// keyed by their (rounded) size in bytes, and handed back out to the next
+// request of the same size. Since the size of a frame follows from its
+// dimensions and format, pipelines which repeatedly allocate images of the
+// same shape stop hitting the heap once warmed up.
+//
+// Every block is at least Alignment aligned, and blocks of PageBytes or more
+// are page aligned. On Linux, blocks of HugePageBytes or more can optionally
+// be backed by transparent huge pages.
+//
+// Defaults can be overridden with the environment variables
+// PANGOLIN_IMAGE_POOL_MB (memory retained for reuse, 0 to disable caching)
+// and PANGOLIN_IMAGE_POOL_HUGEPAGES=1.
+class PANGOLIN_EXPORT ImageMemoryPool
+{
+public:
+    static constexpr size_t Alignment = 64;
+    static constexpr size_t PageBytes = 4096;
+    static constexpr size_t HugePageBytes = 2 * 1024 * 1024;
+
+    struct Stats
+    {
+        size_t bytes_in_use;
+        size_t bytes_cached;
+        size_t allocations;
+        size_t reuses;
+    };
+
+    static ImageMemoryPool& Instance();
+
+    // Throws std::bad_alloc on failure
+    void* Allocate(size_t bytes);
+
+    // Return a block to the pool. Pointers which didn't come from the pool
+    // have no known way to be freed, so are reported and left alone.
+    void Deallocate(void* ptr);
+
+    void SetMaxCachedBytes(size_t bytes);
+    size_t MaxCachedBytes() const;
+
+    void SetUseHugePages(bool enable);
+    bool UseHugePages() const;
+
+    // Free all cached blocks not currently in use
+    void Trim();
+
+    Stats GetStats() const;
+
+private:
+    struct Impl;
+
+    ImageMemoryPool();
+    ImageMemoryPool(const ImageMemoryPool&) = delete;
+    ~ImageMemoryPool();
+
+    std::unique_ptr<Impl> impl;
+};
+
+// Stateless allocator drawing from ImageMemoryPool::Instance()
+template<typename T>
+struct PooledImageAllocator
+{
+    typedef T value_type;
+
+    PooledImageAllocator() {}
+
+    template<typename U>
+    PooledImageAllocator(const PooledImageAllocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(ImageMemoryPool::Instance().Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t /*n*/)
+    {
+        ImageMemoryPool::Instance().Deallocate(p);
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const PooledImageAllocator<T>&, const PooledImageAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+inline bool operator!=(const PooledImageAllocator<T>&, const PooledImageAllocator<U>&) { return false; }
+
+template<class T> using DefaultImageAllocator = PooledImageAllocator<T>;
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <pangolin/image/image.h>
+
+#include <utility>
+#include <vector>
+
+namespace pangolin
+{
+
+struct PANGOLIN_EXPORT ImageChannelStats
+{
+    float min;
+    float max;
+    double mean;
+    double stddev;
+
+    // Number of samples contributing, which excludes non-finite values
+    size_t count;
+};
+
+// Statistics of an image with interleaved channels. The histogram, and hence
+// MinMax() and Percentile(), consider only colour channels, ignoring alpha.
+struct PANGOLIN_EXPORT ImageStats
+{
+    std::vector<ImageChannelStats> channels;
+
+    // Histogram over [hist_min, hist_max] with equally sized bins
+    float hist_min;
+    float hist_max;
+    std::vector<size_t> histogram;
+
+    std::pair<float,float> MinMax() const;
+
+    // Value below which fraction (in [0,1]) of colour samples lie,
+    // interpolated within histogram bins.
+    float Percentile(float fraction) const;
+};
+
+// Compute per-channel min / max, mean and standard deviation, and optionally a
+// histogram of colour channels. Only every row_step'th row is sampled, which
+// suits continuously updated estimates. Large images are split across
+// num_threads (0 to choose automatically) from a shared pool.
+// Implemented for unsigned char, unsigned short, float and double.
+template<typename T>
+PANGOLIN_EXPORT ImageStats ComputeImageStats(
+    const Image<T>& img, size_t channels,
+    size_t histogram_bins = 0, size_t row_step = 1, size_t num_threads = 0
+);
+
+// Values below which fractions low and high of colour samples lie. The bin
+// of a histogram holding each is histogrammed again in further passes, so a
+// few distant outliers don't cost precision.
+template<typename T>
+PANGOLIN_EXPORT std::pair<float,float> ComputeImagePercentileRange(
+    const Image<T>& img, size_t channels, float low, float high,
+    size_t histogram_bins, size_t row_step = 1, size_t num_threads = 0
+);
+
+// Min / max of colour channels only, which is considerably cheaper than
+// ComputeImageStats.
+template<typename T>
+PANGOLIN_EXPORT std::pair<float,float> ComputeImageMinMax(
+    const Image<T>& img, size_t channels, size_t num_threads = 0
+);
+
+}
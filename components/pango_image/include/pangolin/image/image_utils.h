@@ -31,6 +31,7 @@
 #include <utility>
 
 #include <pangolin/image/image.h>
+#include <pangolin/image/image_stats.h>
 #include <pangolin/utils/range.h>
 #include <pangolin/gl/gl.h>
 #include <pangolin/gl/glpixformat.h>
@@ -44,41 +45,22 @@ namespace internal
 template <typename T>
 std::pair<float, float> GetMinMax(const Image<T>& img, size_t channels)
 {
-    const size_t max_channels = 3;
-    const size_t colour_channels = std::min(channels, max_channels);
-    std::pair<float, float> chan_mm[max_channels];
-    for(size_t c = 0; c < max_channels; ++c)
-    {
-        chan_mm[c].first = +std::numeric_limits<float>::max();
-        chan_mm[c].second = -std::numeric_limits<float>::max();
-    }
-
-    for(size_t y = 0; y < img.h; ++y)
-    {
-        T* pix = (T*)((char*)img.ptr + y * img.pitch);
-        for(size_t x = 0; x < img.w; ++x)
-        {
-            for(size_t c = 0; c < colour_channels; ++c)
-            {
-                if(pix[c] < chan_mm[c].first)
-                    chan_mm[c].first = (float)pix[c];
-                if(pix[c] > chan_mm[c].second)
-                    chan_mm[c].second = (float)pix[c];
-            }
-
-            pix += channels;
-        }
-    }
-
     // Find min / max of all channels, ignoring 4th alpha channel
-    std::pair<float, float> mm = chan_mm[0];
-    for(size_t c = 1; c < colour_channels; ++c)
-    {
-        mm.first = std::min(mm.first, chan_mm[c].first);
-        mm.second = std::max(mm.second, chan_mm[c].second);
-    }
+    return ComputeImageMinMax<T>(img, channels);
+}
 
-    return mm;
+inline std::pair<float,float> OffsetScaleForRange(const std::pair<float,float>& mm, float type_max, float format_max)
+{
+    const float type_scale = format_max / type_max;
+    const float offset = -type_scale* mm.first;
+    const float scale = type_max / (mm.second - mm.first);
+    return std::pair<float,float>(offset, scale);
+}
+
+template<typename T>
+std::pair<float,float> GetPercentileRange(const Image<T>& img, size_t channels, size_t bins, float low, float high, size_t row_step)
+{
+    return ComputeImagePercentileRange<T>(img, channels, low, high, bins, row_step);
 }
 
 template<typename T>
@@ -96,10 +78,7 @@ std::pair<float,float> GetOffsetScale(const pangolin::Image<T>& img, size_t chan
 {
     // Find min / max of all channels, ignoring 4th alpha channel
     const std::pair<float,float> mm = internal::GetMinMax<T>(img,channels);
-    const float type_scale = format_max / type_max;
-    const float offset = -type_scale* mm.first;
-    const float scale = type_max / (mm.second - mm.first);
-    return std::pair<float,float>(offset, scale);
+    return OffsetScaleForRange(mm, type_max, format_max);
 }
 
 template<typename T>
@@ -182,4 +161,47 @@ inline float GetScaleOnly(
     }
 }
 
+// Range excluding the lowest low and highest (1-high) fraction of colour
+// samples, which unlike min / max isn't thrown off by a few outliers. Only
+// every row_step'th row is sampled.
+inline std::pair<float, float> GetPercentileRange(
+    const Image<unsigned char>& img,
+    XYRangei iroi, const GlPixFormat& glfmt,
+    float low, float high, size_t row_step = 1
+) {
+    using namespace internal;
+
+    iroi.Clamp(0, (int)img.w - 1, 0, (int)img.h - 1);
+
+    const size_t num_channels = pangolin::GlFormatChannels(glfmt.glformat);
+    const size_t bins = 4096;
+
+    if(glfmt.gltype == GL_UNSIGNED_BYTE) {
+        return GetPercentileRange(GetImageRoi(img.template UnsafeReinterpret<unsigned char>(), num_channels, iroi), num_channels, 256, low, high, row_step);
+    } else if(glfmt.gltype == GL_UNSIGNED_SHORT) {
+        return GetPercentileRange(GetImageRoi(img.template UnsafeReinterpret<unsigned short>(), num_channels, iroi), num_channels, bins, low, high, row_step);
+    } else if(glfmt.gltype == GL_FLOAT) {
+        return GetPercentileRange(GetImageRoi(img.template UnsafeReinterpret<float>(), num_channels, iroi), num_channels, bins, low, high, row_step);
+    } else if(glfmt.gltype == GL_DOUBLE) {
+        return GetPercentileRange(GetImageRoi(img.template UnsafeReinterpret<double>(), num_channels, iroi), num_channels, bins, low, high, row_step);
+    } else {
+        return std::pair<float, float>(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    }
+}
+
+// Offset and scale mapping range to [0,1] for an image of format glfmt
+inline std::pair<float,float> GetOffsetScale(
+    const std::pair<float,float>& range, const pangolin::GlPixFormat& glfmt
+) {
+    if(glfmt.gltype == GL_UNSIGNED_BYTE) {
+        return internal::OffsetScaleForRange(range, 255.0f, 1.0f);
+    }else if(glfmt.gltype == GL_UNSIGNED_SHORT) {
+        return internal::OffsetScaleForRange(range, 65535.0f, 1.0f);
+    }else if(glfmt.gltype == GL_FLOAT || glfmt.gltype == GL_DOUBLE) {
+        return internal::OffsetScaleForRange(range, 1.0f, 1.0f);
+    }else{
+        return std::pair<float,float>(0.0f, 1.0f);
+    }
+}
+
 }
@@ -29,11 +29,10 @@
 
 #include <pangolin/image/image.h>
 #include <pangolin/image/copy.h>
+#include <pangolin/image/image_memory_pool.h>
 
 namespace pangolin {
 
-template<class T> using DefaultImageAllocator = std::allocator<T>;
-
 // Image that manages it's own memory, storing a strong pointer to it's memory
 template<typename T, class Allocator = DefaultImageAllocator<T> >
 class ManagedImage : public Image<T>
@@ -158,10 +158,12 @@ void pango_jpeg_set_dest_mgr(j_compress_ptr cinfo, std::ostream& os) {
 
 #endif // HAVE_JPEG
 
-TypedImage LoadJpg(std::istream& is) {
 #ifdef HAVE_JPEG
-    TypedImage image;
 
+// Decode the jpeg in is into the image returned by get_image(width, height, fmt),
+// a scanline at a time without an intermediate copy.
+template<typename GetImage>
+void DecodeJpg(std::istream& is, GetImage get_image) {
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
 
@@ -169,32 +171,45 @@ TypedImage LoadJpg(std::istream& is) {
     cinfo.err = jpeg_std_error(&jerr);
     jerr.error_exit = error_handler;
     jpeg_create_decompress(&cinfo);
-    pango_jpeg_set_source_mgr(&cinfo, is);
 
-    // read info from header.
-    int r = jpeg_read_header(&cinfo, TRUE);
-    if (r != JPEG_HEADER_OK) {
-        throw std::runtime_error("Failed to read JPEG header.");
-    } else if (cinfo.num_components != 3 && cinfo.num_components != 1) {
-        throw std::runtime_error("Unsupported number of color components");
-    } else {
+    try {
+        pango_jpeg_set_source_mgr(&cinfo, is);
+
+        // read info from header.
+        int r = jpeg_read_header(&cinfo, TRUE);
+        if (r != JPEG_HEADER_OK) {
+            throw std::runtime_error("Failed to read JPEG header.");
+        } else if (cinfo.num_components != 3 && cinfo.num_components != 1) {
+            throw std::runtime_error("Unsupported number of color components");
+        }
+
         jpeg_start_decompress(&cinfo);
-        // resize storage if necessary
-        PixelFormat fmt = PixelFormatFromString(cinfo.output_components == 3 ? "RGB24" : "GRAY8");
-        image.Reinitialise(cinfo.output_width, cinfo.output_height, fmt);
-        JSAMPARRAY imageBuffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE,
-                                                            cinfo.output_width*cinfo.output_components, 1);
+        const PixelFormat fmt = PixelFormatFromString(cinfo.output_components == 3 ? "RGB24" : "GRAY8");
+        Image<unsigned char> image = get_image(cinfo.output_width, cinfo.output_height, fmt);
         for (size_t y = 0; y < cinfo.output_height; y++) {
-            jpeg_read_scanlines(&cinfo, imageBuffer, 1);
-            uint8_t* dstRow = (uint8_t*)image.RowPtr(y);
-            memcpy(dstRow, imageBuffer[0], cinfo.output_width*cinfo.output_components);
+            JSAMPROW row = image.RowPtr(y);
+            jpeg_read_scanlines(&cinfo, &row, 1);
         }
         jpeg_finish_decompress(&cinfo);
+    } catch (...) {
+        jpeg_destroy_decompress(&cinfo);
+        throw;
     }
 
     // clean up.
     jpeg_destroy_decompress(&cinfo);
+}
 
+#endif // HAVE_JPEG
+
+TypedImage LoadJpg(std::istream& is) {
+#ifdef HAVE_JPEG
+    TypedImage image;
+    DecodeJpg(is, [&image](size_t w, size_t h, const PixelFormat& fmt) {
+        // resize storage if necessary
+        image.Reinitialise(w, h, fmt);
+        return Image<unsigned char>(image.ptr, image.w, image.h, image.pitch);
+    });
     return image;
 #else
     PANGOLIN_UNUSED(is);
@@ -203,6 +218,22 @@ TypedImage LoadJpg(std::istream& is) {
 
 }
 
+void LoadJpg(std::istream& is, Image<unsigned char>& image, const PixelFormat& fmt) {
+#ifdef HAVE_JPEG
+    DecodeJpg(is, [&image, &fmt](size_t w, size_t h, const PixelFormat& jpeg_fmt) {
+        if (w != image.w || h != image.h || jpeg_fmt.format != fmt.format) {
+            throw std::runtime_error("JPEG doesn't match the image it is being decoded into.");
+        }
+        return image;
+    });
+#else
+    PANGOLIN_UNUSED(is);
+    PANGOLIN_UNUSED(image);
+    PANGOLIN_UNUSED(fmt);
+    throw std::runtime_error("Rebuild Pangolin for JPEG support.");
+#endif // HAVE_JPEG
+}
+
 std::vector<std::streampos> GetMJpegOffsets([[maybe_unused]] std::ifstream& is) {
     std::vector<std::streampos> offsets;
 
@@ -0,0 +1,215 @@
+#include <pangolin/image/image_memory_pool.h>
+#include <pangolin/utils/log.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN_
+#  include <malloc.h>
+#else
+#  include <stdlib.h>
+#endif
+
+#ifdef _LINUX_
+#  include <sys/mman.h>
+#endif
+
+namespace pangolin {
+
+namespace {
+
+size_t RoundUp(size_t bytes, size_t multiple)
+{
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+size_t BlockBytes(size_t bytes)
+{
+    bytes = std::max<size_t>(bytes, 1);
+    return RoundUp(bytes, bytes >= ImageMemoryPool::PageBytes ? ImageMemoryPool::PageBytes : ImageMemoryPool::Alignment);
+}
+
+void* AllocateBlock(size_t bytes, bool huge_pages)
+{
+    const bool huge = huge_pages && bytes >= ImageMemoryPool::HugePageBytes;
+    const size_t alignment = huge ? ImageMemoryPool::HugePageBytes :
+        bytes >= ImageMemoryPool::PageBytes ? ImageMemoryPool::PageBytes : ImageMemoryPool::Alignment;
+
+    void* ptr = nullptr;
+#ifdef _WIN_
+    ptr = _aligned_malloc(bytes, alignment);
+#else
+    if(posix_memalign(&ptr, alignment, bytes) != 0) ptr = nullptr;
+#endif
+    if(!ptr) throw std::bad_alloc();
+
+#if defined(_LINUX_) && defined(MADV_HUGEPAGE)
+    // Advisory only, so failure (e.g. THP disabled) is harmless
+    if(huge) madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+    return ptr;
+}
+
+void FreeBlock(void* ptr)
+{
+#ifdef _WIN_
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+}
+
+struct ImageMemoryPool::Impl
+{
+    void TrimTo(size_t max_bytes);
+
+    mutable std::mutex mutex;
+    std::unordered_map<size_t, std::vector<void*>> cached;
+    std::unordered_map<void*, size_t> in_use;
+    size_t max_cached_bytes = 256 * 1024 * 1024;
+    bool use_huge_pages = false;
+    Stats stats = {0,0,0,0};
+};
+
+ImageMemoryPool& ImageMemoryPool::Instance()
+{
+    // Never destroyed, so that images with static storage duration can still
+    // be released safely during exit.
+    static ImageMemoryPool* pool = new ImageMemoryPool();
+    return *pool;
+}
+
+ImageMemoryPool::ImageMemoryPool()
+    : impl(new Impl)
+{
+    if(const char* env = std::getenv("PANGOLIN_IMAGE_POOL_MB")) {
+        impl->max_cached_bytes = std::strtoull(env, nullptr, 10) * 1024 * 1024;
+    }
+    if(const char* env = std::getenv("PANGOLIN_IMAGE_POOL_HUGEPAGES")) {
+        impl->use_huge_pages = std::atoi(env) != 0;
+    }
+}
+
+ImageMemoryPool::~ImageMemoryPool()
+{
+}
+
+void* ImageMemoryPool::Allocate(size_t bytes)
+{
+    const size_t block_bytes = BlockBytes(bytes);
+    void* ptr = nullptr;
+    bool huge_pages;
+
+    {
+        std::lock_guard<std::mutex> l(impl->mutex);
+        auto it = impl->cached.find(block_bytes);
+        if(it != impl->cached.end() && !it->second.empty()) {
+            ptr = it->second.back();
+            it->second.pop_back();
+            impl->stats.bytes_cached -= block_bytes;
+            ++impl->stats.reuses;
+        }
+        huge_pages = impl->use_huge_pages;
+    }
+
+    if(!ptr) {
+        ptr = AllocateBlock(block_bytes, huge_pages);
+    }
+
+    std::lock_guard<std::mutex> l(impl->mutex);
+    impl->in_use[ptr] = block_bytes;
+    impl->stats.bytes_in_use += block_bytes;
+    ++impl->stats.allocations;
+    return ptr;
+}
+
+void ImageMemoryPool::Deallocate(void* ptr)
+{
+    if(!ptr) return;
+
+    std::unique_lock<std::mutex> l(impl->mutex);
+    auto it = impl->in_use.find(ptr);
+    if(it == impl->in_use.end()) {
+        // Freeing with the wrong deallocator would corrupt the heap, so leak
+        l.unlock();
+        pango_print_warn("ImageMemoryPool: ignoring %p, which wasn't allocated by the pool.\n", ptr);
+        return;
+    }
+
+    const size_t block_bytes = it->second;
+    impl->in_use.erase(it);
+    impl->stats.bytes_in_use -= block_bytes;
+
+    if(impl->stats.bytes_cached + block_bytes <= impl->max_cached_bytes) {
+        impl->cached[block_bytes].push_back(ptr);
+        impl->stats.bytes_cached += block_bytes;
+    }else{
+        l.unlock();
+        FreeBlock(ptr);
+    }
+}
+
+void ImageMemoryPool::SetMaxCachedBytes(size_t bytes)
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    impl->max_cached_bytes = bytes;
+    impl->TrimTo(impl->max_cached_bytes);
+}
+
+size_t ImageMemoryPool::MaxCachedBytes() const
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    return impl->max_cached_bytes;
+}
+
+void ImageMemoryPool::SetUseHugePages(bool enable)
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    impl->use_huge_pages = enable;
+}
+
+bool ImageMemoryPool::UseHugePages() const
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    return impl->use_huge_pages;
+}
+
+void ImageMemoryPool::Trim()
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    impl->TrimTo(0);
+}
+
+ImageMemoryPool::Stats ImageMemoryPool::GetStats() const
+{
+    std::lock_guard<std::mutex> l(impl->mutex);
+    return impl->stats;
+}
+
+void ImageMemoryPool::Impl::TrimTo(size_t max_bytes)
+{
+    // Release the largest blocks first, which free the most for the fewest
+    // future misses.
+    while(stats.bytes_cached > max_bytes) {
+        auto largest = cached.end();
+        for(auto it = cached.begin(); it != cached.end(); ++it) {
+            if(!it->second.empty() && (largest == cached.end() || it->first > largest->first)) {
+                largest = it;
+            }
+        }
+        if(largest == cached.end()) break;
+
+        FreeBlock(largest->second.back());
+        largest->second.pop_back();
+        stats.bytes_cached -= largest->first;
+        if(largest->second.empty()) cached.erase(largest);
+    }
+}
+
+}
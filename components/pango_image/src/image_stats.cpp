@@ -0,0 +1,597 @@
+#include <pangolin/image/image_stats.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace pangolin
+{
+
+namespace
+{
+
+// Below this many samples, threads cost more than they save
+constexpr size_t MinSamplesPerThread = 1 << 19;
+
+constexpr size_t MaxColourChannels = 3;
+
+template<typename T>
+inline bool IsFiniteValue(T) { return true; }
+inline bool IsFiniteValue(float v) { return std::isfinite(v); }
+inline bool IsFiniteValue(double v) { return std::isfinite(v); }
+
+#ifdef __SSE2__
+template<typename T> struct Simd;
+
+template<> struct Simd<unsigned char>
+{
+    using V = __m128i;
+    static constexpr size_t Lanes = 16;
+    static V Load(const unsigned char* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static void Store(unsigned char* p, V v) { _mm_storeu_si128((__m128i*)p, v); }
+    static V Min(V a, V b) { return _mm_min_epu8(a, b); }
+    static V Max(V a, V b) { return _mm_max_epu8(a, b); }
+};
+
+// SSE2 only has signed 16 bit min / max, so shift values into signed range
+template<> struct Simd<unsigned short>
+{
+    using V = __m128i;
+    static constexpr size_t Lanes = 8;
+    static V Bias() { return _mm_set1_epi16((short)0x8000); }
+    static V Load(const unsigned short* p) { return _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), Bias()); }
+    static void Store(unsigned short* p, V v) { _mm_storeu_si128((__m128i*)p, _mm_xor_si128(v, Bias())); }
+    static V Min(V a, V b) { return _mm_min_epi16(a, b); }
+    static V Max(V a, V b) { return _mm_max_epi16(a, b); }
+};
+
+// Non-finite values (NaN and +/-inf) are replaced by the identity of the
+// comparison, so that they're ignored as in the scalar code.
+template<> struct Simd<float>
+{
+    using V = __m128;
+    static constexpr size_t Lanes = 4;
+    static V Load(const float* p) { return _mm_loadu_ps(p); }
+    static void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V Finite(V v, V otherwise) {
+        const V finite = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), v), _mm_set1_ps(std::numeric_limits<float>::infinity()));
+        return _mm_or_ps(_mm_and_ps(finite, v), _mm_andnot_ps(finite, otherwise));
+    }
+    static V Min(V a, V b) { return _mm_min_ps(Finite(a, _mm_set1_ps(std::numeric_limits<float>::max())), b); }
+    static V Max(V a, V b) { return _mm_max_ps(Finite(a, _mm_set1_ps(std::numeric_limits<float>::lowest())), b); }
+};
+
+template<> struct Simd<double>
+{
+    using V = __m128d;
+    static constexpr size_t Lanes = 2;
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V Finite(V v, V otherwise) {
+        const V finite = _mm_cmplt_pd(_mm_andnot_pd(_mm_set1_pd(-0.0), v), _mm_set1_pd(std::numeric_limits<double>::infinity()));
+        return _mm_or_pd(_mm_and_pd(finite, v), _mm_andnot_pd(finite, otherwise));
+    }
+    static V Min(V a, V b) { return _mm_min_pd(Finite(a, _mm_set1_pd(std::numeric_limits<double>::max())), b); }
+    static V Max(V a, V b) { return _mm_max_pd(Finite(a, _mm_set1_pd(std::numeric_limits<double>::lowest())), b); }
+};
+#endif
+
+// Update per-channel min / max (mn, mx) with n interleaved values of C channels
+template<typename T, size_t C>
+void RowMinMax(const T* row, size_t n, T* mn, T* mx)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    // A block of C vectors holds a whole number of pixels, so each lane of
+    // the k'th vector in a block always sees the same channel.
+    using S = Simd<T>;
+    constexpr size_t block = S::Lanes * C;
+    if(n >= block) {
+        T lanes[block];
+        typename S::V vmin[C], vmax[C];
+
+        for(size_t j=0; j < block; ++j) lanes[j] = mn[j % C];
+        for(size_t k=0; k < C; ++k) vmin[k] = S::Load(lanes + k*S::Lanes);
+        for(size_t j=0; j < block; ++j) lanes[j] = mx[j % C];
+        for(size_t k=0; k < C; ++k) vmax[k] = S::Load(lanes + k*S::Lanes);
+
+        for(; i + block <= n; i += block) {
+            for(size_t k=0; k < C; ++k) {
+                const typename S::V v = S::Load(row + i + k*S::Lanes);
+                vmin[k] = S::Min(v, vmin[k]);
+                vmax[k] = S::Max(v, vmax[k]);
+            }
+        }
+
+        for(size_t k=0; k < C; ++k) S::Store(lanes + k*S::Lanes, vmin[k]);
+        for(size_t j=0; j < block; ++j) mn[j % C] = std::min(mn[j % C], lanes[j]);
+        for(size_t k=0; k < C; ++k) S::Store(lanes + k*S::Lanes, vmax[k]);
+        for(size_t j=0; j < block; ++j) mx[j % C] = std::max(mx[j % C], lanes[j]);
+    }
+#endif
+
+    for(; i < n; i += C) {
+        for(size_t c=0; c < C; ++c) {
+            const T v = row[i + c];
+            if(IsFiniteValue(v)) {
+                if(v < mn[c]) mn[c] = v;
+                if(v > mx[c]) mx[c] = v;
+            }
+        }
+    }
+}
+
+template<typename T>
+void RowMinMax(const T* row, size_t n, size_t channels, T* mn, T* mx)
+{
+    switch(channels) {
+    case 1: RowMinMax<T,1>(row, n, mn, mx); break;
+    case 2: RowMinMax<T,2>(row, n, mn, mx); break;
+    case 3: RowMinMax<T,3>(row, n, mn, mx); break;
+    case 4: RowMinMax<T,4>(row, n, mn, mx); break;
+    default:
+        for(size_t i=0; i < n; ++i) {
+            const size_t c = i % channels;
+            if(IsFiniteValue(row[i])) {
+                if(row[i] < mn[c]) mn[c] = row[i];
+                if(row[i] > mx[c]) mx[c] = row[i];
+            }
+        }
+    }
+}
+
+// Integer samples are summed exactly, and much faster than as doubles
+template<typename T> struct SumType { using type = double; };
+template<> struct SumType<unsigned char> { using type = uint64_t; };
+template<> struct SumType<unsigned short> { using type = uint64_t; };
+
+// Accumulate per-channel sum, sum of squares and count of finite values
+template<typename T, size_t C>
+void RowSums(const T* row, size_t n, double* sum, double* sum_sq, size_t* count)
+{
+    using S = typename SumType<T>::type;
+    S s[C] = {};
+    S s2[C] = {};
+    size_t k[C] = {};
+
+    for(size_t i=0; i < n; i += C) {
+        for(size_t c=0; c < C; ++c) {
+            const T v = row[i + c];
+            if(IsFiniteValue(v)) {
+                s[c] += v;
+                s2[c] += (S)v * v;
+                ++k[c];
+            }
+        }
+    }
+
+    for(size_t c=0; c < C; ++c) {
+        sum[c] += s[c];
+        sum_sq[c] += s2[c];
+        count[c] += k[c];
+    }
+}
+
+template<typename T>
+void RowSums(const T* row, size_t n, size_t channels, double* sum, double* sum_sq, size_t* count)
+{
+    switch(channels) {
+    case 1: RowSums<T,1>(row, n, sum, sum_sq, count); break;
+    case 2: RowSums<T,2>(row, n, sum, sum_sq, count); break;
+    case 3: RowSums<T,3>(row, n, sum, sum_sq, count); break;
+    case 4: RowSums<T,4>(row, n, sum, sum_sq, count); break;
+    default:
+        for(size_t i=0; i < n; ++i) {
+            const size_t c = i % channels;
+            if(IsFiniteValue(row[i])) {
+                sum[c] += row[i];
+                sum_sq[c] += (double)row[i] * row[i];
+                ++count[c];
+            }
+        }
+    }
+}
+
+// Partial per-channel results for a range of rows
+template<typename T>
+struct Accumulator
+{
+    Accumulator(size_t channels)
+        : min(channels, std::numeric_limits<T>::max()),
+          max(channels, std::numeric_limits<T>::lowest()),
+          sum(channels, 0.0), sum_sq(channels, 0.0), count(channels, 0)
+    {
+    }
+
+    void Merge(const Accumulator& o)
+    {
+        for(size_t c=0; c < min.size(); ++c) {
+            min[c] = std::min(min[c], o.min[c]);
+            max[c] = std::max(max[c], o.max[c]);
+            sum[c] += o.sum[c];
+            sum_sq[c] += o.sum_sq[c];
+            count[c] += o.count[c];
+        }
+    }
+
+    std::vector<T> min;
+    std::vector<T> max;
+    std::vector<double> sum;
+    std::vector<double> sum_sq;
+    std::vector<size_t> count;
+};
+
+// Maps values to bins of a histogram over [lo, lo + bins/scale]
+struct HistogramBins
+{
+    HistogramBins(float lo, float hi, size_t bins)
+        : lo(lo), scale(hi > lo ? bins / (hi - lo) : 0.0f), last(bins - 1)
+    {
+    }
+
+    // Position in units of bins, from the start of the first
+    float Position(float v) const { return (v - lo) * scale; }
+    size_t Bin(float x) const { return x > 0.0f ? std::min(last, (size_t)x) : 0; }
+
+    float lo;
+    float scale;
+    size_t last;
+};
+
+size_t ChooseThreads(size_t num_threads, size_t samples, size_t rows)
+{
+    if(num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), samples / MinSamplesPerThread));
+    }
+    return std::max<size_t>(1, std::min(num_threads, rows));
+}
+
+// Threads kept for the lifetime of the process, so that per-frame statistics
+// don't pay to start threads each call.
+class WorkerPool
+{
+public:
+    // Never destroyed, so that workers can't outlive it at exit
+    static WorkerPool& I()
+    {
+        static WorkerPool* pool = new WorkerPool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return *pool;
+    }
+
+    // Call task(t) for t in [0,num_tasks), with the caller as one of the
+    // workers. Runs on the caller alone if another thread is using the pool.
+    void Run(size_t num_tasks, const std::function<void(size_t)>& task)
+    {
+        std::unique_lock<std::mutex> run_lock(run_mutex, std::try_to_lock);
+        if(!run_lock || workers.empty()) {
+            for(size_t t=0; t < num_tasks; ++t) task(t);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            job_size = num_tasks;
+            next_task = 0;
+            busy_workers = workers.size();
+            ++generation;
+        }
+        start.notify_all();
+
+        Work(task, num_tasks);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this](){ return busy_workers == 0; });
+        job = nullptr;
+    }
+
+private:
+    explicit WorkerPool(size_t num_workers)
+        : job(nullptr), job_size(0), next_task(0), busy_workers(0), generation(0)
+    {
+        for(size_t i=0; i < num_workers; ++i) {
+            workers.emplace_back([this](){ WorkerLoop(); });
+        }
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+            start.wait(lock, [&](){ return generation != seen; });
+            seen = generation;
+            const std::function<void(size_t)>& task = *job;
+            const size_t num_tasks = job_size;
+            lock.unlock();
+
+            Work(task, num_tasks);
+
+            lock.lock();
+            if(--busy_workers == 0) done.notify_one();
+        }
+    }
+
+    void Work(const std::function<void(size_t)>& task, size_t num_tasks)
+    {
+        for(size_t t = next_task++; t < num_tasks; t = next_task++) {
+            task(t);
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job;
+    size_t job_size;
+    std::atomic<size_t> next_task;
+    size_t busy_workers;
+    uint64_t generation;
+};
+
+// Call f(y_begin, y_end, part) over num_threads contiguous ranges of rows
+template<typename F>
+void ParallelRows(size_t rows, size_t num_threads, F f)
+{
+    if(num_threads <= 1) {
+        f(0, rows, 0);
+        return;
+    }
+
+    WorkerPool::I().Run(num_threads, [&](size_t t) {
+        f(rows * t / num_threads, rows * (t+1) / num_threads, t);
+    });
+}
+
+} // namespace
+
+std::pair<float,float> ImageStats::MinMax() const
+{
+    std::pair<float,float> mm(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    for(size_t c=0; c < std::min(channels.size(), MaxColourChannels); ++c) {
+        mm.first = std::min(mm.first, channels[c].min);
+        mm.second = std::max(mm.second, channels[c].max);
+    }
+    return mm;
+}
+
+float ImageStats::Percentile(float fraction) const
+{
+    size_t total = 0;
+    for(size_t n : histogram) total += n;
+    if(!total) return MinMax().first;
+
+    const float bin_width = (hist_max - hist_min) / histogram.size();
+    const double target = std::min(1.0f, std::max(0.0f, fraction)) * total;
+
+    double cumulative = 0.0;
+    for(size_t b=0; b < histogram.size(); ++b) {
+        if(histogram[b] && cumulative + histogram[b] >= target) {
+            const double within = (target - cumulative) / histogram[b];
+            return hist_min + bin_width * (float)(b + within);
+        }
+        cumulative += histogram[b];
+    }
+    return hist_max;
+}
+
+template<typename T>
+ImageStats ComputeImageStats(const Image<T>& img, size_t channels, size_t histogram_bins, size_t row_step, size_t num_threads)
+{
+    row_step = std::max<size_t>(1, row_step);
+    const size_t rows = (img.h + row_step - 1) / row_step;
+    const size_t n = img.w * channels;
+    const size_t colour_channels = std::min(channels, MaxColourChannels);
+    num_threads = ChooseThreads(num_threads, rows * n, rows);
+
+    std::vector<Accumulator<T>> partial(num_threads, Accumulator<T>(channels));
+    ParallelRows(rows, num_threads, [&](size_t r0, size_t r1, size_t t) {
+        Accumulator<T>& acc = partial[t];
+        for(size_t r=r0; r < r1; ++r) {
+            const T* row = img.RowPtr(r * row_step);
+            RowMinMax(row, n, channels, acc.min.data(), acc.max.data());
+            RowSums(row, n, channels, acc.sum.data(), acc.sum_sq.data(), acc.count.data());
+        }
+    });
+
+    for(size_t t=1; t < num_threads; ++t) {
+        partial[0].Merge(partial[t]);
+    }
+    const Accumulator<T>& acc = partial[0];
+
+    ImageStats stats;
+    stats.channels.resize(channels);
+    for(size_t c=0; c < channels; ++c) {
+        ImageChannelStats& cs = stats.channels[c];
+        cs.min = (float)acc.min[c];
+        cs.max = (float)acc.max[c];
+        cs.count = acc.count[c];
+        cs.mean = cs.count ? acc.sum[c] / cs.count : 0.0;
+        cs.stddev = cs.count ? std::sqrt(std::max(0.0, acc.sum_sq[c] / cs.count - cs.mean * cs.mean)) : 0.0;
+    }
+
+    const std::pair<float,float> mm = stats.MinMax();
+    stats.hist_min = std::isfinite(mm.first) ? mm.first : 0.0f;
+    stats.hist_max = std::isfinite(mm.second) ? mm.second : 0.0f;
+
+    if(histogram_bins && stats.hist_min <= stats.hist_max) {
+        const HistogramBins bins(stats.hist_min, stats.hist_max, histogram_bins);
+
+        std::vector<std::vector<size_t>> hists(num_threads, std::vector<size_t>(histogram_bins, 0));
+        ParallelRows(rows, num_threads, [&](size_t r0, size_t r1, size_t t) {
+            size_t* hist = hists[t].data();
+            for(size_t r=r0; r < r1; ++r) {
+                const T* row = img.RowPtr(r * row_step);
+                for(size_t i=0; i < n; i += channels) {
+                    for(size_t c=0; c < colour_channels; ++c) {
+                        const T v = row[i + c];
+                        if(IsFiniteValue(v)) {
+                            ++hist[bins.Bin(bins.Position((float)v))];
+                        }
+                    }
+                }
+            }
+        });
+
+        stats.histogram.swap(hists[0]);
+        for(size_t t=1; t < num_threads; ++t) {
+            for(size_t b=0; b < histogram_bins; ++b) {
+                stats.histogram[b] += hists[t][b];
+            }
+        }
+    }
+
+    return stats;
+}
+
+template<typename T>
+std::pair<float,float> ComputeImageMinMax(const Image<T>& img, size_t channels, size_t num_threads)
+{
+    const size_t n = img.w * channels;
+    num_threads = ChooseThreads(num_threads, img.h * n, img.h);
+
+    std::vector<Accumulator<T>> partial(num_threads, Accumulator<T>(channels));
+    ParallelRows(img.h, num_threads, [&](size_t r0, size_t r1, size_t t) {
+        for(size_t r=r0; r < r1; ++r) {
+            RowMinMax(img.RowPtr(r), n, channels, partial[t].min.data(), partial[t].max.data());
+        }
+    });
+
+    // Combine all colour channels, ignoring 4th alpha channel
+    std::pair<float,float> mm(std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+    for(const Accumulator<T>& acc : partial) {
+        for(size_t c=0; c < std::min(channels, MaxColourChannels); ++c) {
+            if(acc.min[c] <= acc.max[c]) {
+                mm.first = std::min(mm.first, (float)acc.min[c]);
+                mm.second = std::max(mm.second, (float)acc.max[c]);
+            }
+        }
+    }
+    return mm;
+}
+
+template<typename T>
+std::pair<float,float> ComputeImagePercentileRange(const Image<T>& img, size_t channels, float low, float high, size_t histogram_bins, size_t row_step, size_t num_threads)
+{
+    const ImageStats stats = ComputeImageStats<T>(img, channels, histogram_bins, row_step, num_threads);
+    std::pair<float,float> range(stats.Percentile(low), stats.Percentile(high));
+    if(!histogram_bins || !(stats.hist_min < stats.hist_max)) {
+        return range;
+    }
+
+    // Interval of values holding each percentile, and its rank within them
+    struct Selection
+    {
+        double lo;
+        double hi;
+        bool include_hi;
+        double rank;
+    } selection[2];
+
+    size_t total = 0;
+    for(size_t n : stats.histogram) total += n;
+    const double bin_width = ((double)stats.hist_max - stats.hist_min) / histogram_bins;
+    const float fractions[2] = {low, high};
+    for(size_t k=0; k < 2; ++k) {
+        const double target = std::min(1.0f, std::max(0.0f, fractions[k])) * total;
+        double cumulative = 0.0;
+        size_t b = 0;
+        for(; b < histogram_bins; ++b) {
+            if(stats.histogram[b] && cumulative + stats.histogram[b] >= target) break;
+            cumulative += stats.histogram[b];
+        }
+        if(b == histogram_bins) return range;
+        selection[k] = {stats.hist_min + b * bin_width, stats.hist_min + (b+1) * bin_width, b + 1 == histogram_bins, target - cumulative};
+    }
+
+    row_step = std::max<size_t>(1, row_step);
+    const size_t rows = (img.h + row_step - 1) / row_step;
+    const size_t n = img.w * channels;
+    const size_t colour_channels = std::min(channels, MaxColourChannels);
+    num_threads = ChooseThreads(num_threads, rows * n, rows);
+
+    // Histogram the selected intervals alone, narrowing them each pass, until
+    // bins can't hold more than one value or a pass limit is reached.
+    const size_t max_passes = 3;
+    float* values[2] = {&range.first, &range.second};
+    for(size_t pass=0; pass < max_passes; ++pass) {
+        // Both intervals narrow by the same factor each pass
+        const double width = selection[0].hi - selection[0].lo;
+        const double magnitude = std::max(
+            std::max(std::abs(selection[0].lo), std::abs(selection[0].hi)),
+            std::max(std::abs(selection[1].lo), std::abs(selection[1].hi))
+        );
+        if(std::numeric_limits<T>::is_integer ? width <= 1.0 : !(width > magnitude * 1e-6)) {
+            break;
+        }
+
+        std::vector<std::vector<size_t>> hists(num_threads, std::vector<size_t>(2 * histogram_bins, 0));
+        ParallelRows(rows, num_threads, [&](size_t r0, size_t r1, size_t t) {
+            size_t* hist = hists[t].data();
+            for(size_t r=r0; r < r1; ++r) {
+                const T* row = img.RowPtr(r * row_step);
+                for(size_t i=0; i < n; i += channels) {
+                    for(size_t c=0; c < colour_channels; ++c) {
+                        const double v = (double)row[i + c];
+                        for(size_t k=0; k < 2; ++k) {
+                            const Selection& sel = selection[k];
+                            if(v >= sel.lo && (v < sel.hi || (sel.include_hi && v == sel.hi))) {
+                                const double x = (v - sel.lo) * histogram_bins / (sel.hi - sel.lo);
+                                ++hist[k * histogram_bins + std::min(histogram_bins - 1, (size_t)x)];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        for(size_t t=1; t < num_threads; ++t) {
+            for(size_t b=0; b < hists[0].size(); ++b) {
+                hists[0][b] += hists[t][b];
+            }
+        }
+
+        for(size_t k=0; k < 2; ++k) {
+            Selection& sel = selection[k];
+            const size_t* fine = hists[0].data() + k * histogram_bins;
+            const double fine_width = (sel.hi - sel.lo) / histogram_bins;
+            double cumulative = 0.0;
+            for(size_t f=0; f < histogram_bins; ++f) {
+                if(fine[f] && cumulative + fine[f] >= sel.rank) {
+                    const double within = (sel.rank - cumulative) / fine[f];
+                    *values[k] = (float)(sel.lo + fine_width * (f + within));
+                    sel = {sel.lo + f * fine_width, sel.lo + (f+1) * fine_width, sel.include_hi && f + 1 == histogram_bins, sel.rank - cumulative};
+                    break;
+                }
+                cumulative += fine[f];
+            }
+        }
+    }
+    return range;
+}
+
+#define PANGOLIN_INSTANTIATE_IMAGE_STATS(T) \
+    template PANGOLIN_EXPORT ImageStats ComputeImageStats<T>(const Image<T>&, size_t, size_t, size_t, size_t); \
+    template PANGOLIN_EXPORT std::pair<float,float> ComputeImageMinMax<T>(const Image<T>&, size_t, size_t); \
+    template PANGOLIN_EXPORT std::pair<float,float> ComputeImagePercentileRange<T>(const Image<T>&, size_t, float, float, size_t, size_t, size_t);
+
+PANGOLIN_INSTANTIATE_IMAGE_STATS(unsigned char)
+PANGOLIN_INSTANTIATE_IMAGE_STATS(unsigned short)
+PANGOLIN_INSTANTIATE_IMAGE_STATS(float)
+PANGOLIN_INSTANTIATE_IMAGE_STATS(double)
+
+#undef PANGOLIN_INSTANTIATE_IMAGE_STATS
+
+}
@@ -0,0 +1,65 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/image/image_memory_pool.h>
+#include <pangolin/image/typed_image.h>
+
+#include <cstdint>
+#include <memory>
+
+using namespace pangolin;
+
+TEST_CASE("Managed images are aligned and recycled")
+{
+    ImageMemoryPool& pool = ImageMemoryPool::Instance();
+    pool.SetMaxCachedBytes(64 * 1024 * 1024);
+    pool.Trim();
+
+    const unsigned char* first = nullptr;
+    {
+        TypedImage img(640, 479, PixelFormatFromString("RGB24"));
+        REQUIRE(img.IsValid());
+        REQUIRE((uintptr_t)img.ptr % ImageMemoryPool::PageBytes == 0);
+        first = img.ptr;
+    }
+    REQUIRE(pool.GetStats().bytes_cached > 0);
+
+    const size_t reuses = pool.GetStats().reuses;
+    {
+        // Same number of bytes in a different format reuses the released block
+        ManagedImage<uint16_t> img(640*3/2, 479);
+        REQUIRE((unsigned char*)img.ptr == first);
+        REQUIRE(pool.GetStats().reuses == reuses + 1);
+    }
+
+    {
+        ManagedImage<float> small(3, 2);
+        REQUIRE((uintptr_t)small.ptr % ImageMemoryPool::Alignment == 0);
+    }
+
+    pool.Trim();
+    REQUIRE(pool.GetStats().bytes_cached == 0);
+
+    pool.SetMaxCachedBytes(0);
+    {
+        ManagedImage<float> img(64, 64);
+    }
+    REQUIRE(pool.GetStats().bytes_cached == 0);
+}
+
+TEST_CASE("Pointers from elsewhere are left to their owner")
+{
+    ImageMemoryPool& pool = ImageMemoryPool::Instance();
+    const ImageMemoryPool::Stats before = pool.GetStats();
+
+    std::unique_ptr<unsigned char[]> foreign(new unsigned char[64]);
+    pool.Deallocate(foreign.get());
+
+    const ImageMemoryPool::Stats after = pool.GetStats();
+    REQUIRE(after.bytes_in_use == before.bytes_in_use);
+    REQUIRE(after.bytes_cached == before.bytes_cached);
+}
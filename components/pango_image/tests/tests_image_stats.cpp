@@ -0,0 +1,130 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/image/image_stats.h>
+#include <pangolin/image/managed_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace pangolin;
+
+namespace
+{
+
+template<typename T>
+void CheckAgainstScalar(size_t w, size_t h, size_t channels, size_t num_threads)
+{
+    std::mt19937 rng((unsigned)(w*h*channels));
+    std::uniform_int_distribution<int> dist(0, 1000);
+
+    // Rows are padded with values which must not be counted
+    ManagedImage<T> img(w*channels + 3, h);
+    for(size_t y=0; y < h; ++y) {
+        for(size_t x=0; x < img.w; ++x) {
+            img(x,y) = x < w*channels ? (T)dist(rng) : (T)5000;
+        }
+    }
+    const Image<T> pixels(img.ptr, w, h, img.pitch);
+
+    std::vector<float> mn(channels, std::numeric_limits<float>::max());
+    std::vector<float> mx(channels, std::numeric_limits<float>::lowest());
+    std::vector<double> sum(channels, 0.0);
+    for(size_t y=0; y < h; ++y) {
+        for(size_t i=0; i < w*channels; ++i) {
+            const float v = (float)pixels.RowPtr(y)[i];
+            mn[i%channels] = std::min(mn[i%channels], v);
+            mx[i%channels] = std::max(mx[i%channels], v);
+            sum[i%channels] += v;
+        }
+    }
+
+    const ImageStats stats = ComputeImageStats(pixels, channels, 64, 1, num_threads);
+    REQUIRE(stats.channels.size() == channels);
+    for(size_t c=0; c < channels; ++c) {
+        REQUIRE(stats.channels[c].min == mn[c]);
+        REQUIRE(stats.channels[c].max == mx[c]);
+        REQUIRE(std::abs(stats.channels[c].mean - sum[c] / (w*h)) < 1e-6 * (1.0 + sum[c]));
+    }
+
+    const size_t colour = std::min<size_t>(channels, 3);
+    const std::pair<float,float> mm = ComputeImageMinMax(pixels, channels, num_threads);
+    REQUIRE(mm.first == *std::min_element(mn.begin(), mn.begin() + colour));
+    REQUIRE(mm.second == *std::max_element(mx.begin(), mx.begin() + colour));
+    REQUIRE(stats.MinMax() == mm);
+
+    size_t total = 0;
+    for(size_t n : stats.histogram) total += n;
+    REQUIRE(total == w * h * colour);
+    REQUIRE(stats.Percentile(0.0f) == mm.first);
+    REQUIRE(std::abs(stats.Percentile(1.0f) - mm.second) <= 1e-4f * mm.second);
+}
+
+}
+
+TEST_CASE("Image statistics match scalar reference")
+{
+    for(size_t channels : {1, 2, 3, 4}) {
+        for(size_t w : {1, 7, 33, 130}) {
+            CheckAgainstScalar<unsigned char>(w, 5, channels, 1);
+            CheckAgainstScalar<unsigned short>(w, 5, channels, 1);
+            CheckAgainstScalar<float>(w, 5, channels, 1);
+            CheckAgainstScalar<double>(w, 5, channels, 1);
+        }
+    }
+    CheckAgainstScalar<unsigned short>(640, 480, 1, 4);
+    CheckAgainstScalar<float>(320, 240, 3, 3);
+}
+
+TEST_CASE("Image statistics ignore non-finite values")
+{
+    ManagedImage<float> img(64, 8);
+    for(size_t i=0; i < img.Area(); ++i) img.ptr[i] = (float)(i % 100);
+    img(3,2) = std::numeric_limits<float>::quiet_NaN();
+    img(40,5) = std::numeric_limits<float>::quiet_NaN();
+    img(7,3) = std::numeric_limits<float>::infinity();
+    img(63,7) = -std::numeric_limits<float>::infinity();
+
+    const ImageStats stats = ComputeImageStats<float>(img, 1, 100);
+    REQUIRE(stats.channels[0].min == 0.0f);
+    REQUIRE(stats.channels[0].max == 99.0f);
+    REQUIRE(stats.channels[0].count == img.Area() - 4);
+    REQUIRE(std::isfinite(stats.channels[0].mean));
+    REQUIRE(ComputeImageMinMax<float>(img, 1) == std::pair<float,float>(0.0f, 99.0f));
+
+    // A handful of outliers barely move percentiles, unlike min / max
+    img(10,1) = 1e6f;
+    const ImageStats robust = ComputeImageStats<float>(img, 1, 4096);
+    REQUIRE(robust.channels[0].max == 1e6f);
+    REQUIRE(robust.Percentile(0.99f) < 1000.0f);
+}
+
+TEST_CASE("Percentile range is refined within histogram bins")
+{
+    // Outliers stretch the histogram so that the bulk of values share a bin
+    ManagedImage<float> img(500, 400);
+    std::vector<float> sorted;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    for(size_t i=0; i < img.Area(); ++i) {
+        img.ptr[i] = dist(rng);
+        sorted.push_back(img.ptr[i]);
+    }
+    img.ptr[0] = -1e6f;
+    img.ptr[1] = 1e6f;
+    sorted[0] = -1e6f;
+    sorted[1] = 1e6f;
+    std::sort(sorted.begin(), sorted.end());
+
+    const std::pair<float,float> range = ComputeImagePercentileRange<float>(img, 1, 0.01f, 0.99f, 256);
+    const float expected_low = sorted[sorted.size() / 100];
+    const float expected_high = sorted[sorted.size() * 99 / 100];
+    REQUIRE(std::abs(range.first - expected_low) < 1e-3f);
+    REQUIRE(std::abs(range.second - expected_high) < 1e-3f);
+}
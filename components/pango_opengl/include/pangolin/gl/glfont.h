@@ -50,6 +50,16 @@ public:
     // Utf8 encoded string
     GlText Text( const std::string& utf8 );
 
+    // As Text(utf8), but memoized so that strings which are redrawn or
+    // measured every frame needn't be laid out again. The reference is only
+    // valid until the next call to CachedText().
+    const GlText& CachedText( const std::string& utf8 );
+
+    // Shared batch for text drawn with this font. See GlTextBatch.
+    GlTextBatch& Batch() {
+        return batch;
+    }
+
     inline float Height() const {
         return font_height_px;
     }
@@ -74,6 +84,9 @@ protected:
 
     std::map<codepoint_t, GlChar> chardata;
     std::map<codepointpair_t, GLfloat> kern_table;
+
+    std::unordered_map<std::string, GlText> text_cache;
+    GlTextBatch batch;
 };
 
 }
@@ -91,4 +91,40 @@ public:
     std::vector<XYUV> vs;
 };
 
+// Accumulates many GlText strings so that they can be rendered together with
+// a single streaming buffer upload, rather than one client-side draw each.
+// Strings are drawn in the order queued, grouped into runs of consecutive
+// strings which share texture and colour.
+class PANGOLIN_EXPORT GlTextBatch
+{
+public:
+    GlTextBatch();
+
+    // Queue text to be drawn at (x,y) in the coordinate frame active at Flush().
+    // The font texture referenced by text must outlive the next Flush().
+    void Add(const GlText& text, GLfloat x, GLfloat y, const GLfloat colour[4]);
+
+    // Render queued text in the current coordinate frame and empty the queue
+    void Flush();
+
+    // Discard queued text without rendering
+    void Clear();
+
+    bool Empty() const {
+        return vs.empty();
+    }
+
+protected:
+    struct Run {
+        const GlTexture* tex;
+        GLfloat colour[4];
+        size_t start;
+        size_t count;
+    };
+
+    std::vector<XYUV> vs;
+    std::vector<Run> runs;
+    GlBuffer vbo;
+};
+
 }
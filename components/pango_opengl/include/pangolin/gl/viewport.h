@@ -52,6 +52,12 @@ struct PANGOLIN_EXPORT Viewport
     Viewport Intersect(const Viewport& vp) const;
 
     static void DisableScissor();
+
+    // Window position corresponding to (0,0) of the current render target,
+    // for instance when a View is drawn into its own offscreen buffer.
+    // Viewports are activated and scissored relative to it (per thread).
+    static void SetRenderOrigin(GLint x, GLint y);
+    static void GetRenderOrigin(GLint& x, GLint& y);
     
     GLint r() const { return l+w;}
     GLint t() const { return b+h;}
@@ -51,6 +51,7 @@
 #endif
 
 #define MAX_TEXT_LENGTH 500
+#define MAX_CACHED_TEXT 4096
 
 namespace pangolin
 {
@@ -275,4 +276,15 @@ GlText GlFont::Text(const std::string& utf8 )
     return ret;
 }
 
+const GlText& GlFont::CachedText(const std::string& utf8)
+{
+    auto it = text_cache.find(utf8);
+    if(it == text_cache.end()) {
+        // Values which change continuously would otherwise grow without bound
+        if(text_cache.size() >= MAX_CACHED_TEXT) text_cache.clear();
+        it = text_cache.emplace(utf8, Text(utf8)).first;
+    }
+    return it->second;
+}
+
 }
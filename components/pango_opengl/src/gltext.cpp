@@ -27,6 +27,9 @@
 
 #include <pangolin/gl/gltext.h>
 #include <pangolin/gl/glsl.h>
+#include <pangolin/gl/viewport.h>
+
+#include <cstddef>
 
 namespace pangolin
 {
@@ -99,6 +102,69 @@ void GlText::DrawGlSl() const
 #endif
 }
 
+GlTextBatch::GlTextBatch()
+{
+}
+
+void GlTextBatch::Add(const GlText& text, GLfloat x, GLfloat y, const GLfloat colour[4])
+{
+    if(text.vs.empty() || !text.tex) return;
+
+    if( runs.empty() || runs.back().tex != text.tex ||
+        !std::equal(colour, colour+4, runs.back().colour) )
+    {
+        Run r;
+        r.tex = text.tex;
+        std::copy(colour, colour+4, r.colour);
+        r.start = vs.size();
+        r.count = 0;
+        runs.push_back(r);
+    }
+
+    for(const XYUV& v : text.vs) {
+        vs.emplace_back(v.x + x, v.y + y, v.tu, v.tv);
+    }
+    runs.back().count += text.vs.size();
+}
+
+void GlTextBatch::Clear()
+{
+    vs.clear();
+    runs.clear();
+}
+
+void GlTextBatch::Flush()
+{
+    if(vs.empty()) return;
+
+    // Grow geometrically, and orphan the previous contents each frame so
+    // that we needn't wait on the GPU to finish with them.
+    GLuint capacity = std::max<GLuint>(1024, vbo.num_elements);
+    while(capacity < vs.size()) capacity *= 2;
+    vbo.Reinitialise(GlArrayBuffer, capacity, GL_FLOAT, 4, GL_STREAM_DRAW);
+    vbo.Upload(vs.data(), vs.size() * sizeof(XYUV));
+
+    vbo.Bind();
+    glVertexPointer(2, GL_FLOAT, sizeof(XYUV), (void*)offsetof(XYUV, x));
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(XYUV), (void*)offsetof(XYUV, tu));
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnable(GL_TEXTURE_2D);
+
+    for(const Run& r : runs) {
+        r.tex->Bind();
+        glColor4fv(r.colour);
+        glDrawArrays(GL_TRIANGLES, (GLint)r.start, (GLsizei)r.count);
+    }
+
+    glDisable(GL_TEXTURE_2D);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    vbo.Unbind();
+
+    Clear();
+}
+
 void SetWindowOrthographic()
 {
     // We'll set an arbitrary viewport with known dimensions
@@ -111,6 +177,24 @@ void SetWindowOrthographic()
     ProjectionMatrixOrthographic(-0.5, dims[0]-0.5, -0.5, dims[1]-0.5, -1.0, 1.0).Load();
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+
+    // Window coordinates, even when rendering into an offset target
+    GLint origin[2];
+    Viewport::GetRenderOrigin(origin[0], origin[1]);
+    glTranslatef(-(GLfloat)origin[0], -(GLfloat)origin[1], 0.0f);
+}
+
+namespace {
+
+// Restore a viewport queried from GL_VIEWPORT, which is relative to the
+// render origin
+void RestoreViewport(const GLint view[4])
+{
+    GLint origin[2];
+    Viewport::GetRenderOrigin(origin[0], origin[1]);
+    Viewport(view[0] + origin[0], view[1] + origin[1], view[2], view[3]).Activate();
+}
+
 }
 
 void GlText::Draw() const
@@ -149,6 +233,11 @@ void GlText::Draw(GLfloat x, GLfloat y, GLfloat z) const
     pangolin::glProject(x, y, z, modelview, projection, view,
         scrn, scrn + 1, scrn + 2);
 
+    GLint origin[2];
+    Viewport::GetRenderOrigin(origin[0], origin[1]);
+    scrn[0] += origin[0];
+    scrn[1] += origin[1];
+
     // Save current state
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
@@ -160,7 +249,7 @@ void GlText::Draw(GLfloat x, GLfloat y, GLfloat z) const
     Draw();
 
     // Restore viewport & matrices
-    glViewport(view[0],view[1],view[2],view[3]);
+    RestoreViewport(view);
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
@@ -183,7 +272,7 @@ void GlText::DrawWindow(GLfloat x, GLfloat y, GLfloat z) const
     Draw();
 
     // Restore viewport & matrices
-    glViewport(view[0],view[1],view[2],view[3]);
+    RestoreViewport(view);
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
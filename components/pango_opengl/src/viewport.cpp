@@ -32,22 +32,37 @@
 
 namespace pangolin {
 
+namespace {
+thread_local GLint render_origin[2] = {0, 0};
+}
+
 void Viewport::Activate() const
 {
-    glViewport(l,b,w,h);
+    glViewport(l-render_origin[0],b-render_origin[1],w,h);
 }
 
 void Viewport::Scissor() const
 {
     glEnable(GL_SCISSOR_TEST);
-    glScissor(l,b,w,h);
+    glScissor(l-render_origin[0],b-render_origin[1],w,h);
 }
 
 void Viewport::ActivateAndScissor() const
 {
-    glViewport(l,b,w,h);
-    glEnable(GL_SCISSOR_TEST);
-    glScissor(l,b,w,h);
+    Activate();
+    Scissor();
+}
+
+void Viewport::SetRenderOrigin(GLint x, GLint y)
+{
+    render_origin[0] = x;
+    render_origin[1] = y;
+}
+
+void Viewport::GetRenderOrigin(GLint& x, GLint& y)
+{
+    x = render_origin[0];
+    y = render_origin[1];
 }
 
 
@@ -48,11 +48,16 @@ struct PANGOLIN_EXPORT Packet
         return _stream;
     }
 
+    // Frame metadata, whichever encoding it was written in. Binary metadata
+    // is only decoded on first access.
+    const picojson::value& Meta();
+
     PacketStreamSourceId src;
     int64_t time;
     size_t size;
     size_t sequence_num;
     picojson::value meta;
+    std::string meta_binary;
     std::streampos frame_streampos;
 
 private:
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/utils/picojson.h>
+
+#include <string>
+
+namespace pangolin {
+
+// Compact binary encoding for per-packet metadata, written under
+// TAG_SRC_BINMETA as an alternative to JSON text. The encoding is a subset
+// of MessagePack: nil, bool, integers, float64, str, array and map (with
+// string keys), so it can be inspected with standard tools.
+
+// Append the encoding of value to out
+PANGOLIN_EXPORT
+void EncodeBinaryMeta(const picojson::value& value, std::string& out);
+
+// Decode a value from data, throwing std::runtime_error if malformed
+PANGOLIN_EXPORT
+picojson::value DecodeBinaryMeta(const char* data, size_t size);
+
+}
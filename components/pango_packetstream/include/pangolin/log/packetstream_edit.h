@@ -0,0 +1,67 @@
+#pragma once
+
+#include <pangolin/log/packetstream_source.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace pangolin {
+
+// Editing operations on packetstream (.pango) logs. Packets are copied
+// verbatim, including any metadata, without decoding their payload, and
+// every output gets a freshly built index. The cost of an edit is therefore
+// dominated by I/O, and with an indexed input, by the size of the selection
+// rather than of the whole log.
+
+// Selects a subset of the packets in a log. All ranges are half-open.
+struct PANGOLIN_EXPORT PacketStreamSelection
+{
+    PacketStreamSelection()
+        : frame_begin(0), frame_end(std::numeric_limits<size_t>::max()),
+          time_begin_us(std::numeric_limits<int64_t>::min()),
+          time_end_us(std::numeric_limits<int64_t>::max())
+    {
+    }
+
+    bool HasSource(PacketStreamSourceId src) const;
+
+    // Input source ids to keep, in output order. Empty keeps all of them.
+    std::vector<PacketStreamSourceId> sources;
+
+    // Input source ids to drop, applied after sources.
+    std::vector<PacketStreamSourceId> drop_sources;
+
+    // Range of frame numbers, counted per source.
+    size_t frame_begin;
+    size_t frame_end;
+
+    // Range of packet times in microseconds, relative to the time of the
+    // first packet in the log.
+    int64_t time_begin_us;
+    int64_t time_end_us;
+};
+
+// Copy the selected packets of filein to fileout. Selected sources are
+// renumbered from 0 in the output. Returns the number of packets written.
+PANGOLIN_EXPORT
+size_t ExtractPacketStream(const std::string& filein, const std::string& fileout, const PacketStreamSelection& selection = PacketStreamSelection());
+
+// Write each source of filein to a log of its own, in a single pass over the
+// input. fileouts must hold one filename per input source, where an empty
+// filename drops that source. Returns the number of packets written.
+PANGOLIN_EXPORT
+size_t SplitPacketStream(const std::string& filein, const std::vector<std::string>& fileouts);
+
+// Combine the sources of every input into one log, interleaving their
+// packets by time. Returns the number of packets written.
+PANGOLIN_EXPORT
+size_t MergePacketStreams(const std::vector<std::string>& filesin, const std::string& fileout);
+
+// Append the inputs one after the other. Every input must have the same
+// sources (by driver and data definition) in the same order. Returns the
+// number of packets written.
+PANGOLIN_EXPORT
+size_t ConcatPacketStreams(const std::vector<std::string>& filesin, const std::string& fileout);
+
+}
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -49,6 +50,10 @@ public:
 
     void Open(const std::string& filename);
 
+    // Open another reader onto the same file with its own file handle and
+    // position, reusing the sources and index already parsed by this one.
+    std::unique_ptr<PacketStreamReader> Duplicate();
+
     void Close();
 
     const std::vector<PacketStreamSource>&
@@ -60,7 +65,8 @@ public:
     // Grab Next available frame packetstream
     Packet NextFrame();
 
-    // Grab Next available frame in packetstream from src, discarding other frames.
+    // Grab Next available frame in packetstream from src. When indexed, this
+    // jumps straight to it, otherwise other sources' frames are discarded.
     Packet NextFrame(PacketStreamSourceId src);
 
     bool Good() const
@@ -68,6 +74,11 @@ public:
         return _stream.good();
     }
 
+    bool Seekable() const
+    {
+        return _stream.seekable();
+    }
+
     // Jumps to a particular packet.
     size_t Seek(PacketStreamSourceId src, size_t framenum);
 
@@ -102,6 +113,7 @@ private:
     std::string _filename;
     std::vector<PacketStreamSource> _sources;
     SyncTime::TimePoint packet_stream_start;
+    std::streampos _first_packet_pos;
 
     PacketStream _stream;
     std::recursive_mutex _mutex;
@@ -32,6 +32,7 @@ const PangoTagType TAG_PANGO_FOOTER = PANGO_TAG('F', 'T', 'R');
 const PangoTagType TAG_ADD_SOURCE   = PANGO_TAG('S', 'R', 'C');
 const PangoTagType TAG_SRC_JSON     = PANGO_TAG('J', 'S', 'N');
 const PangoTagType TAG_SRC_PACKET   = PANGO_TAG('P', 'K', 'T');
+const PangoTagType TAG_SRC_BINMETA  = PANGO_TAG('B', 'M', 'D');
 const PangoTagType TAG_END          = PANGO_TAG('E', 'N', 'D');
 #undef PANGO_TAG
 
@@ -101,6 +101,13 @@ public:
         size_t sourcelen, const picojson::value& meta = picojson::value()
     );
 
+    // As above, but with metadata already encoded by EncodeBinaryMeta() (or
+    // empty for none). Used to copy packets between streams without decoding.
+    void WriteSourcePacketBinaryMeta(
+        PacketStreamSourceId src, const char* source,const int64_t receive_time_us,
+        size_t sourcelen, const std::string& binary_meta
+    );
+
     // For stream read/write synchronization. Note that this is NOT the same as
     // time synchronization on playback of iPacketStreams.
     void WriteSync();
@@ -117,14 +124,25 @@ public:
         return _open;
     }
 
+    // Write per-packet metadata in the compact binary encoding of
+    // packet_meta.h rather than as JSON text. Off by default, since older
+    // readers don't understand it.
+    void SetBinaryMeta(bool binary_meta) {
+        _binary_meta = binary_meta;
+    }
+
 private:
     void WriteHeader();
     void Write(const PacketStreamSource&);
     void WriteMeta(PacketStreamSourceId src, const picojson::value& data);
+    void WriteBinaryMeta(PacketStreamSourceId src, const std::string& data);
+    void WritePacket(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen);
 
     threadedfilebuf _buffer;
     std::ostream _stream;
     bool _indexable, _open;
+    bool _binary_meta = false;
+    std::string _meta_buffer;
 
     std::vector<PacketStreamSource> _sources;
     size_t _bytes_written;
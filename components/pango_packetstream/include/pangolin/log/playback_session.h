@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <pangolin/log/packetstream_reader.h>
@@ -17,17 +19,22 @@ public:
     // Singleton Instance
     static std::shared_ptr<PlaybackSession> Default();
 
-    // Return thread-safe, shared instance of PacketStreamReader, providing
-    // serialised read for PacketStreamReader
+    // Return a PacketStreamReader for filename. The file is parsed and indexed
+    // once per session; each further caller gets its own handle onto it so
+    // that sources can be read concurrently. Pipes can't be reopened, so
+    // callers share a single thread-safe reader instead.
     std::shared_ptr<PacketStreamReader> Open(const std::string& filename)
     {
         const std::string path = SanitizePath(PathExpand(filename));
 
+        std::lock_guard<std::mutex> l(readers_mutex);
         auto i = readers.find(path);
         if(i == readers.end()) {
             auto psr = std::make_shared<PacketStreamReader>(path);
             readers[path] = psr;
             return psr;
+        }else if(i->second->Seekable()) {
+            return std::shared_ptr<PacketStreamReader>(i->second->Duplicate());
         }else{
             return i->second;
         }
@@ -36,6 +43,7 @@ public:
     // Should only be called if there's no playbacks
     // in flight
     void Clear() {
+      std::lock_guard<std::mutex> l(readers_mutex);
       readers.clear();
       time.Reset();
     }
@@ -48,6 +56,7 @@ public:
     static std::shared_ptr<PlaybackSession> ChooseFromParams(const Params& params);
 private:
     static std::shared_ptr<PlaybackSession> Choose(bool ordered_playback);
+    std::mutex readers_mutex;
     std::map<std::string,std::shared_ptr<PacketStreamReader>> readers;
     SyncTime time;
 };
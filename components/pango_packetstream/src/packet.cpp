@@ -1,4 +1,5 @@
 #include <pangolin/log/packet.h>
+#include <pangolin/log/packet_meta.h>
 
 namespace pangolin {
 
@@ -11,7 +12,7 @@ Packet::Packet(PacketStream& s, std::unique_lock<std::recursive_mutex>&& lock, s
 
 Packet::Packet(Packet&& o)
     : src(o.src), time(o.time), size(o.size), sequence_num(o.sequence_num),
-      meta(std::move(o.meta)), frame_streampos(o.frame_streampos), _stream(o._stream),
+      meta(std::move(o.meta)), meta_binary(std::move(o.meta_binary)), frame_streampos(o.frame_streampos), _stream(o._stream),
       lock(std::move(o.lock)), data_streampos(o.data_streampos), _data_len(o._data_len)
 {
     o._data_len = 0;
@@ -27,6 +28,15 @@ size_t Packet::BytesRead() const
     return _stream.tellg() - data_streampos;
 }
 
+const picojson::value& Packet::Meta()
+{
+    if(!meta_binary.empty()) {
+        meta = DecodeBinaryMeta(meta_binary.data(), meta_binary.size());
+        meta_binary.clear();
+    }
+    return meta;
+}
+
 int Packet::BytesRemaining() const
 {
     if(_data_len) {
@@ -46,6 +56,12 @@ void Packet::ParsePacketHeader(PacketStream& s, std::vector<PacketStreamSource>&
         s.readTag(TAG_SRC_JSON);
         json_src = s.readUINT();
         picojson::parse(meta, s);
+    }else if (s.peekTag() == TAG_SRC_BINMETA)
+    {
+        s.readTag(TAG_SRC_BINMETA);
+        json_src = s.readUINT();
+        meta_binary.resize(s.readUINT());
+        s.read(&meta_binary[0], meta_binary.size());
     }
 
     s.readTag(TAG_SRC_PACKET);
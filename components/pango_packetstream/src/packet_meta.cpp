@@ -0,0 +1,193 @@
+#include <pangolin/log/packet_meta.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace pangolin {
+
+namespace {
+
+// MessagePack stores multi-byte values big-endian
+template<typename T>
+void PutBigEndian(std::string& out, T v)
+{
+    unsigned char bytes[sizeof(T)];
+    uint64_t u = 0;
+    std::memcpy(&u, &v, sizeof(T));
+    for(size_t i=0; i < sizeof(T); ++i) {
+        bytes[sizeof(T)-1-i] = (unsigned char)(u >> (8*i));
+    }
+    out.append((const char*)bytes, sizeof(T));
+}
+
+void PutHeader(std::string& out, size_t n, unsigned char fix, size_t fix_max, unsigned char t16, unsigned char t32)
+{
+    if(n <= fix_max) {
+        out.push_back((char)(fix | n));
+    }else if(n <= 0xffff) {
+        out.push_back((char)t16);
+        PutBigEndian<uint16_t>(out, (uint16_t)n);
+    }else{
+        out.push_back((char)t32);
+        PutBigEndian<uint32_t>(out, (uint32_t)n);
+    }
+}
+
+void PutString(std::string& out, const std::string& s)
+{
+    if(s.size() < 32) {
+        out.push_back((char)(0xa0 | s.size()));
+    }else if(s.size() <= 0xff) {
+        out.push_back((char)0xd9);
+        out.push_back((char)s.size());
+    }else{
+        PutHeader(out, s.size(), 0, 0, 0xda, 0xdb);
+    }
+    out.append(s);
+}
+
+void PutInt(std::string& out, int64_t v)
+{
+    if(-32 <= v && v <= 127) {
+        out.push_back((char)(int8_t)v);
+    }else if(INT8_MIN <= v && v <= INT8_MAX) {
+        out.push_back((char)0xd0);
+        out.push_back((char)(int8_t)v);
+    }else if(INT16_MIN <= v && v <= INT16_MAX) {
+        out.push_back((char)0xd1);
+        PutBigEndian<int16_t>(out, (int16_t)v);
+    }else if(INT32_MIN <= v && v <= INT32_MAX) {
+        out.push_back((char)0xd2);
+        PutBigEndian<int32_t>(out, (int32_t)v);
+    }else{
+        out.push_back((char)0xd3);
+        PutBigEndian<int64_t>(out, v);
+    }
+}
+
+struct Decoder
+{
+    const unsigned char* p;
+    const unsigned char* end;
+
+    void Need(size_t n)
+    {
+        if((size_t)(end - p) < n) throw std::runtime_error("Truncated binary metadata");
+    }
+
+    template<typename T>
+    T GetBigEndian()
+    {
+        Need(sizeof(T));
+        uint64_t u = 0;
+        for(size_t i=0; i < sizeof(T); ++i) u = (u << 8) | p[i];
+        p += sizeof(T);
+        T v;
+        std::memcpy(&v, &u, sizeof(T));
+        return v;
+    }
+
+    std::string GetString(size_t n)
+    {
+        Need(n);
+        std::string s((const char*)p, n);
+        p += n;
+        return s;
+    }
+
+    picojson::value GetArray(size_t n)
+    {
+        picojson::value v = picojson::value(picojson::array_type, false);
+        picojson::array& a = v.get<picojson::array>();
+        a.reserve(n);
+        for(size_t i=0; i < n; ++i) a.push_back(Get());
+        return v;
+    }
+
+    picojson::value GetObject(size_t n)
+    {
+        picojson::value v = picojson::value(picojson::object_type, false);
+        picojson::object& o = v.get<picojson::object>();
+        for(size_t i=0; i < n; ++i) {
+            picojson::value key = Get();
+            if(!key.is<std::string>()) throw std::runtime_error("Binary metadata map key isn't a string");
+            o[key.get<std::string>()] = Get();
+        }
+        return v;
+    }
+
+    picojson::value Get()
+    {
+        Need(1);
+        const unsigned char t = *p++;
+
+        if(t <= 0x7f) return picojson::value((int64_t)t);
+        if(t >= 0xe0) return picojson::value((int64_t)(int8_t)t);
+        if((t & 0xe0) == 0xa0) return picojson::value(GetString(t & 0x1f));
+        if((t & 0xf0) == 0x90) return GetArray(t & 0x0f);
+        if((t & 0xf0) == 0x80) return GetObject(t & 0x0f);
+
+        switch(t) {
+        case 0xc0: return picojson::value();
+        case 0xc2: return picojson::value(false);
+        case 0xc3: return picojson::value(true);
+        case 0xca: return picojson::value((double)GetBigEndian<float>());
+        case 0xcb: return picojson::value(GetBigEndian<double>());
+        case 0xcc: return picojson::value((int64_t)GetBigEndian<uint8_t>());
+        case 0xcd: return picojson::value((int64_t)GetBigEndian<uint16_t>());
+        case 0xce: return picojson::value((int64_t)GetBigEndian<uint32_t>());
+        case 0xcf: return picojson::value((int64_t)GetBigEndian<uint64_t>());
+        case 0xd0: return picojson::value((int64_t)GetBigEndian<int8_t>());
+        case 0xd1: return picojson::value((int64_t)GetBigEndian<int16_t>());
+        case 0xd2: return picojson::value((int64_t)GetBigEndian<int32_t>());
+        case 0xd3: return picojson::value(GetBigEndian<int64_t>());
+        case 0xd9: return picojson::value(GetString(GetBigEndian<uint8_t>()));
+        case 0xda: return picojson::value(GetString(GetBigEndian<uint16_t>()));
+        case 0xdb: return picojson::value(GetString(GetBigEndian<uint32_t>()));
+        case 0xdc: return GetArray(GetBigEndian<uint16_t>());
+        case 0xdd: return GetArray(GetBigEndian<uint32_t>());
+        case 0xde: return GetObject(GetBigEndian<uint16_t>());
+        case 0xdf: return GetObject(GetBigEndian<uint32_t>());
+        default:
+            throw std::runtime_error("Unsupported binary metadata type");
+        }
+    }
+};
+
+}
+
+void EncodeBinaryMeta(const picojson::value& value, std::string& out)
+{
+    if(value.is<picojson::null>()) {
+        out.push_back((char)0xc0);
+    }else if(value.is<bool>()) {
+        out.push_back((char)(value.get<bool>() ? 0xc3 : 0xc2));
+    }else if(value.is<int64_t>()) {
+        PutInt(out, value.get<int64_t>());
+    }else if(value.is<double>()) {
+        out.push_back((char)0xcb);
+        PutBigEndian<double>(out, value.get<double>());
+    }else if(value.is<std::string>()) {
+        PutString(out, value.get<std::string>());
+    }else if(value.is<picojson::array>()) {
+        const picojson::array& a = value.get<picojson::array>();
+        PutHeader(out, a.size(), 0x90, 0x0f, 0xdc, 0xdd);
+        for(const picojson::value& v : a) EncodeBinaryMeta(v, out);
+    }else if(value.is<picojson::object>()) {
+        const picojson::object& o = value.get<picojson::object>();
+        PutHeader(out, o.size(), 0x80, 0x0f, 0xde, 0xdf);
+        for(const auto& kv : o) {
+            PutString(out, kv.first);
+            EncodeBinaryMeta(kv.second, out);
+        }
+    }
+}
+
+picojson::value DecodeBinaryMeta(const char* data, size_t size)
+{
+    Decoder decoder{(const unsigned char*)data, (const unsigned char*)data + size};
+    return decoder.Get();
+}
+
+}
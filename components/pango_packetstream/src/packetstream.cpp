@@ -110,6 +110,7 @@ static bool valid(PangoTagType t)
         case TAG_ADD_SOURCE:
         case TAG_SRC_JSON:
         case TAG_SRC_PACKET:
+        case TAG_SRC_BINMETA:
         case TAG_PANGO_STATS:
         case TAG_PANGO_FOOTER:
         case TAG_END:
@@ -0,0 +1,288 @@
+#include <pangolin/log/packetstream_edit.h>
+#include <pangolin/log/packetstream_reader.h>
+#include <pangolin/log/packetstream_writer.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace pangolin {
+
+namespace {
+
+const PacketStreamSourceId NoSource = static_cast<PacketStreamSourceId>(-1);
+
+// Replace pkt with the next packet of reader, or nullptr at the end of the
+// stream. The previous packet must be released first so that the rest of its
+// payload is skipped.
+void ReadPacket(PacketStreamReader& reader, std::unique_ptr<Packet>& pkt)
+{
+    pkt.reset();
+    try {
+        pkt.reset(new Packet(reader.NextFrame()));
+    }catch(const std::runtime_error&) {
+    }
+}
+
+PacketStreamSourceId AddOutputSource(PacketStreamWriter& writer, const PacketStreamSource& in)
+{
+    PacketStreamSource out = in;
+    out.index.clear();
+    out.next_packet_id = 0;
+    return writer.AddSource(out);
+}
+
+void CopyPacket(Packet& pkt, PacketStreamWriter& writer, PacketStreamSourceId dst, std::vector<char>& buffer)
+{
+    buffer.resize(pkt.BytesRemaining());
+    pkt.Stream().read(buffer.data(), buffer.size());
+
+    if(!pkt.meta_binary.empty()) {
+        writer.WriteSourcePacketBinaryMeta(dst, buffer.data(), pkt.time, buffer.size(), pkt.meta_binary);
+    }else{
+        writer.WriteSourcePacket(dst, buffer.data(), pkt.time, buffer.size(), pkt.meta);
+    }
+}
+
+bool IsIndexed(const PacketStreamReader& reader, const PacketStreamSelection& selection)
+{
+    if(!reader.Seekable()) return false;
+    for(const PacketStreamSource& src : reader.Sources()) {
+        if(selection.HasSource(src.id) && src.index.empty()) return false;
+    }
+    return true;
+}
+
+// Position reader on the first selected packet using the index, keeping
+// every source's frame count consistent with the new position. Returns false
+// if nothing is selected.
+bool SeekToSelection(PacketStreamReader& reader, const PacketStreamSelection& selection, int64_t t0)
+{
+    const std::vector<PacketStreamSource>& sources = reader.Sources();
+
+    PacketStreamSourceId first_src = NoSource;
+    size_t first_frame = 0;
+    for(const PacketStreamSource& src : sources) {
+        if(!selection.HasSource(src.id)) continue;
+        const auto lb = std::lower_bound(
+            src.index.begin(), src.index.end(), selection.time_begin_us,
+            [t0](const PacketStreamSource::PacketInfo& a, int64_t t){ return a.capture_time - t0 < t; }
+        );
+        const size_t f = std::max<size_t>(lb - src.index.begin(), selection.frame_begin);
+        if(f < src.index.size() && (first_src == NoSource || src.index[f].pos < sources[first_src].index[first_frame].pos)) {
+            first_src = src.id;
+            first_frame = f;
+        }
+    }
+    if(first_src == NoSource) return false;
+
+    const std::streampos start = sources[first_src].index[first_frame].pos;
+    for(const PacketStreamSource& src : sources) {
+        if(src.id == first_src) continue;
+        const auto lb = std::lower_bound(
+            src.index.begin(), src.index.end(), start,
+            [](const PacketStreamSource::PacketInfo& a, std::streampos p){ return a.pos < p; }
+        );
+        if(lb != src.index.end()) reader.Seek(src.id, lb - src.index.begin());
+    }
+    reader.Seek(first_src, first_frame);
+    return true;
+}
+
+}
+
+bool PacketStreamSelection::HasSource(PacketStreamSourceId src) const
+{
+    return (sources.empty() || std::find(sources.begin(), sources.end(), src) != sources.end()) &&
+           std::find(drop_sources.begin(), drop_sources.end(), src) == drop_sources.end();
+}
+
+size_t ExtractPacketStream(const std::string& filein, const std::string& fileout, const PacketStreamSelection& selection)
+{
+    PacketStreamReader reader(filein);
+    PacketStreamWriter writer(fileout);
+
+    std::unique_ptr<Packet> pkt;
+    ReadPacket(reader, pkt);
+    if(!pkt) return 0;
+
+    // Sources preceding the first packet are known by now
+    std::vector<PacketStreamSourceId> out_id(reader.Sources().size(), NoSource);
+    if(selection.sources.empty()) {
+        for(const PacketStreamSource& src : reader.Sources()) {
+            if(selection.HasSource(src.id)) out_id[src.id] = AddOutputSource(writer, src);
+        }
+    }else{
+        for(PacketStreamSourceId id : selection.sources) {
+            if(id < out_id.size() && selection.HasSource(id) && out_id[id] == NoSource) {
+                out_id[id] = AddOutputSource(writer, reader.Sources()[id]);
+            }
+        }
+    }
+
+    const int64_t t0 = pkt->time;
+    const bool indexed = IsIndexed(reader, selection);
+    if(indexed) {
+        pkt.reset();
+        if(!SeekToSelection(reader, selection, t0)) return 0;
+        ReadPacket(reader, pkt);
+    }
+
+    // Stop early once every selected source has passed the end of the range
+    std::vector<bool> known(out_id.size(), true);
+    std::vector<bool> done(out_id.size());
+    for(size_t i=0; i < out_id.size(); ++i) done[i] = out_id[i] == NoSource;
+    size_t num_done = std::count(done.begin(), done.end(), true);
+
+    std::vector<char> buffer;
+    size_t written = 0;
+    for(; pkt && num_done < done.size(); ReadPacket(reader, pkt)) {
+        if(pkt->src >= out_id.size()) {
+            out_id.resize(pkt->src + 1, NoSource);
+            known.resize(pkt->src + 1, false);
+            done.resize(pkt->src + 1, false);
+        }
+        if(!known[pkt->src]) {
+            // Source added part way through the log
+            known[pkt->src] = true;
+            if(selection.HasSource(pkt->src)) {
+                out_id[pkt->src] = AddOutputSource(writer, reader.Sources()[pkt->src]);
+            }else{
+                done[pkt->src] = true;
+                ++num_done;
+            }
+        }
+
+        const PacketStreamSourceId dst = out_id[pkt->src];
+        if(dst == NoSource || done[pkt->src]) continue;
+
+        const int64_t t = pkt->time - t0;
+        const size_t frame = pkt->sequence_num;
+        const bool last = indexed && frame + 1 >= reader.Sources()[pkt->src].index.size();
+
+        if(frame >= selection.frame_end || t >= selection.time_end_us || last) {
+            done[pkt->src] = true;
+            ++num_done;
+        }
+
+        if(selection.frame_begin <= frame && frame < selection.frame_end &&
+           selection.time_begin_us <= t && t < selection.time_end_us)
+        {
+            CopyPacket(*pkt, writer, dst, buffer);
+            ++written;
+        }
+    }
+
+    return written;
+}
+
+size_t SplitPacketStream(const std::string& filein, const std::vector<std::string>& fileouts)
+{
+    PacketStreamReader reader(filein);
+
+    std::vector<std::unique_ptr<PacketStreamWriter>> writers(fileouts.size());
+    std::vector<PacketStreamSourceId> out_id(fileouts.size(), NoSource);
+
+    std::vector<char> buffer;
+    size_t written = 0;
+    std::unique_ptr<Packet> pkt;
+    for(ReadPacket(reader, pkt); pkt; ReadPacket(reader, pkt)) {
+        if(pkt->src >= fileouts.size() || fileouts[pkt->src].empty()) continue;
+
+        std::unique_ptr<PacketStreamWriter>& writer = writers[pkt->src];
+        if(!writer) {
+            writer.reset(new PacketStreamWriter(fileouts[pkt->src]));
+            out_id[pkt->src] = AddOutputSource(*writer, reader.Sources()[pkt->src]);
+        }
+
+        CopyPacket(*pkt, *writer, out_id[pkt->src], buffer);
+        ++written;
+    }
+
+    return written;
+}
+
+size_t MergePacketStreams(const std::vector<std::string>& filesin, const std::string& fileout)
+{
+    std::vector<std::unique_ptr<PacketStreamReader>> readers;
+    std::vector<std::vector<PacketStreamSourceId>> out_id;
+    PacketStreamWriter writer(fileout);
+
+    for(const std::string& filename : filesin) {
+        readers.emplace_back(new PacketStreamReader(filename));
+        out_id.emplace_back();
+        for(const PacketStreamSource& src : readers.back()->Sources()) {
+            out_id.back().push_back(AddOutputSource(writer, src));
+        }
+    }
+
+    std::vector<std::unique_ptr<Packet>> heads(readers.size());
+    for(size_t i=0; i < readers.size(); ++i) {
+        ReadPacket(*readers[i], heads[i]);
+    }
+
+    std::vector<char> buffer;
+    size_t written = 0;
+    while(true) {
+        size_t next = heads.size();
+        for(size_t i=0; i < heads.size(); ++i) {
+            if(heads[i] && (next == heads.size() || heads[i]->time < heads[next]->time)) {
+                next = i;
+            }
+        }
+        if(next == heads.size()) break;
+
+        Packet& pkt = *heads[next];
+        std::vector<PacketStreamSourceId>& ids = out_id[next];
+        while(pkt.src >= ids.size()) {
+            ids.push_back(AddOutputSource(writer, readers[next]->Sources()[ids.size()]));
+        }
+
+        CopyPacket(pkt, writer, ids[pkt.src], buffer);
+        ++written;
+
+        ReadPacket(*readers[next], heads[next]);
+    }
+
+    return written;
+}
+
+size_t ConcatPacketStreams(const std::vector<std::string>& filesin, const std::string& fileout)
+{
+    PacketStreamWriter writer(fileout);
+    std::vector<PacketStreamSource> sources;
+
+    std::vector<char> buffer;
+    size_t written = 0;
+    for(const std::string& filename : filesin) {
+        PacketStreamReader reader(filename);
+
+        // Sources may also be added part way through a log
+        size_t checked = 0;
+        auto check_sources = [&]() {
+            for(; checked < reader.Sources().size(); ++checked) {
+                const PacketStreamSource& src = reader.Sources()[checked];
+                if(checked == sources.size()) {
+                    sources.push_back(src);
+                    AddOutputSource(writer, src);
+                }else if(sources[checked].driver != src.driver ||
+                         sources[checked].data_definitions != src.data_definitions ||
+                         sources[checked].data_size_bytes != src.data_size_bytes)
+                {
+                    throw std::runtime_error("ConcatPacketStreams: sources of '" + filename + "' don't match earlier inputs.");
+                }
+            }
+        };
+        check_sources();
+
+        std::unique_ptr<Packet> pkt;
+        for(ReadPacket(reader, pkt); pkt; ReadPacket(reader, pkt)) {
+            if(pkt->src >= checked) check_sources();
+            CopyPacket(*pkt, writer, pkt->src, buffer);
+            ++written;
+        }
+    }
+
+    return written;
+}
+
+}
@@ -25,6 +25,7 @@
 
 #include <pangolin/log/packetstream_reader.h>
 #include <pangolin/log/packetstream_writer.h>
+#include <pangolin/utils/trace.h>
 
 using std::string;
 using std::istream;
@@ -90,12 +91,35 @@ void PacketStreamReader::Open(const std::string& filename)
     while (_stream.peekTag() == TAG_ADD_SOURCE) {
         ParseNewSource();
     }
+    _first_packet_pos = _stream.tellg();
 
     if(!SetupIndex()) {
         FixFileIndex();
     }
 }
 
+std::unique_ptr<PacketStreamReader> PacketStreamReader::Duplicate()
+{
+    std::lock_guard<std::recursive_mutex> lg(_mutex);
+
+    std::unique_ptr<PacketStreamReader> reader(new PacketStreamReader());
+    reader->_filename = _filename;
+    reader->_is_pipe = _is_pipe;
+    reader->_stream.open(_filename);
+
+    if (!reader->_stream.is_open())
+        throw runtime_error("Cannot open stream from " + _filename);
+
+    reader->_sources = _sources;
+    for(PacketStreamSource& s : reader->_sources) {
+        s.next_packet_id = 0;
+    }
+    reader->packet_stream_start = packet_stream_start;
+    reader->_first_packet_pos = _first_packet_pos;
+    reader->_stream.seekg(_first_packet_pos);
+    return reader;
+}
+
 void PacketStreamReader::Close() {
     std::lock_guard<std::recursive_mutex> lg(_mutex);
 
@@ -254,6 +278,7 @@ bool PacketStreamReader::GoodToRead()
 
 Packet PacketStreamReader::NextFrame()
 {
+    PANGO_TRACE_SCOPE("packetstream", "PacketStreamReader::NextFrame");
     std::unique_lock<std::recursive_mutex> lock(_mutex);
 
     while (GoodToRead())
@@ -269,6 +294,7 @@ Packet PacketStreamReader::NextFrame()
             ParseNewSource();
             break;
         case TAG_SRC_JSON: //frames are sometimes preceded by metadata, but metadata must ALWAYS be followed by a frame from the same source.
+        case TAG_SRC_BINMETA:
         case TAG_SRC_PACKET:
             return Packet(_stream, std::move(lock), _sources);
         case TAG_PANGO_STATS:
@@ -296,6 +322,18 @@ Packet PacketStreamReader::NextFrame()
 
 Packet PacketStreamReader::NextFrame(PacketStreamSourceId src)
 {
+    PANGO_TRACE_SCOPE("packetstream", "PacketStreamReader::NextFrame");
+    std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+    if(src < _sources.size() && _stream.seekable()) {
+        PacketStreamSource& source = _sources[src];
+        const std::streampos pos = source.FindSeekLocation(source.next_packet_id);
+        if(pos > 0 && _stream.tellg() != pos) {
+            _stream.clear();
+            _stream.seekg(pos);
+        }
+    }
+
     while (1)
     {
         // This will throw if nothing is left.
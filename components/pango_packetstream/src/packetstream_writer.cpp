@@ -24,8 +24,10 @@
  */
 
 #include <pangolin/log/packetstream_writer.h>
+#include <pangolin/log/packet_meta.h>
 #include <pangolin/utils/file_utils.h>
 #include <pangolin/utils/timer.h>
+#include <pangolin/utils/trace.h>
 
 using std::ios;
 using std::lock_guard;
@@ -104,20 +106,51 @@ PacketStreamSourceId PacketStreamWriter::AddSource(const PacketStreamSource& sou
 void PacketStreamWriter::WriteMeta(PacketStreamSourceId src, const picojson::value& data)
 {
     SCOPED_LOCK;
-    writeTag(_stream, TAG_SRC_JSON);
-    writeCompressedUnsignedInt(_stream, src);
-    data.serialize(std::ostream_iterator<char>(_stream), false);
+    if(_binary_meta) {
+        _meta_buffer.clear();
+        EncodeBinaryMeta(data, _meta_buffer);
+        WriteBinaryMeta(src, _meta_buffer);
+    }else{
+        writeTag(_stream, TAG_SRC_JSON);
+        writeCompressedUnsignedInt(_stream, src);
+        data.serialize(std::ostream_iterator<char>(_stream), false);
+    }
 }
 
 void PacketStreamWriter::WriteSourcePacket(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen, const picojson::value& meta)
 {
-
+    PANGO_TRACE_SCOPE("packetstream", "PacketStreamWriter::WriteSourcePacket");
     SCOPED_LOCK;
     _sources[src].index.push_back({_stream.tellp(), receive_time_us});
 
     if (!meta.is<picojson::null>())
         WriteMeta(src, meta);
 
+    WritePacket(src, source, receive_time_us, sourcelen);
+}
+
+void PacketStreamWriter::WriteSourcePacketBinaryMeta(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen, const std::string& binary_meta)
+{
+    PANGO_TRACE_SCOPE("packetstream", "PacketStreamWriter::WriteSourcePacket");
+    SCOPED_LOCK;
+    _sources[src].index.push_back({_stream.tellp(), receive_time_us});
+
+    if (!binary_meta.empty())
+        WriteBinaryMeta(src, binary_meta);
+
+    WritePacket(src, source, receive_time_us, sourcelen);
+}
+
+void PacketStreamWriter::WriteBinaryMeta(PacketStreamSourceId src, const std::string& data)
+{
+    writeTag(_stream, TAG_SRC_BINMETA);
+    writeCompressedUnsignedInt(_stream, src);
+    writeCompressedUnsignedInt(_stream, data.size());
+    _stream.write(data.data(), data.size());
+}
+
+void PacketStreamWriter::WritePacket(PacketStreamSourceId src, const char* source, const int64_t receive_time_us, size_t sourcelen)
+{
     writeTag(_stream, TAG_SRC_PACKET);
     writeTimestamp(_stream, receive_time_us);
     writeCompressedUnsignedInt(_stream, src);
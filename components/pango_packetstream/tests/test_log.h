@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pangolin/log/packetstream_writer.h>
+
+#include <string>
+
+// Write a log of two interleaved sources, with frames 1ms apart from t0.
+// Source 0 has fixed size packets holding their frame number. Source 1 has
+// variable size packets, half a millisecond behind, with the frame number as
+// metadata.
+inline void WriteTestLog(const std::string& filename, int64_t frames = 100, int64_t t0 = 1000000)
+{
+    pangolin::PacketStreamWriter writer(filename);
+    pangolin::PacketStreamSource fixed, variable;
+    fixed.driver = "fixed";
+    fixed.data_size_bytes = sizeof(int64_t);
+    variable.driver = "variable";
+    writer.AddSource(fixed);
+    writer.AddSource(variable);
+
+    for(int64_t i=0; i < frames; ++i) {
+        const int64_t t = t0 + i * 1000;
+        writer.WriteSourcePacket(0, (const char*)&i, t, sizeof(i));
+        picojson::value meta;
+        meta["frame"] = picojson::value(i);
+        const std::string data(i % 7 + 1, 'a' + i % 26);
+        writer.WriteSourcePacket(1, data.data(), t + 500, data.size(), meta);
+    }
+}
@@ -0,0 +1,69 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/log/packet_meta.h>
+#include <pangolin/log/packetstream_reader.h>
+#include <pangolin/log/packetstream_writer.h>
+
+#include <cstdio>
+#include <limits>
+
+using namespace pangolin;
+
+picojson::value ExampleMeta(int64_t i)
+{
+    picojson::value v;
+    v["exposure_us"] = picojson::value(i * 1000);
+    v["gain"] = picojson::value(1.5 + i);
+    v["auto"] = picojson::value(i % 2 == 0);
+    v["serial"] = picojson::value(std::string(40, 'x'));
+    v["big"] = picojson::value(std::numeric_limits<int64_t>::min() + i);
+    v["none"] = picojson::value();
+    v["list"] = picojson::value(picojson::array_type, false);
+    for(int64_t j=0; j < 20; ++j) v["list"].push_back(picojson::value(j - 10));
+    return v;
+}
+
+TEST_CASE("Binary metadata roundtrips through encoder") {
+    for(int64_t i=0; i < 3; ++i) {
+        const picojson::value v = ExampleMeta(i);
+        std::string bytes;
+        EncodeBinaryMeta(v, bytes);
+        REQUIRE(DecodeBinaryMeta(bytes.data(), bytes.size()) == v);
+        REQUIRE(bytes.size() < v.serialize().size());
+        REQUIRE_THROWS(DecodeBinaryMeta(bytes.data(), bytes.size() - 1));
+    }
+}
+
+TEST_CASE("Binary metadata roundtrips through packetstream") {
+    const std::string filename = "test_packet_meta.pango";
+    const char data[] = "payload";
+
+    {
+        PacketStreamWriter writer(filename);
+        writer.SetBinaryMeta(true);
+        PacketStreamSource src;
+        src.driver = "test";
+        const PacketStreamSourceId id = writer.AddSource(src);
+        for(int64_t i=0; i < 3; ++i) {
+            writer.WriteSourcePacket(id, data, i, sizeof(data), ExampleMeta(i));
+        }
+    }
+
+    {
+        PacketStreamReader reader(filename);
+        for(int64_t i=0; i < 3; ++i) {
+            Packet pkt = reader.NextFrame(0);
+            REQUIRE(pkt.Meta() == ExampleMeta(i));
+            char read[sizeof(data)];
+            pkt.Stream().read(read, sizeof(read));
+            REQUIRE(std::string(read) == data);
+        }
+    }
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/log/packetstream_edit.h>
+#include <pangolin/log/packetstream_reader.h>
+
+#include <cstdio>
+
+#include "test_log.h"
+
+using namespace pangolin;
+
+struct LogPacket
+{
+    PacketStreamSourceId src;
+    int64_t time;
+    std::string data;
+    picojson::value meta;
+};
+
+std::vector<LogPacket> ReadLog(const std::string& filename)
+{
+    std::vector<LogPacket> packets;
+    PacketStreamReader reader(filename);
+    try {
+        while(true) {
+            Packet pkt = reader.NextFrame();
+            LogPacket p{pkt.src, pkt.time, std::string(pkt.BytesRemaining(), '\0'), pkt.Meta()};
+            pkt.Stream().read(&p.data[0], p.data.size());
+            packets.push_back(p);
+        }
+    }catch(const std::runtime_error&) {
+    }
+    return packets;
+}
+
+TEST_CASE("Extract trims by frame, time and source") {
+    WriteTestLog("test_edit_in.pango");
+
+    PacketStreamSelection selection;
+    selection.frame_begin = 10;
+    selection.frame_end = 90;
+    selection.time_begin_us = 20000;
+    selection.time_end_us = 30000;
+    selection.drop_sources = {0};
+    REQUIRE(ExtractPacketStream("test_edit_in.pango", "test_edit_out.pango", selection) == 10);
+
+    const std::vector<LogPacket> packets = ReadLog("test_edit_out.pango");
+    REQUIRE(packets.size() == 10);
+    for(size_t i=0; i < packets.size(); ++i) {
+        REQUIRE(packets[i].src == 0);
+        REQUIRE(packets[i].meta["frame"].get<int64_t>() == int64_t(20 + i));
+        REQUIRE(packets[i].data == std::string((20 + i) % 7 + 1, 'a' + (20 + i) % 26));
+    }
+
+    // Output index is rebuilt for the trimmed log
+    PacketStreamReader reader("test_edit_out.pango");
+    REQUIRE(reader.Sources().size() == 1);
+    REQUIRE(reader.Sources()[0].index.size() == 10);
+
+    selection = PacketStreamSelection();
+    selection.frame_begin = 95;
+    REQUIRE(ExtractPacketStream("test_edit_in.pango", "test_edit_out.pango", selection) == 10);
+    const std::vector<LogPacket> tail = ReadLog("test_edit_out.pango");
+    REQUIRE(tail.front().src == 0);
+    REQUIRE(tail.front().data == std::string((const char*)&selection.frame_begin, sizeof(int64_t)));
+
+    std::remove("test_edit_in.pango");
+    std::remove("test_edit_out.pango");
+}
+
+TEST_CASE("Split, merge and concat roundtrip") {
+    WriteTestLog("test_edit_a.pango");
+    WriteTestLog("test_edit_b.pango", 100, 2000000);
+    const std::vector<LogPacket> original = ReadLog("test_edit_a.pango");
+
+    REQUIRE(SplitPacketStream("test_edit_a.pango", {"test_edit_0.pango", "test_edit_1.pango"}) == 200);
+    REQUIRE(ReadLog("test_edit_0.pango").size() == 100);
+    REQUIRE(ReadLog("test_edit_1.pango").size() == 100);
+
+    REQUIRE(MergePacketStreams({"test_edit_0.pango", "test_edit_1.pango"}, "test_edit_merged.pango") == 200);
+    const std::vector<LogPacket> merged = ReadLog("test_edit_merged.pango");
+    REQUIRE(merged.size() == original.size());
+    for(size_t i=0; i < merged.size(); ++i) {
+        REQUIRE(merged[i].src == original[i].src);
+        REQUIRE(merged[i].time == original[i].time);
+        REQUIRE(merged[i].data == original[i].data);
+        REQUIRE(merged[i].meta == original[i].meta);
+    }
+
+    REQUIRE(ConcatPacketStreams({"test_edit_a.pango", "test_edit_b.pango"}, "test_edit_concat.pango") == 400);
+    PacketStreamReader reader("test_edit_concat.pango");
+    REQUIRE(reader.Sources().size() == 2);
+    REQUIRE(reader.Sources()[1].index.size() == 200);
+    REQUIRE_THROWS(ConcatPacketStreams({"test_edit_a.pango", "test_edit_1.pango"}, "test_edit_concat.pango"));
+
+    for(const char* f : {"test_edit_a.pango", "test_edit_b.pango", "test_edit_0.pango", "test_edit_1.pango", "test_edit_merged.pango", "test_edit_concat.pango"}) {
+        std::remove(f);
+    }
+}
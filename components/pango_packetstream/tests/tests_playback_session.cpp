@@ -0,0 +1,61 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/log/playback_session.h>
+
+#include <cstdio>
+#include <thread>
+
+#include "test_log.h"
+
+using namespace pangolin;
+
+// Frame numbers read from src, or -1 where a packet was from the wrong source
+std::vector<int64_t> ReadSource(PacketStreamReader& reader, PacketStreamSourceId src, int64_t frames)
+{
+    std::vector<int64_t> read;
+    for(int64_t i=0; i < frames; ++i) {
+        Packet pkt = reader.NextFrame(src);
+        if(pkt.src != src) {
+            read.push_back(-1);
+        }else if(src == 0) {
+            int64_t frame = -1;
+            pkt.Stream().read((char*)&frame, sizeof(frame));
+            read.push_back(frame);
+        }else{
+            read.push_back(pkt.Meta()["frame"].get<int64_t>());
+        }
+    }
+    return read;
+}
+
+TEST_CASE("Sources of one file are read concurrently through a session") {
+    const int64_t frames = 500;
+    WriteTestLog("test_session.pango", frames);
+
+    {
+        auto session = std::make_shared<PlaybackSession>();
+        auto reader0 = session->Open("test_session.pango");
+        auto reader1 = session->Open("test_session.pango");
+        REQUIRE(reader0 != reader1);
+
+        std::vector<int64_t> read0, read1;
+        std::thread thread0([&](){ read0 = ReadSource(*reader0, 0, frames); });
+        std::thread thread1([&](){ read1 = ReadSource(*reader1, 1, frames); });
+        thread0.join();
+        thread1.join();
+
+        REQUIRE(read0.size() == size_t(frames));
+        REQUIRE(read1.size() == size_t(frames));
+        for(int64_t i=0; i < frames; ++i) {
+            REQUIRE(read0[i] == i);
+            REQUIRE(read1[i] == i);
+        }
+    }
+
+    std::remove("test_session.pango");
+}
@@ -28,8 +28,12 @@
 #pragma once
 
 #include <pangolin/platform.h>
+#include <pangolin/utils/signal_slot.h>
 
 #include <algorithm> // std::min, std::max
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <mutex>
@@ -74,6 +78,16 @@ struct DimensionStats
         max = std::max(max, v);
     }
 
+    /// Add the stats of samples which followed those already added
+    void Add(const DimensionStats& later)
+    {
+        isMonotonic = isMonotonic && later.isMonotonic && (later.min >= max);
+        sum += later.sum;
+        sum_sq += later.sum_sq;
+        min = std::min(min, later.min);
+        max = std::max(max, later.max);
+    }
+
     bool isMonotonic;
     float sum;
     float sum_sq;
@@ -81,6 +95,12 @@ struct DimensionStats
     float max;
 };
 
+/// A fixed size block of samples, linked to the next block of the log.
+/// Blocks are filled by a single producer thread without locking. Samples
+/// are written before the count is published with a release store, and
+/// readers load it with acquire, so they only ever see fully written samples.
+/// Readers must hold DataLog::access_mutex whilst they hold pointers to
+/// blocks, which may otherwise be retired.
 class DataLogBlock
 {
 public:
@@ -89,10 +109,11 @@ public:
     /// @param start_id: index of first sample (from entire dataset) in this buffer
     DataLogBlock(size_t dim, size_t max_samples, size_t start_id)
         : dim(dim), max_samples(max_samples), samples(0),
-          start_id(start_id)
+          start_id(start_id), uid(NextUid()), next(nullptr)
     {
         sample_buffer = std::unique_ptr<float[]>(new float[dim*max_samples]);
-//        stats = std::unique_ptr<DimensionStats[]>(new DimensionStats[dim]);
+        stats = std::unique_ptr<DimensionStats[]>(new DimensionStats[dim]);
+        stats_samples = 0;
     }
 
     ~DataLogBlock()
@@ -101,7 +122,7 @@ public:
 
     size_t Samples() const
     {
-        return samples;
+        return samples.load(std::memory_order_acquire);
     }
 
     size_t MaxSamples() const
@@ -120,19 +141,22 @@ public:
         return Samples() >= MaxSamples();
     }
 
-    /// Add data to block
+    /// Add data to block, creating new linked blocks as needed
     void AddSamples(size_t num_samples, size_t dimensions, const float* data_dim_major );
 
+    /// Add as many samples as will fit into this block only.
+    /// Returns the number of samples added.
+    size_t CopySamples(size_t num_samples, size_t dimensions, const float* data_dim_major );
+
     /// Delete all samples
     void ClearLinked()
     {
-        samples = 0;
-        nextBlock.reset();
+        Recycle(start_id);
     }
 
     DataLogBlock* NextBlock() const
     {
-        return nextBlock.get();
+        return next.load(std::memory_order_acquire);
     }
 
     size_t StartId() const
@@ -150,15 +174,30 @@ public:
         return dim;
     }
 
+    /// Unique id for this block, which is never reused even if the memory of
+    /// a deleted block is. Useful for keying caches of block data.
+    uint64_t Uid() const
+    {
+        return uid;
+    }
+
+    /// Statistics of the samples held in this block only, ignoring NaN's.
+    /// Like other reads, hold DataLog::access_mutex whilst calling this.
+    DimensionStats Stats(size_t d) const
+    {
+        UpdateStats();
+        return stats[d];
+    }
+
     const float* Sample(size_t n) const
     {
         const int id = (int)n - (int)start_id;
 
-        if( 0 <= id && id < (int)samples ) {
+        if( 0 <= id && id < (int)Samples() ) {
             return sample_buffer.get() + dim*id;
         }else{
-            if(nextBlock) {
-                return nextBlock->Sample(n);
+            if(NextBlock()) {
+                return NextBlock()->Sample(n);
             }else{
                 throw std::out_of_range("Index out of range.");
             }
@@ -166,25 +205,61 @@ public:
     }
 
 protected:
+    friend class DataLog;
+
+    static uint64_t NextUid();
+
+    /// Take ownership of block and publish it to readers
+    void SetNextBlock(std::unique_ptr<DataLogBlock> block)
+    {
+        nextBlock = std::move(block);
+        next.store(nextBlock.get(), std::memory_order_release);
+    }
+
+    /// Make block empty and unlinked for reuse from sample id start_id
+    void Recycle(size_t new_start_id);
+
+    /// Add samples published since the last call to stats
+    void UpdateStats() const;
+
     size_t dim;
     size_t max_samples;
-    size_t samples;
+    std::atomic<size_t> samples;
     size_t start_id;
+    uint64_t uid;
     std::unique_ptr<float[]> sample_buffer;
-//    std::unique_ptr<DimensionStats[]> stats;
+    // Computed by readers from published samples, so that the producer never
+    // touches them. Guarded by DataLog::access_mutex.
+    mutable std::unique_ptr<DimensionStats[]> stats;
+    mutable size_t stats_samples;
     std::unique_ptr<DataLogBlock> nextBlock;
+    std::atomic<DataLogBlock*> next;
 };
 
 /// A DataLog can efficiently record floating point sample data of any size.
 /// Memory is allocated in blocks is transparent to the user.
+///
+/// Log() should be called from a single producer thread. Appending samples
+/// takes no locks: readers such as Plotter must hold access_mutex whilst they
+/// use FirstBlock(), LastBlock(), Sample() or Stats(), and the producer only
+/// ever try_lock's it in order to retire old blocks. Stats are computed by
+/// readers from the published samples. Listeners registered for changes are
+/// still called from Log(), and may lock what they need.
 class PANGOLIN_EXPORT DataLog
 {
 public:
     /// @param block_samples_alloc number of samples each memory block can hold.
-    DataLog(unsigned int block_samples_alloc = 10000 );
+    /// @param max_blocks if non-zero, retain at most this many blocks (at
+    ///        least 2), recycling the memory of the oldest block.
+    DataLog(unsigned int block_samples_alloc = 10000, unsigned int max_blocks = 0 );
 
     ~DataLog();
 
+    /// Limit memory use to max_blocks * block_samples_alloc samples, oldest
+    /// first. 0 means unlimited. May be exceeded briefly if a reader holds
+    /// access_mutex when a new block is needed.
+    void SetMaxBlocks(unsigned int max_blocks);
+
     /// Provide textual labels corresponding to each dimension logged.
     /// This information may be used by graphical interfaces to DataLog.
     void SetLabels(const std::vector<std::string> & labels);
@@ -220,24 +295,42 @@ public:
     // Return last block of stored data
     const DataLogBlock* LastBlock() const;
 
-    // Return number of samples stored in this DataLog
+    // Return number of samples logged to this DataLog, including any which
+    // are no longer retained.
     size_t Samples() const;
 
     // Return pointer to stored sample n
     const float* Sample(int n) const;
 
-    // Return stats computed for each dimension if enabled.
-    const DimensionStats& Stats(size_t dim) const;
+    // Return stats of every sample logged in dimension dim, including any
+    // which are no longer retained, ignoring NaN's. Hold access_mutex whilst
+    // calling this from threads other than the producer.
+    DimensionStats Stats(size_t dim) const;
+
+    // Register to be called, on the logging thread, whenever samples are
+    // logged or cleared, e.g. to redraw a plot of them.
+    sigslot::connection RegisterForChanges(std::function<void()> callback_function);
 
     std::mutex access_mutex;
 
 protected:
+    // Link a new (or recycled) block with dim dimensions after blockn
+    void AppendBlock(size_t dim);
+
+    // Retire oldest blocks to leave space for space more within max_blocks,
+    // returning one with dim dimensions for reuse if available.
+    // Does nothing if access_mutex is held by a reader.
+    std::unique_ptr<DataLogBlock> TryRetireBlocks(size_t space, size_t dim);
+
     unsigned int block_samples_alloc;
+    std::atomic<unsigned int> max_blocks;
     std::vector<std::string> labels;
     std::unique_ptr<DataLogBlock> block0;
-    DataLogBlock* blockn;
-    std::vector<DimensionStats> stats;
-    bool record_stats;
+    std::atomic<DataLogBlock*> blockn;
+    size_t num_blocks;
+    // Stats of retired blocks. Guarded by access_mutex.
+    std::vector<DimensionStats> retired_stats;
+    sigslot::signal<> changed_signal;
 };
 
 }
@@ -39,6 +39,7 @@
 #include <pangolin/utils/range.h>
 #include <pangolin/plot/datalog.h>
 
+#include <map>
 #include <set>
 
 namespace pangolin
@@ -219,6 +220,10 @@ protected:
         GlSlProgram prog;
         GlText title;
         bool contains_id;
+        // Series id when x / y is a plain "$i" (-1) or "$N" (N) expression,
+        // or INT_MIN otherwise. Used for culling and decimation.
+        int x_id;
+        int y_id;
         std::vector<PlotAttrib> attribs;
         DataLog* log;
         GLenum drawing_mode;
@@ -243,11 +248,40 @@ protected:
         GlSlProgram prog;
     };
 
+    // Min / max envelope of one dimension of a DataLogBlock, two vertices
+    // (sample id, value) per complete bucket of samples.
+    struct PANGOLIN_EXPORT DecimatedLevel
+    {
+        DecimatedLevel() : buckets(0) {}
+        GlBuffer vbo;
+        size_t buckets;
+    };
+
+    // GPU resident copy of a DataLogBlock. Since blocks are append-only, only
+    // newly logged samples need to be uploaded each frame.
+    struct PANGOLIN_EXPORT BlockCache
+    {
+        BlockCache() : uploaded(0), used(false) {}
+        GlBuffer samples;
+        size_t uploaded;
+        // Keyed by (dimension, bucket size)
+        std::map<std::pair<int,size_t>, DecimatedLevel> decimated;
+        bool used;
+    };
+
+    BlockCache& SyncBlockCache(const DataLogBlock& block);
+    DecimatedLevel& SyncDecimatedLevel(BlockCache& cache, const DataLogBlock& block, int dim, size_t bucket);
+    bool BlockInView(const PlotSeries& ps, const DataLogBlock& block) const;
+
     void FixSelection();
     void UpdateView();
     Tick FindTickFactor(float tick);
 
+    // Request a redraw whenever log changes, if not already
+    void WatchLog(DataLog* log);
+
     DataLog* default_log;
+    std::map<DataLog*, sigslot::scoped_connection> log_connections;
 
     ColourWheel colour_wheel;
     Colour colour_bg;
@@ -258,6 +292,8 @@ protected:
     GlSlProgram prog_text;
 
     std::vector<PlotSeries> plotseries;
+    std::map<uint64_t, BlockCache> block_cache;
+    GlBuffer id_buffer;
     std::vector<Marker> plotmarkers;
     std::vector<PlotImplicit> plotimplicits;
 
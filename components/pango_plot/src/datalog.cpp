@@ -28,6 +28,8 @@
 #include <pangolin/plot/datalog.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
 #include <limits>
 
@@ -36,55 +38,91 @@ namespace pangolin
 
 void DataLogBlock::AddSamples(size_t num_samples, size_t dimensions, const float* data_dim_major )
 {
-    if(nextBlock) {
+    if(NextBlock()) {
         // If next block exists, add to it instead
-        nextBlock->AddSamples(num_samples, dimensions, data_dim_major);
+        NextBlock()->AddSamples(num_samples, dimensions, data_dim_major);
     }else{
         if(dimensions > dim) {
             // If dimensions is too high for this block, start a new bigger one
-            nextBlock = std::unique_ptr<DataLogBlock>(new DataLogBlock(dimensions, max_samples, start_id + samples));
-            nextBlock->AddSamples(num_samples,dimensions,data_dim_major);
+            SetNextBlock(std::unique_ptr<DataLogBlock>(new DataLogBlock(dimensions, max_samples, start_id + Samples())));
+            NextBlock()->AddSamples(num_samples,dimensions,data_dim_major);
         }else{
-            // Try to copy samples to this block
-            const size_t samples_to_copy = std::min(num_samples, SampleSpaceLeft());
-
-            if(dimensions == dim) {
-                // Copy entire block all together
-                std::copy(data_dim_major, data_dim_major + samples_to_copy*dim, sample_buffer.get()+samples*dim);
-                samples += samples_to_copy;
-                data_dim_major += samples_to_copy*dim;
-            }else{
-                // Copy sample at a time, filling with NaN's where needed.
-                float* dst = sample_buffer.get();
-                for(size_t i=0; i< samples_to_copy; ++i) {
-                    std::copy(data_dim_major, data_dim_major + dimensions, dst);
-                    for(size_t ii = dimensions; ii < dim; ++ii) {
-                        dst[ii] = std::numeric_limits<float>::quiet_NaN();
-                    }
-                    dst += dimensions;
-                    data_dim_major += dimensions;
-                }
-                samples += samples_to_copy;
+            const size_t samples_copied = CopySamples(num_samples, dimensions, data_dim_major);
+
+            // Copy remaining data to next block (this one is full)
+            if(samples_copied < num_samples) {
+                SetNextBlock(std::unique_ptr<DataLogBlock>(new DataLogBlock(dim, max_samples, start_id + Samples())));
+                NextBlock()->AddSamples(num_samples-samples_copied, dimensions, data_dim_major + samples_copied*dimensions);
             }
+        }
+    }
+}
 
-//            // Update Stats
-//            for(size_t s=0; s < samples_to_copy; ++s) {
-//                for(size_t d = 0; d < dimensions; ++d) {
-//                    stats[d].Add(data_dim_major[s*dim + d]);
-//                }
-//            }
+size_t DataLogBlock::CopySamples(size_t num_samples, size_t dimensions, const float* data_dim_major )
+{
+    if(dimensions > dim) return 0;
 
-            // Copy remaining data to next block (this one is full)
-            if(samples_to_copy < num_samples) {
-                nextBlock = std::unique_ptr<DataLogBlock>(new DataLogBlock(dim, max_samples, start_id + Samples()));
-                nextBlock->AddSamples(num_samples-samples_to_copy, dimensions, data_dim_major);
+    // Only the producer modifies samples, so a relaxed load is sufficient
+    const size_t cur_samples = samples.load(std::memory_order_relaxed);
+    const size_t samples_to_copy = std::min(num_samples, max_samples - cur_samples);
+    float* dst = sample_buffer.get() + cur_samples*dim;
+
+    if(dimensions == dim) {
+        // Copy entire block all together
+        std::copy(data_dim_major, data_dim_major + samples_to_copy*dim, dst);
+    }else{
+        // Copy sample at a time, filling with NaN's where needed.
+        for(size_t i=0; i< samples_to_copy; ++i) {
+            std::copy(data_dim_major, data_dim_major + dimensions, dst);
+            for(size_t ii = dimensions; ii < dim; ++ii) {
+                dst[ii] = std::numeric_limits<float>::quiet_NaN();
             }
+            dst += dim;
+            data_dim_major += dimensions;
         }
     }
+
+    // Publish new samples to readers
+    samples.store(cur_samples + samples_to_copy, std::memory_order_release);
+
+    return samples_to_copy;
 }
 
-DataLog::DataLog(unsigned int buffer_size)
-    : block_samples_alloc(buffer_size), block0(nullptr), blockn(nullptr), record_stats(true)
+void DataLogBlock::Recycle(size_t new_start_id)
+{
+    samples = 0;
+    start_id = new_start_id;
+    uid = NextUid();
+    for(size_t d=0; d < dim; ++d) {
+        stats[d].Reset();
+    }
+    stats_samples = 0;
+    SetNextBlock(nullptr);
+}
+
+void DataLogBlock::UpdateStats() const
+{
+    const size_t n = Samples();
+    for(size_t s = stats_samples; s < n; ++s) {
+        const float* sample = sample_buffer.get() + s*dim;
+        for(size_t d = 0; d < dim; ++d) {
+            // Dimensions not logged with a sample are NaN padding
+            if(!std::isnan(sample[d])) {
+                stats[d].Add(sample[d]);
+            }
+        }
+    }
+    stats_samples = n;
+}
+
+uint64_t DataLogBlock::NextUid()
+{
+    static std::atomic<uint64_t> next_uid(1);
+    return next_uid++;
+}
+
+DataLog::DataLog(unsigned int buffer_size, unsigned int max_blocks)
+    : block_samples_alloc(buffer_size), max_blocks(max_blocks), block0(nullptr), blockn(nullptr), num_blocks(0)
 {
 }
 
@@ -93,6 +131,11 @@ DataLog::~DataLog()
     Clear();
 }
 
+void DataLog::SetMaxBlocks(unsigned int new_max_blocks)
+{
+    max_blocks = new_max_blocks;
+}
+
 void DataLog::SetLabels(const std::vector<std::string> & new_labels)
 {
     std::lock_guard<std::mutex> l(access_mutex);
@@ -115,28 +158,82 @@ void DataLog::Log(size_t dimension, const float* vals, unsigned int samples )
 {
     if(!block0) {
         // Create first block
+        std::lock_guard<std::mutex> l(access_mutex);
         block0 = std::unique_ptr<DataLogBlock>(new DataLogBlock(dimension, block_samples_alloc, 0));
         blockn = block0.get();
+        num_blocks = 1;
+    }
+
+    const unsigned int retain_blocks = max_blocks;
+    if(retain_blocks && num_blocks > retain_blocks) {
+        // Catch up on blocks we couldn't retire earlier
+        TryRetireBlocks(0, 0);
     }
 
-    if(record_stats) {
-        while(stats.size() < dimension) {
-            stats.push_back( DimensionStats() );
+    while(samples) {
+        DataLogBlock* block = blockn.load(std::memory_order_relaxed);
+        if(dimension > block->Dimensions() || block->IsFull()) {
+            AppendBlock(std::max(dimension, block->Dimensions()));
+            block = blockn.load(std::memory_order_relaxed);
         }
-        for(unsigned int d=0; d<dimension; ++d) {
-            DimensionStats& ds = stats[d];
-            for(unsigned int s=0; s<samples; ++s) {
-                ds.Add(vals[s*dimension+d]);
+
+        const size_t copied = block->CopySamples(samples, dimension, vals);
+        samples -= (unsigned int)copied;
+        vals += copied * dimension;
+    }
+
+    changed_signal();
+}
+
+std::unique_ptr<DataLogBlock> DataLog::TryRetireBlocks(size_t space, size_t dim)
+{
+    std::unique_ptr<DataLogBlock> recycled;
+    const unsigned int retain_blocks = max_blocks;
+    const size_t keep_blocks = std::max(2u, retain_blocks);
+
+    // Only retire blocks if no reader is traversing them. Otherwise leave
+    // it for next time rather than stall the producer.
+    if(retain_blocks && num_blocks + space > keep_blocks && access_mutex.try_lock()) {
+        while(num_blocks + space > keep_blocks) {
+            std::unique_ptr<DataLogBlock> oldest = std::move(block0);
+            block0 = std::move(oldest->nextBlock);
+            if(retired_stats.size() < oldest->Dimensions()) {
+                retired_stats.resize(oldest->Dimensions());
+            }
+            for(size_t d=0; d < oldest->Dimensions(); ++d) {
+                retired_stats[d].Add(oldest->Stats(d));
+            }
+            oldest->next.store(nullptr, std::memory_order_release);
+            --num_blocks;
+
+            if(!recycled && oldest->Dimensions() == dim && oldest->MaxSamples() == block_samples_alloc) {
+                recycled = std::move(oldest);
             }
         }
+        access_mutex.unlock();
     }
 
-    blockn->AddSamples(samples,dimension,vals);
+    return recycled;
+}
+
+void DataLog::AppendBlock(size_t dim)
+{
+    DataLogBlock* tail = blockn.load(std::memory_order_relaxed);
+    const size_t start_id = tail->StartId() + tail->Samples();
 
-    // Update pointer to most recent block.
-    while(blockn->NextBlock()) {
-        blockn = blockn->NextBlock();
+    // Make room for the new block, reusing the memory of the oldest if we can
+    std::unique_ptr<DataLogBlock> block = TryRetireBlocks(1, dim);
+
+    if(block) {
+        block->Recycle(start_id);
+    }else{
+        block = std::unique_ptr<DataLogBlock>(new DataLogBlock(dim, block_samples_alloc, start_id));
     }
+
+    DataLogBlock* new_tail = block.get();
+    tail->SetNextBlock(std::move(block));
+    blockn.store(new_tail, std::memory_order_release);
+    ++num_blocks;
 }
 
 void DataLog::Log(float v)
@@ -207,8 +304,10 @@ void DataLog::Clear()
 
     blockn = nullptr;
     block0 = nullptr;
+    num_blocks = 0;
+    retired_stats.clear();
 
-    stats.clear();
+    changed_signal();
 }
 
 void DataLog::Save(std::string filename)
@@ -226,9 +325,12 @@ void DataLog::Save(std::string filename)
 
   }
 
+  // Prevent blocks from being retired whilst we write them out
+  std::lock_guard<std::mutex> l(access_mutex);
+
   const DataLogBlock * block = FirstBlock();
 
-  size_t i = 0;
+  size_t i = block ? block->StartId() : 0;
 
   while (block) {
 
@@ -261,18 +363,30 @@ const DataLogBlock* DataLog::FirstBlock() const
 
 const DataLogBlock* DataLog::LastBlock() const
 {
-    return blockn;
+    return blockn.load(std::memory_order_acquire);
+}
+
+sigslot::connection DataLog::RegisterForChanges(std::function<void()> callback_function)
+{
+    return changed_signal.connect(callback_function);
 }
 
-const DimensionStats& DataLog::Stats(size_t dim) const
+DimensionStats DataLog::Stats(size_t dim) const
 {
-    return stats[dim];
+    DimensionStats stats = dim < retired_stats.size() ? retired_stats[dim] : DimensionStats();
+    for(const DataLogBlock* block = FirstBlock(); block; block = block->NextBlock()) {
+        if(dim < block->Dimensions()) {
+            stats.Add(block->Stats(dim));
+        }
+    }
+    return stats;
 }
 
 size_t DataLog::Samples() const
 {
-    if(blockn) {
-        return blockn->StartId() + blockn->Samples();
+    const DataLogBlock* block = LastBlock();
+    if(block) {
+        return block->StartId() + block->Samples();
     }
     return 0;
 }
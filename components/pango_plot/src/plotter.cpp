@@ -28,6 +28,7 @@
 #include <pangolin/gl/gldraw.h>
 #include <pangolin/plot/plotter.h>
 #include <pangolin/display/default_font.h>
+#include <pangolin/display/display.h>
 
 #include <cctype>
 #include <iomanip>
@@ -65,8 +66,23 @@ std::set<int> ConvertSequences(const std::string& str, char seq_char='$', char i
     return sequences;
 }
 
+// Series id for plain "$i" (-1) or "$N" (N) expressions, otherwise SeriesIdComplex
+const int SeriesIdComplex = std::numeric_limits<int>::min();
+int SimpleSeriesId(const std::string& expr)
+{
+    if(expr == "$i") return -1;
+    if(expr.size() < 2 || expr[0] != '$') return SeriesIdComplex;
+    for(size_t i=1; i < expr.size(); ++i) {
+        if(!std::isdigit(expr[i])) return SeriesIdComplex;
+    }
+    return std::stoi(expr.substr(1));
+}
+
+// Smallest number of samples per pixel for which we draw a min / max envelope
+const size_t MinDecimationBucket = 4;
+
 Plotter::PlotSeries::PlotSeries()
-    : log(nullptr), drawing_mode(GL_LINE_STRIP)
+    : x_id(SeriesIdComplex), y_id(SeriesIdComplex), log(nullptr), drawing_mode(GL_LINE_STRIP)
 {
 
 }
@@ -107,6 +123,8 @@ void Plotter::PlotSeries::CreatePlot(const std::string &x, const std::string &y,
     as.insert(ax.begin(), ax.end());
     as.insert(ay.begin(), ay.end());
     contains_id = ( as.find(-1) != as.end() );
+    x_id = SimpleSeriesId(x);
+    y_id = SimpleSeriesId(y);
 
     std::ostringstream oss_prog;
 
@@ -280,6 +298,8 @@ Plotter::Plotter(
 
     const size_t RESERVED_SIZE = 100;
 
+    if(log) WatchLog(log);
+
     // Setup default PlotSeries
     plotseries.reserve(RESERVED_SIZE);
     for(unsigned int i=0; i< 10; ++i) {
@@ -320,15 +340,18 @@ template <typename T> int data_sgn(T val) {
 
 void Plotter::ComputeTrackValue( float track_val[2] )
 {
+    // Prevent blocks from being retired whilst we read them
+    std::lock_guard<std::mutex> l(default_log->access_mutex);
+
     if(trigger_edge) {
         // Track last edge transition matching trigger_edge
         const DataLogBlock* block = default_log->LastBlock();
-        if(block) {
+        if(block && block->Samples()) {
             int s = (int)block->StartId() + (int)block->Samples() - 1;
             const size_t dim = block->Dimensions();
             const float* data = block->Sample(s);
             int last_sgn = 0;
-            for(; s >= 0; --s, data -= dim )
+            for(; s >= (int)block->StartId(); --s, data -= dim )
             {
                 const float val = data[0] - trigger_value;
                 const int sgn = data_sgn(val);
@@ -352,6 +375,7 @@ XYRangef Plotter::ComputeAutoSelection()
     XYRangef range;
     range.x = target.x;
 
+    std::lock_guard<std::mutex> l(default_log->access_mutex);
     const DataLogBlock* block = default_log->FirstBlock();
 
     if(block) {
@@ -360,8 +384,9 @@ XYRangef Plotter::ComputeAutoSelection()
             if( plotseries[i].attribs.size() == 2 && plotseries[i].attribs[0].plot_id == -1) {
                 const int id = plotseries[i].attribs[1].plot_id;
                 if( 0<= id && id < (int)block->Dimensions()) {
-                    range.y.Insert(default_log->Stats(id).min);
-                    range.y.Insert(default_log->Stats(id).max);
+                    const DimensionStats stats = default_log->Stats(id);
+                    range.y.Insert(stats.min);
+                    range.y.Insert(stats.max);
                 }
             }
 
@@ -503,8 +528,14 @@ void Plotter::Render()
     //////////////////////////////////////////////////////////////////////////
     // Draw series
 
-    static size_t id_size = 0;
-    static float* id_array = 0;
+    // When x is the sample id, this is how many samples fall within a pixel
+    const float samples_per_pixel = w / v.w;
+    const float xmin = std::min(rview.x.min, rview.x.max);
+    const float xmax = std::max(rview.x.min, rview.x.max);
+
+    for(auto& bc : block_cache) {
+        bc.second.used = false;
+    }
 
     for(size_t i=0; i < plotseries.size(); ++i)
     {
@@ -520,58 +551,102 @@ void Plotter::Render()
             prog.SetUniform("u_offset", ox, oy);
             prog.SetUniform("u_color", ps.colour );
 
-            // TODO: Try to skip drawing of blocks which aren't in view.
+            // Only new samples are uploaded; everything else is drawn from GPU memory.
             DataLog* log = ps.log ? ps.log : default_log;
             std::lock_guard<std::mutex> l(log->access_mutex);
 
-            const DataLogBlock* block = log->FirstBlock();
-            while(block) {
-                if(ps.contains_id ) {
-                    if(id_size < block->Samples() ) {
-                        // Create index array that we can bind
-                        delete[] id_array;
-                        id_size = block->MaxSamples();
-                        id_array = new float[id_size];
-                        for(size_t k=0; k < id_size; ++k) {
-                            id_array[k] = (float)k;
-                        }
-                    }
+            for(const DataLogBlock* block = log->FirstBlock(); block; block = block->NextBlock()) {
+                // Check all referenced series exist in this block
+                bool shouldRender = block->Samples() > 0;
+                for(size_t a=0; a < ps.attribs.size(); ++a) {
+                    shouldRender = shouldRender && ps.attribs[a].plot_id < (int)block->Dimensions();
+                }
+                if(!shouldRender) continue;
+                ps.used = true;
+
+                // Keep GPU copy of blocks which are still in the log, even if they aren't in view.
+                auto cached = block_cache.find(block->Uid());
+                if(cached != block_cache.end()) cached->second.used = true;
+
+                if(!BlockInView(ps, *block)) continue;
+
+                BlockCache& cache = SyncBlockCache(*block);
+                const size_t dims = block->Dimensions();
+
+                if(ps.contains_id) {
                     prog.SetUniform("u_id_offset",  (float)block->StartId() );
                 }
 
-                // Enable appropriate attributes
-                bool shouldRender = true;
-                for(size_t i=0; i< ps.attribs.size(); ++i) {
-                    if(0 <= ps.attribs[i].plot_id && ps.attribs[i].plot_id < (int)block->Dimensions() ) {
-                        glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, (GLsizei)(block->Dimensions()*sizeof(float)), block->DimData(ps.attribs[i].plot_id) );
-                        glEnableVertexAttribArray(ps.attribs[i].location);
-                    }else if( ps.attribs[i].plot_id == -1 ){
-                        glVertexAttribPointer(ps.attribs[i].location, 1, GL_FLOAT, GL_FALSE, 0, id_array );
-                        glEnableVertexAttribArray(ps.attribs[i].location);
-                    }else{
-                        // bad id: don't render
-                        shouldRender = false;
-                        break;
-                    }
+                // Restrict to samples in view when x is the sample id
+                size_t first = 0;
+                size_t last = block->Samples();
+                if(ps.x_id == -1) {
+                    const float start = (float)block->StartId();
+                    first = (size_t)std::clamp(std::floor(xmin - start) - 1.0f, 0.0f, (float)last);
+                    last  = (size_t)std::clamp(std::ceil(xmax - start) + 2.0f, 0.0f, (float)last);
                 }
 
-                if(shouldRender) {
-                    // Draw geometry
-                    glDrawArrays(ps.drawing_mode, 0, (GLsizei)block->Samples());
-                    ps.used = true;
+                // When zoomed out, draw the min / max of each bucket of samples that
+                // fall within a pixel, which bounds the number of vertices drawn.
+                size_t bucket = 1;
+                if(ps.x_id == -1 && ps.y_id >= 0) {
+                    while(bucket*2 <= samples_per_pixel) bucket *= 2;
                 }
 
-                // Disable enabled attributes
-                for(size_t i=0; i< ps.attribs.size(); ++i) {
-                    glDisableVertexAttribArray(ps.attribs[i].location);
+                if(bucket >= MinDecimationBucket) {
+                    DecimatedLevel& level = SyncDecimatedLevel(cache, *block, ps.y_id, bucket);
+                    const size_t b0 = std::min(first / bucket, level.buckets);
+                    const size_t b1 = std::min((last + bucket - 1) / bucket, level.buckets);
+
+                    if(b0 < b1) {
+                        level.vbo.Bind();
+                        for(size_t a=0; a< ps.attribs.size(); ++a) {
+                            const size_t offset = ps.attribs[a].plot_id == -1 ? 0 : sizeof(float);
+                            glVertexAttribPointer(ps.attribs[a].location, 1, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)offset );
+                            glEnableVertexAttribArray(ps.attribs[a].location);
+                        }
+                        glDrawArrays(ps.drawing_mode, (GLint)(2*b0), (GLsizei)(2*(b1-b0)));
+                        for(size_t a=0; a< ps.attribs.size(); ++a) {
+                            glDisableVertexAttribArray(ps.attribs[a].location);
+                        }
+                        level.vbo.Unbind();
+                    }
+
+                    // Samples which don't yet fill a bucket are drawn as-is
+                    first = std::max(first, level.buckets * bucket);
                 }
 
-                block = block->NextBlock();
+                if(first < last) {
+                    for(size_t a=0; a< ps.attribs.size(); ++a) {
+                        if( ps.attribs[a].plot_id == -1 ) {
+                            id_buffer.Bind();
+                            glVertexAttribPointer(ps.attribs[a].location, 1, GL_FLOAT, GL_FALSE, 0, 0 );
+                        }else{
+                            cache.samples.Bind();
+                            glVertexAttribPointer(ps.attribs[a].location, 1, GL_FLOAT, GL_FALSE, (GLsizei)(dims*sizeof(float)), (void*)(ps.attribs[a].plot_id*sizeof(float)) );
+                        }
+                        glEnableVertexAttribArray(ps.attribs[a].location);
+                    }
+                    glDrawArrays(ps.drawing_mode, (GLint)first, (GLsizei)(last-first));
+                    for(size_t a=0; a< ps.attribs.size(); ++a) {
+                        glDisableVertexAttribArray(ps.attribs[a].location);
+                    }
+                    glBindBuffer(GL_ARRAY_BUFFER, 0);
+                }
             }
             prog.Unbind();
         }
     }
 
+    // Release GPU memory for blocks which have gone (e.g. DataLog::Clear())
+    for(auto it = block_cache.begin(); it != block_cache.end(); ) {
+        if(it->second.used) {
+            ++it;
+        }else{
+            it = block_cache.erase(it);
+        }
+    }
+
     prog_lines.SaveBind();
 
     //////////////////////////////////////////////////////////////////////////
@@ -671,6 +746,102 @@ void Plotter::Render()
 
 }
 
+Plotter::BlockCache& Plotter::SyncBlockCache(const DataLogBlock& block)
+{
+    BlockCache& cache = block_cache[block.Uid()];
+    cache.used = true;
+
+    const size_t dims = block.Dimensions();
+    const size_t samples = block.Samples();
+
+    if(!cache.samples.IsValid()) {
+        cache.samples.Reinitialise(GlArrayBuffer, (GLuint)block.MaxSamples(), GL_FLOAT, (GLuint)dims, GL_DYNAMIC_DRAW);
+    }
+
+    if(cache.uploaded < samples) {
+        cache.samples.Upload(
+            block.DimData(0) + cache.uploaded*dims,
+            (samples - cache.uploaded)*dims*sizeof(float),
+            cache.uploaded*dims*sizeof(float)
+        );
+        cache.uploaded = samples;
+    }
+
+    if(id_buffer.num_elements < block.MaxSamples()) {
+        // Sample index within block, for '$i'
+        std::vector<float> ids(block.MaxSamples());
+        for(size_t k=0; k < ids.size(); ++k) {
+            ids[k] = (float)k;
+        }
+        id_buffer.Reinitialise(GlArrayBuffer, (GLuint)ids.size(), GL_FLOAT, 1, GL_STATIC_DRAW, ids.data());
+    }
+
+    return cache;
+}
+
+Plotter::DecimatedLevel& Plotter::SyncDecimatedLevel(BlockCache& cache, const DataLogBlock& block, int dim, size_t bucket)
+{
+    DecimatedLevel& level = cache.decimated[std::make_pair(dim, bucket)];
+
+    if(!level.vbo.IsValid()) {
+        level.vbo.Reinitialise(GlArrayBuffer, (GLuint)(2*(block.MaxSamples() / bucket)), GL_FLOAT, 2, GL_DYNAMIC_DRAW);
+    }
+
+    const size_t complete = block.Samples() / bucket;
+    if(level.buckets < complete) {
+        const size_t dims = block.Dimensions();
+        const float* data = block.DimData(dim);
+
+        std::vector<float> verts;
+        verts.reserve(4*(complete - level.buckets));
+        for(size_t b = level.buckets; b < complete; ++b) {
+            float vmin = std::numeric_limits<float>::quiet_NaN();
+            float vmax = std::numeric_limits<float>::quiet_NaN();
+            for(size_t k = b*bucket; k < (b+1)*bucket; ++k) {
+                const float val = data[k*dims];
+                if(!std::isnan(val)) {
+                    if(std::isnan(vmin) || val < vmin) vmin = val;
+                    if(std::isnan(vmax) || val > vmax) vmax = val;
+                }
+            }
+            const float x = (float)(b*bucket) + 0.5f*(float)bucket;
+            verts.insert(verts.end(), {x, vmin, x, vmax});
+        }
+
+        level.vbo.Upload(verts.data(), verts.size()*sizeof(float), 4*level.buckets*sizeof(float));
+        level.buckets = complete;
+    }
+
+    return level;
+}
+
+bool Plotter::BlockInView(const PlotSeries& ps, const DataLogBlock& block) const
+{
+    // Find range of block for plain series expressions, returning false if unknown
+    auto series_range = [&](int id, float& rmin, float& rmax) {
+        if(id == -1) {
+            rmin = (float)block.StartId();
+            rmax = (float)(block.StartId() + block.Samples());
+            return true;
+        }else if(id >= 0) {
+            const DimensionStats stats = block.Stats(id);
+            rmin = stats.min;
+            rmax = stats.max;
+            return true;
+        }
+        return false;
+    };
+
+    float rmin, rmax;
+    if(series_range(ps.x_id, rmin, rmax) && (rmax < std::min(rview.x.min,rview.x.max) || rmin > std::max(rview.x.min,rview.x.max))) {
+        return false;
+    }
+    if(series_range(ps.y_id, rmin, rmax) && (rmax < std::min(rview.y.min,rview.y.max) || rmin > std::max(rview.y.min,rview.y.max))) {
+        return false;
+    }
+    return true;
+}
+
 Plotter::Tick Plotter::FindTickFactor(float tick)
 {
     Plotter::Tick ret;
@@ -1119,6 +1290,18 @@ void Plotter::AddSeries(const std::string& x_expr, const std::string& y_expr,
     plotseries.back().CreatePlot(x_expr, y_expr, colour, (title == "$y") ? PlotTitleFromExpr(y_expr) : title);
     plotseries.back().log = log;
     plotseries.back().drawing_mode = (GLenum)drawing_mode;
+    if(log) WatchLog(log);
+}
+
+void Plotter::WatchLog(DataLog* log)
+{
+    if(log_connections.find(log) == log_connections.end()) {
+        // A cached plotter must be redrawn too, not just the window
+        log_connections[log] = log->RegisterForChanges([this](){
+            Invalidate();
+            RequestRedraw();
+        });
+    }
 }
 
 std::string Plotter::PlotTitleFromExpr(const std::string& expr) const
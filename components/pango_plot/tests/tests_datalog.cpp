@@ -0,0 +1,72 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/plot/datalog.h>
+
+#include <thread>
+
+// Intended to also be run under ThreadSanitizer (-fsanitize=thread)
+TEST_CASE( "DataLog can be read whilst it is logged to and retires blocks" )
+{
+    const size_t num_samples = 200000;
+    pangolin::DataLog log(100, 4);
+
+    std::atomic<bool> done(false);
+    bool consistent = true;
+    size_t walks = 0;
+
+    // Traverse blocks as Plotter does, checking every sample is the index it
+    // was logged at.
+    std::thread reader([&](){
+        while(!done) {
+            std::lock_guard<std::mutex> l(log.access_mutex);
+            size_t blocks = 0;
+            for(const pangolin::DataLogBlock* block = log.FirstBlock(); block; block = block->NextBlock()) {
+                const size_t n = block->Samples();
+                for(size_t i=0; i < n; ++i) {
+                    const float* s = block->Sample(block->StartId() + i);
+                    consistent = consistent && s[0] == (float)(block->StartId() + i) && s[1] == -s[0];
+                }
+                const pangolin::DimensionStats stats = block->Stats(0);
+                consistent = consistent && (n == 0 || stats.min == (float)block->StartId());
+                ++blocks;
+            }
+            const pangolin::DimensionStats stats = log.Stats(0);
+            consistent = consistent && (!blocks || stats.min == 0.0f);
+            ++walks;
+        }
+    });
+
+    // Change the limit whilst logging
+    std::thread limiter([&](){
+        for(unsigned int i=0; !done; ++i) {
+            log.SetMaxBlocks(2 + i % 4);
+            std::this_thread::yield();
+        }
+    });
+
+    for(size_t i=0; i < num_samples; ++i) {
+        log.Log((float)i, -(float)i);
+    }
+    done = true;
+    reader.join();
+    limiter.join();
+
+    REQUIRE(consistent);
+    REQUIRE(walks > 0);
+    REQUIRE(log.Samples() == num_samples);
+    REQUIRE(log.Stats(0).max == (float)(num_samples-1));
+
+    // Everything is retired beyond the limit once readers let go
+    log.SetMaxBlocks(2);
+    log.Log(0.0f, 0.0f);
+    size_t blocks = 0;
+    for(const pangolin::DataLogBlock* block = log.FirstBlock(); block; block = block->NextBlock()) {
+        ++blocks;
+    }
+    REQUIRE(blocks <= 2);
+}
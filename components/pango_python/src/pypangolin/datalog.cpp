@@ -59,7 +59,8 @@ namespace py_pangolin {
       .def("StartId", &pangolin::DataLogBlock::StartId);    
 
     pybind11::class_<pangolin::DataLog>(m, "DataLog")
-      .def(pybind11::init<unsigned int>(), pybind11::arg("block_samples_alloc")=10000)
+      .def(pybind11::init<unsigned int, unsigned int>(), pybind11::arg("block_samples_alloc")=10000, pybind11::arg("max_blocks")=0)
+      .def("SetMaxBlocks", &pangolin::DataLog::SetMaxBlocks)
       .def("SetLabels", &pangolin::DataLog::SetLabels)
       .def("Labels", &pangolin::DataLog::Labels)
       .def("Log", (void (pangolin::DataLog::*)(size_t, const float*, unsigned int))&pangolin::DataLog::Log, pybind11::arg("dimension"), pybind11::arg("vals"), pybind11::arg("samples")=1)
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <pangolin/platform.h>
+#include <pangolin/video/video.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pangolin
+{
+
+// Downscaled preview frames of a seekable video, built in a background thread
+// from a separate instance of the input so that the caller's playback is
+// unaffected. Thumbnails are taken every Stride() frames (coarse-to-fine, so
+// the whole timeline becomes roughly browsable quickly) and can optionally be
+// persisted to a .pango file which is reused next time the same input is opened.
+class PANGOLIN_EXPORT ThumbnailCache
+{
+public:
+    ThumbnailCache(
+        const std::string& input_uri,
+        const std::string& cache_filename = "",
+        size_t max_thumb_dim = 160,
+        size_t max_thumbnails = 4096
+    );
+    ThumbnailCache(const ThumbnailCache&) = delete;
+
+    ~ThumbnailCache();
+
+    // False if input_uri isn't seekable or has an unsupported pixel format
+    bool IsValid() const {
+        return num_thumbnails > 0;
+    }
+
+    // Layout of thumbnail streams within a buffer of SizeBytes()
+    const std::vector<StreamInfo>& Streams() const {
+        return streams;
+    }
+
+    size_t SizeBytes() const {
+        return size_bytes;
+    }
+
+    // Distance in frames between consecutive thumbnails
+    size_t Stride() const {
+        return stride;
+    }
+
+    size_t NumThumbnails() const {
+        return num_thumbnails;
+    }
+
+    size_t NumCached() const {
+        return num_cached;
+    }
+
+    // Copy the cached thumbnail nearest to frameid into buffer (of at least
+    // SizeBytes()). Returns false if no suitable thumbnail is available yet.
+    bool Get(size_t frameid, unsigned char* buffer, size_t* thumb_frameid = nullptr) const;
+
+    // Abort background build
+    void Stop();
+
+protected:
+    void Build();
+    void DownsampleInto(const unsigned char* frame, unsigned char* thumb) const;
+    bool Load();
+    void Save() const;
+    picojson::value CacheProperties() const;
+
+    std::string input_uri;
+    std::string cache_filename;
+
+    std::unique_ptr<VideoInterface> video;
+    VideoPlaybackInterface* playback;
+    std::vector<StreamInfo> streams;
+    std::vector<size_t> factors;
+    size_t size_bytes;
+    size_t stride;
+    size_t num_thumbnails;
+
+    mutable std::mutex cache_mutex;
+    std::vector<std::unique_ptr<unsigned char[]>> thumbs;
+    std::atomic<size_t> num_cached;
+
+    std::atomic<bool> should_run;
+    std::thread build_thread;
+};
+
+}
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <pangolin/platform.h>
+#include <pangolin/tools/thumbnail_cache.h>
 #include <pangolin/windowing/window.h>
 #include <pangolin/video/video_input.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <string>
@@ -60,6 +63,15 @@ public:
     void SetActiveCamera(int delta);
     void DrawEveryNFrames(int n);
 
+    // When enabled (before Run()), frames are grabbed and recorded on a
+    // dedicated thread at sensor rate. The render loop only displays the
+    // most recent frame, so slow rendering can no longer throttle capture.
+    void SetThreadedGrab(bool enabled);
+
+    // When enabled (before Run()), downscaled thumbnails of seekable inputs
+    // are built in the background and shown immediately whilst the frame
+    // slider is dragged. Thumbnails are persisted to cache_filename if given.
+    void EnableThumbnails(const std::string& cache_filename = "");
 
     // Register to be notified of new image data
     void SetFrameChangedCallback(FrameChangedCallbackFn cb);
@@ -78,9 +90,22 @@ public:
 protected:
     void RegisterDefaultKeyShortcutsAndPangoVariables();
 
+    // Body of grab_thread when threaded grabbing is enabled
+    void GrabLoop();
+
+    // Update frames_dropped_capture from driver frame counters, if available
+    void UpdateCaptureDrops();
+
+    // Seek playback, forgetting the last frame counter so that the jump
+    // isn't counted as dropped frames. Call with control_mutex held.
+    int SeekPlayback(int frame);
+
     std::mutex control_mutex;
+    // Notified when grab_until changes, to wake a paused grab_thread
+    std::condition_variable control_cond;
     std::string window_name;
     std::thread vv_thread;
+    std::thread grab_thread;
 
     VideoInput video;
     VideoPlaybackInterface* video_playback;
@@ -97,10 +122,35 @@ protected:
     bool should_run;
     uint16_t active_cam;
 
+    // Latest frame handed from grab_thread to the render loop
+    std::mutex latest_mutex;
+    std::unique_ptr<unsigned char[]> latest_buffer;
+    bool latest_valid;
+    int latest_frame;
+
+    bool threaded_grab;
+    std::atomic<bool> grab_should_run;
+    std::atomic<int> frames_dropped_display;
+    std::atomic<int> frames_dropped_capture;
+    int64_t last_frame_counter;
+    // Incremented by SeekPlayback, so that frames grabbed across a seek are dropped
+    int seek_count;
+
+    // Copies of the counters above for the ui Vars, updated by the render loop
+    int ui_dropped_display;
+    int ui_dropped_capture;
+
+    bool use_thumbnails;
+    std::string thumbnail_cache_filename;
+    std::unique_ptr<ThumbnailCache> thumbnails;
+
     FrameChangedCallbackFn frame_changed_callback;
 };
 
 
-void PANGOLIN_EXPORT RunVideoViewerUI(const std::string& input_uri, const std::string& output_uri);
+void PANGOLIN_EXPORT RunVideoViewerUI(
+    const std::string& input_uri, const std::string& output_uri, bool threaded_grab = false,
+    bool use_thumbnails = false, const std::string& thumbnail_cache_filename = ""
+);
 
 }
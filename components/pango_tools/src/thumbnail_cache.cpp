@@ -0,0 +1,226 @@
+#include <pangolin/tools/thumbnail_cache.h>
+
+#include <pangolin/utils/file_utils.h>
+
+#include <cstring>
+
+namespace pangolin
+{
+
+ThumbnailCache::ThumbnailCache(const std::string& input_uri, const std::string& cache_filename, size_t max_thumb_dim, size_t max_thumbnails)
+    : input_uri(input_uri),
+      cache_filename(cache_filename),
+      playback(nullptr),
+      size_bytes(0),
+      stride(1),
+      num_thumbnails(0),
+      num_cached(0),
+      should_run(false)
+{
+    video = OpenVideo(input_uri);
+    playback = FindFirstMatchingVideoInterface<VideoPlaybackInterface>(*video);
+
+    if(!playback || playback->GetTotalFrames() == 0) {
+        pango_print_warn("ThumbnailCache: '%s' is not seekable. No thumbnails will be generated.\n", input_uri.c_str());
+        return;
+    }
+
+    for(const StreamInfo& si : video->Streams()) {
+        if(si.PixFormat().bpp % 8 != 0) {
+            pango_print_warn("ThumbnailCache: unsupported format %s. No thumbnails will be generated.\n", si.PixFormat().format.c_str());
+            return;
+        }
+
+        // Integer downsample keeps the aspect ratio and lets us just pick pixels
+        const size_t max_dim = std::max(si.Width(), si.Height());
+        const size_t factor = std::max<size_t>(1, (max_dim + max_thumb_dim - 1) / max_thumb_dim);
+        const size_t w = std::max<size_t>(1, si.Width() / factor);
+        const size_t h = std::max<size_t>(1, si.Height() / factor);
+        const size_t pitch = w * si.PixFormat().bpp / 8;
+
+        streams.emplace_back(si.PixFormat(), w, h, pitch, (unsigned char*)0 + size_bytes);
+        factors.push_back(factor);
+        size_bytes += h * pitch;
+    }
+
+    const size_t total_frames = playback->GetTotalFrames();
+    stride = std::max<size_t>(1, (total_frames + max_thumbnails - 1) / max_thumbnails);
+    num_thumbnails = (total_frames + stride - 1) / stride;
+    thumbs.resize(num_thumbnails);
+
+    should_run = true;
+    build_thread = std::thread(&ThumbnailCache::Build, this);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    Stop();
+}
+
+void ThumbnailCache::Stop()
+{
+    should_run = false;
+    if(build_thread.joinable()) {
+        build_thread.join();
+    }
+}
+
+bool ThumbnailCache::Get(size_t frameid, unsigned char* buffer, size_t* thumb_frameid) const
+{
+    if(!num_cached) return false;
+
+    std::lock_guard<std::mutex> l(cache_mutex);
+
+    // Search outwards from the closest slot, since coarse-to-fine building
+    // leaves gaps that are filled in over time.
+    const long n = (long)num_thumbnails;
+    const long slot = std::min(n-1, (long)((frameid + stride/2) / stride));
+    for(long d=0; d < n; ++d) {
+        for(long i : {slot - d, slot + d}) {
+            if(0 <= i && i < n && thumbs[i]) {
+                std::memcpy(buffer, thumbs[i].get(), size_bytes);
+                if(thumb_frameid) *thumb_frameid = i * stride;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ThumbnailCache::DownsampleInto(const unsigned char* frame, unsigned char* thumb) const
+{
+    const std::vector<StreamInfo>& src_streams = video->Streams();
+
+    for(size_t s=0; s < streams.size(); ++s) {
+        const Image<unsigned char> src = src_streams[s].StreamImage(frame);
+        Image<unsigned char> dst = streams[s].StreamImage(thumb);
+        const size_t bytes_pp = streams[s].PixFormat().bpp / 8;
+        const size_t factor = factors[s];
+
+        for(size_t y=0; y < dst.h; ++y) {
+            const unsigned char* src_row = src.RowPtr(y*factor);
+            unsigned char* dst_row = dst.RowPtr(y);
+            for(size_t x=0; x < dst.w; ++x) {
+                std::memcpy(dst_row + x*bytes_pp, src_row + x*factor*bytes_pp, bytes_pp);
+            }
+        }
+    }
+}
+
+void ThumbnailCache::Build()
+{
+    const bool persist = !cache_filename.empty();
+    if(persist && FileExists(cache_filename) && Load() && num_cached == num_thumbnails) {
+        return;
+    }
+    const size_t num_loaded = num_cached;
+
+    std::unique_ptr<unsigned char[]> frame(new unsigned char[video->SizeBytes()]);
+    std::vector<bool> attempted(num_thumbnails, false);
+
+    try{
+        video->Start();
+
+        // Visit every 2^k'th thumbnail, then fill in between with decreasing k
+        size_t step = 1;
+        while(step*2 < num_thumbnails) step *= 2;
+
+        for(; step > 0 && should_run; step /= 2) {
+            for(size_t i=0; i < num_thumbnails && should_run; i += step) {
+                if(attempted[i]) continue;
+                attempted[i] = true;
+
+                {
+                    std::lock_guard<std::mutex> l(cache_mutex);
+                    if(thumbs[i]) continue;
+                }
+
+                const size_t frameid = i * stride;
+                if(playback->Seek(frameid) != frameid || !video->GrabNext(frame.get(), true)) {
+                    continue;
+                }
+
+                std::unique_ptr<unsigned char[]> thumb(new unsigned char[size_bytes]);
+                DownsampleInto(frame.get(), thumb.get());
+
+                {
+                    std::lock_guard<std::mutex> l(cache_mutex);
+                    thumbs[i] = std::move(thumb);
+                }
+                ++num_cached;
+            }
+        }
+
+        video->Stop();
+    }catch(const std::exception& e) {
+        pango_print_warn("ThumbnailCache: stopped building thumbnails: %s\n", e.what());
+    }
+
+    if(persist && should_run && num_cached > num_loaded) {
+        Save();
+    }
+}
+
+picojson::value ThumbnailCache::CacheProperties() const
+{
+    picojson::value props;
+    props["thumbnail_source"] = input_uri;
+    props["thumbnail_stride"] = stride;
+    props["thumbnail_count"] = num_thumbnails;
+    return props;
+}
+
+bool ThumbnailCache::Load()
+{
+    try{
+        std::unique_ptr<VideoInterface> cache = OpenVideo("pango://" + cache_filename);
+        VideoPropertiesInterface* props = dynamic_cast<VideoPropertiesInterface*>(cache.get());
+
+        if( !props || props->DeviceProperties() != CacheProperties() ||
+            cache->SizeBytes() != size_bytes || cache->Streams().size() != streams.size() )
+        {
+            pango_print_warn("ThumbnailCache: '%s' doesn't match input. Rebuilding.\n", cache_filename.c_str());
+            return false;
+        }
+
+        std::unique_ptr<unsigned char[]> thumb(new unsigned char[size_bytes]);
+        while(should_run && cache->GrabNext(thumb.get(), true)) {
+            const size_t frameid = props->FrameProperties().get_value<int64_t>("frame_id", -1);
+            const size_t i = frameid / stride;
+            if(frameid % stride == 0 && i < num_thumbnails) {
+                std::lock_guard<std::mutex> l(cache_mutex);
+                if(!thumbs[i]) {
+                    thumbs[i] = std::move(thumb);
+                    thumb.reset(new unsigned char[size_bytes]);
+                    ++num_cached;
+                }
+            }
+        }
+        return true;
+    }catch(const std::exception& e) {
+        pango_print_warn("ThumbnailCache: unable to load '%s': %s\n", cache_filename.c_str(), e.what());
+        return false;
+    }
+}
+
+void ThumbnailCache::Save() const
+{
+    try{
+        std::unique_ptr<VideoOutputInterface> cache = OpenVideoOutput("pango://" + cache_filename);
+        cache->SetStreams(streams, input_uri, CacheProperties());
+
+        std::lock_guard<std::mutex> l(cache_mutex);
+        for(size_t i=0; i < num_thumbnails; ++i) {
+            if(thumbs[i]) {
+                picojson::value frame_props;
+                frame_props["frame_id"] = i * stride;
+                cache->WriteStreams(thumbs[i].get(), frame_props);
+            }
+        }
+    }catch(const std::exception& e) {
+        pango_print_warn("ThumbnailCache: unable to save '%s': %s\n", cache_filename.c_str(), e.what());
+    }
+}
+
+}
@@ -3,6 +3,7 @@
 #include <pangolin/gl/gldraw.h>
 #include <pangolin/gl/glpixformat.h>
 #include <pangolin/gl/gltexturecache.h>
+#include <pangolin/display/default_font.h>
 #include <pangolin/display/image_view.h>
 #include <pangolin/display/widgets.h>
 #include <pangolin/utils/file_utils.h>
@@ -11,6 +12,8 @@
 #include <pangolin/handler/handler_image.h>
 #include <pangolin/var/var.h>
 
+#include <chrono>
+
 
 namespace pangolin
 {
@@ -32,11 +35,24 @@ VideoViewer::VideoViewer(const std::string& window_name, const std::string& inpu
       video_grab_wait(true),
       video_grab_newest(false),
       should_run(true),
-      active_cam(0)
+      active_cam(0),
+      latest_valid(false),
+      latest_frame(-1),
+      threaded_grab(false),
+      grab_should_run(false),
+      frames_dropped_display(0),
+      frames_dropped_capture(0),
+      last_frame_counter(-1),
+      seek_count(0),
+      ui_dropped_display(0),
+      ui_dropped_capture(0),
+      use_thumbnails(false)
 {
     pangolin::Var<int>::Attach("ui.frame", current_frame);
     pangolin::Var<int>::Attach("ui.record_nth_frame", record_nth_frame);
     pangolin::Var<int>::Attach("ui.draw_nth_frame", draw_nth_frame);
+    pangolin::Var<int>::Attach("ui.dropped_display", ui_dropped_display);
+    pangolin::Var<int>::Attach("ui.dropped_capture", ui_dropped_capture);
 
 
     if(!input_uri.empty()) {
@@ -54,12 +70,17 @@ void VideoViewer::Quit()
 {
     // Signal any running thread to stop
     should_run = false;
+    grab_should_run = false;
 }
 
 void VideoViewer::QuitAndWait()
 {
     Quit();
 
+    if(grab_thread.joinable()) {
+        grab_thread.join();
+    }
+
     if(vv_thread.joinable()) {
         vv_thread.join();
     }
@@ -126,8 +147,33 @@ void VideoViewer::Run()
         }
     };
 
+    pangolin::View& stats_graphic = pangolin::Display("stats_glyph").
+            SetBounds(pangolin::Attach::Pix(-20),1.0f, 0.0f, 1.0f);
+    stats_graphic.extern_draw_function = [&](pangolin::View& v){
+        if(threaded_grab || ui_dropped_capture > 0) {
+            v.ActivatePixelOrthographic();
+            glColor3f(1.0f, 1.0f, 1.0f);
+            pangolin::default_font().Text(
+                "dropped for display: %d, dropped for capture: %d",
+                ui_dropped_display, ui_dropped_capture
+            ).Draw(6.0f, 6.0f);
+        }
+    };
+
     std::vector<pangolin::Image<unsigned char> > images;
 
+    std::unique_ptr<unsigned char[]> thumb_buffer;
+    if(use_thumbnails && video_playback && TotalFrames() < std::numeric_limits<int>::max()) {
+        try{
+            thumbnails.reset(new ThumbnailCache(video.VideoUri().full_uri, thumbnail_cache_filename));
+            thumb_buffer.reset(new unsigned char[thumbnails->SizeBytes()+1]);
+        }catch(const std::exception& e){
+            pango_print_warn("Unable to create thumbnails: %s\n", e.what());
+            thumbnails.reset();
+        }
+    }
+    int pending_seek = -1;
+
     /////////////////////////////////////////////////////////////////////////
     /// Register key shortcuts
     /////////////////////////////////////////////////////////////////////////
@@ -158,47 +204,192 @@ void VideoViewer::Run()
 
     video.Start();
 
+    if(threaded_grab) {
+        latest_buffer.reset(new unsigned char[video.SizeBytes()+1]);
+        latest_valid = false;
+        grab_should_run = true;
+        grab_thread = std::thread(&VideoViewer::GrabLoop, this);
+    }
+
     // Stream and display video
     while(should_run && !pangolin::ShouldQuit())
     {
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
         glColor3f(1.0f, 1.0f, 1.0f);
 
+        bool new_frame = false;
+        int shown_frame = 0;
+
         {
             std::lock_guard<std::mutex> lock(control_mutex);
 
             if(frame.GuiChanged()) {
-                if(video_playback) {
-                    frame = video_playback->Seek(frame) -1;
+                if(thumbnails && thumbnails->Get(frame, thumb_buffer.get())) {
+                    // Preview whilst the slider moves; decode once it settles
+                    pending_seek = frame;
+                    grab_until = frame;
+                    for(unsigned int i=0; i<stream_views.size(); ++i) {
+                        const StreamInfo& si = thumbnails->Streams()[i];
+                        stream_views[i].SetImage(si.StreamImage(thumb_buffer.get()), pangolin::GlPixFormat(si.PixFormat()));
+                    }
+                }else{
+                    if(video_playback) {
+                        frame = SeekPlayback(frame) -1;
+                    }
+                    grab_until = frame + 1;
                 }
+                control_cond.notify_all();
+            }else if(pending_seek >= 0) {
+                frame = SeekPlayback(pending_seek) -1;
                 grab_until = frame + 1;
+                pending_seek = -1;
+                control_cond.notify_all();
             }
 
-            if ( frame < grab_until && video.Grab(&buffer[0], images, video_grab_wait, video_grab_newest)) {
-                frame = frame +1;
+            if(!threaded_grab) {
+                if ( frame < grab_until && video.Grab(&buffer[0], images, video_grab_wait, video_grab_newest)) {
+                    frame = frame +1;
+                    UpdateCaptureDrops();
 
-                if(frame_changed_callback) {
-                    frame_changed_callback(buffer.get(), images, GetVideoFrameProperties(video_interface));
-                }
+                    if(frame_changed_callback) {
+                        frame_changed_callback(buffer.get(), images, GetVideoFrameProperties(video_interface));
+                    }
 
-                // Update images
-                if((frame-1) % draw_nth_frame == 0) {
-                    for(unsigned int i=0; i<images.size(); ++i)
-                        if(stream_views[i].IsShown()) {
-                            stream_views[i].SetImage(images[i], pangolin::GlPixFormat(video.Streams()[i].PixFormat() ));
-                        }
+                    new_frame = true;
+                    shown_frame = frame;
                 }
             }
         }
 
+        if(threaded_grab) {
+            // Take ownership of the most recent frame, if any. The grab
+            // thread keeps capturing into its own buffer meanwhile.
+            std::lock_guard<std::mutex> lock(latest_mutex);
+            if(latest_valid) {
+                std::swap(buffer, latest_buffer);
+                latest_valid = false;
+                new_frame = true;
+                shown_frame = latest_frame;
+            }
+        }
+
+        ui_dropped_display = frames_dropped_display;
+        ui_dropped_capture = frames_dropped_capture;
+
+        // Update images
+        if(new_frame && (shown_frame-1) % draw_nth_frame == 0) {
+            images.clear();
+            for(const StreamInfo& si : video.Streams()) {
+                images.push_back(si.StreamImage(buffer.get()));
+            }
+            for(unsigned int i=0; i<images.size(); ++i)
+                if(stream_views[i].IsShown()) {
+                    stream_views[i].SetImage(images[i], pangolin::GlPixFormat(video.Streams()[i].PixFormat() ));
+                }
+        }
+
         // leave in pixel orthographic for slider to render.
         pangolin::DisplayBase().ActivatePixelOrthographic();
         pangolin::FinishFrame();
     }
 
+    {
+        std::lock_guard<std::mutex> lock(control_mutex);
+        grab_should_run = false;
+        control_cond.notify_all();
+    }
+    if(grab_thread.joinable()) {
+        grab_thread.join();
+    }
+
+    thumbnails.reset();
+
     pangolin::DestroyWindow(window_name);
 }
 
+void VideoViewer::GrabLoop()
+{
+    std::unique_ptr<unsigned char[]> grab_buffer(new unsigned char[video.SizeBytes()+1]);
+    std::vector<pangolin::Image<unsigned char> > grab_images;
+
+    while(grab_should_run)
+    {
+        bool wait;
+        bool newest;
+        int seeks;
+
+        {
+            std::unique_lock<std::mutex> lock(control_mutex);
+
+            // Whilst paused, sleep until the UI changes grab_until. The
+            // timeout covers changes made without notifying.
+            control_cond.wait_for(lock, std::chrono::milliseconds(50), [this](){
+                return !grab_should_run || current_frame < grab_until;
+            });
+            if(!grab_should_run || current_frame >= grab_until) continue;
+
+            wait = video_grab_wait;
+            newest = video_grab_newest;
+            seeks = seek_count;
+        }
+
+        // Never block whilst holding control_mutex, so that the render loop,
+        // seeking, pausing and recording don't wait on the camera.
+        const bool success = video.Grab(grab_buffer.get(), grab_images, wait, newest);
+
+        bool grabbed = false;
+        int grabbed_frame = 0;
+        FrameChangedCallbackFn callback;
+        {
+            std::lock_guard<std::mutex> lock(control_mutex);
+            // A frame grabbed across a seek is from before it
+            if(success && seeks == seek_count) {
+                current_frame = current_frame + 1;
+                UpdateCaptureDrops();
+                callback = frame_changed_callback;
+                grabbed = true;
+                grabbed_frame = current_frame;
+            }
+        }
+
+        if(grabbed) {
+            if(callback) {
+                callback(grab_buffer.get(), grab_images, GetVideoFrameProperties(video_interface));
+            }
+
+            std::lock_guard<std::mutex> lock(latest_mutex);
+            if(latest_valid) {
+                // Render loop never got to see the previous frame
+                ++frames_dropped_display;
+            }
+            std::swap(grab_buffer, latest_buffer);
+            latest_valid = true;
+            latest_frame = grabbed_frame;
+        }else if(!wait) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+}
+
+void VideoViewer::UpdateCaptureDrops()
+{
+    const picojson::value props = GetVideoFrameProperties(video_interface);
+    if(props.contains(PANGO_FRAME_COUNTER) && props[PANGO_FRAME_COUNTER].is<double>()) {
+        const int64_t counter = (int64_t)props[PANGO_FRAME_COUNTER].get<double>();
+        if(last_frame_counter >= 0 && counter > last_frame_counter + 1) {
+            frames_dropped_capture += (int)(counter - last_frame_counter - 1);
+        }
+        last_frame_counter = counter;
+    }
+}
+
+int VideoViewer::SeekPlayback(int frame)
+{
+    last_frame_counter = -1;
+    ++seek_count;
+    return video_playback->Seek(frame);
+}
+
 void VideoViewer::RegisterDefaultKeyShortcutsAndPangoVariables()
 {
     pangolin::RegisterKeyPressCallback(' ', [this](){TogglePlay();} );
@@ -281,6 +472,7 @@ void VideoViewer::TogglePlay()
 {
     std::lock_guard<std::mutex> lock(control_mutex);
     grab_until = (current_frame < grab_until) ? current_frame: std::numeric_limits<int>::max();
+    control_cond.notify_all();
 }
 
 void VideoViewer::ToggleRecord()
@@ -348,6 +540,19 @@ void VideoViewer::DrawEveryNFrames(int n)
 
 
 
+void VideoViewer::SetThreadedGrab(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(control_mutex);
+    threaded_grab = enabled;
+}
+
+void VideoViewer::EnableThumbnails(const std::string& cache_filename)
+{
+    std::lock_guard<std::mutex> lock(control_mutex);
+    use_thumbnails = true;
+    thumbnail_cache_filename = cache_filename;
+}
+
 void VideoViewer::SetWaitForFrames(bool new_state)
 {
     std::lock_guard<std::mutex> lock(control_mutex);
@@ -366,7 +571,7 @@ void VideoViewer::Skip(int frames)
     if(video_playback) {
         const int next_frame = current_frame + frames;
         if (next_frame >= 0) {
-            current_frame = video_playback->Seek(next_frame) -1;
+            current_frame = SeekPlayback(next_frame) -1;
             grab_until = current_frame + 1;
         }
     }else{
@@ -376,6 +581,7 @@ void VideoViewer::Skip(int frames)
             pango_print_warn("Unable to skip backward.");
         }
     }
+    control_cond.notify_all();
 
 }
 
@@ -440,12 +646,18 @@ void VideoViewer::WaitUntilExit()
 }
 
 
-void RunVideoViewerUI(const std::string& input_uri, const std::string& output_uri)
-{
+void RunVideoViewerUI(
+    const std::string& input_uri, const std::string& output_uri, bool threaded_grab,
+    bool use_thumbnails, const std::string& thumbnail_cache_filename
+) {
     RegisterNewSigCallback(videoviewer_signal_quit, nullptr, SIGINT);
     RegisterNewSigCallback(videoviewer_signal_quit, nullptr, SIGTERM);
 
     VideoViewer vv("VideoViewer", input_uri, output_uri);
+    vv.SetThreadedGrab(threaded_grab);
+    if(use_thumbnails) {
+        vv.EnableThumbnails(thumbnail_cache_filename);
+    }
     vv.Run();
 }
 
@@ -39,6 +39,22 @@
 namespace pangolin
 {
 
+namespace detail
+{
+// Compare Var values where the type allows, otherwise assume they differ
+template<typename T>
+auto VarValuesEqual(const T& a, const T& b, int) -> decltype(bool(a == b))
+{
+    return a == b;
+}
+
+template<typename T>
+bool VarValuesEqual(const T&, const T&, long)
+{
+    return false;
+}
+}
+
 template<typename T>
 class Var
 {
@@ -132,13 +148,13 @@ public:
 
     Var<T>& operator=(const T& val)
     {
-        var->Set(val);
+        Assign(val);
         return *this;
     }
 
     Var<T>& operator=(const Var<T>& v)
     {
-        var->Set(v.var->Get());
+        Assign(v.var->Get());
         return *this;
     }
 
@@ -160,6 +176,15 @@ public:
     // Holds reference to stored variable object
     // N.B. mutable because it is a cached value and Get() is advertised as const.
     mutable std::shared_ptr<VarValueT<T>> var;
+
+protected:
+    // Set value, notifying listeners such as displays if it changed
+    void Assign(const T& val)
+    {
+        const bool changed = !detail::VarValuesEqual<T>(var->Get(), val, 0);
+        var->Set(val);
+        if(changed) VarState::I().NotifyVarChanged(var);
+    }
 };
 
 template<typename T>
@@ -111,6 +111,17 @@ public:
     /// \returns A \class Connection object for handling \param callback_function lifetime
     sigslot::connection RegisterForVarEvents( Event::Function callback_function, bool include_historic);
 
+    /// Function signature for callbacks on changes to Var values
+    using ChangedFunction = std::function<void(const std::shared_ptr<VarValueGeneric>&)>;
+
+    /// Register to be informed when a Var is assigned a different value
+    /// through pangolin::Var, from any thread. Changes made directly to the
+    /// memory of attached variables can't be observed.
+    sigslot::connection RegisterForVarChanges( ChangedFunction callback_function );
+
+    /// Inform listeners that \param var was assigned a different value
+    void NotifyVarChanged(const std::shared_ptr<VarValueGeneric>& var);
+
     /// Type of Var settings file
     enum class FileKind
     {
@@ -160,6 +171,7 @@ private:
     void SaveToJsonStream(std::ostream& os);
 
     sigslot::signal<Event> VarEventSignal;
+    sigslot::signal<const std::shared_ptr<VarValueGeneric>&> VarChangedSignal;
 
     VarStoreMap vars;
     VarStoreMapReverse vars_reverse;
@@ -70,6 +70,18 @@ sigslot::connection VarState::RegisterForVarEvents( Event::Function callback_fun
     return VarEventSignal.connect(callback_function);
 }
 
+// Return value manages connection lifetime through RAII
+[[nodiscard]]
+sigslot::connection VarState::RegisterForVarChanges( ChangedFunction callback_function )
+{
+    return VarChangedSignal.connect(callback_function);
+}
+
+void VarState::NotifyVarChanged(const std::shared_ptr<VarValueGeneric>& var)
+{
+    VarChangedSignal(var);
+}
+
 //void AddAlias(const string& alias, const string& name)
 //{
 //    std::map<std::string,_Var*>::iterator vi = vars.find(name);
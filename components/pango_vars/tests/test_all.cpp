@@ -411,3 +411,33 @@ SCENARIO("Var Events")
         }
     }
 }
+
+SCENARIO("Var Change Events")
+{
+    VarState::I().Clear();
+
+    Var<double> x1("x1", 1.0);
+    Var<CustomType> x2("x2", CustomType{1.0f, 2});
+
+    std::vector<std::string> changed;
+    sigslot::scoped_connection conn = VarState::I().RegisterForVarChanges([&changed](const std::shared_ptr<VarValueGeneric>& var){
+        changed.push_back(var->Meta().full_name);
+    });
+
+    WHEN("Assigning a different value, we get an event") {
+        x1 = 2.0;
+        REQUIRE(changed.size() == 1);
+        REQUIRE(changed[0] == "x1");
+    }
+
+    WHEN("Assigning the same value, we don't") {
+        x1 = 1.0;
+        REQUIRE(changed.size() == 0);
+    }
+
+    WHEN("Values can't be compared, every assignment is a change") {
+        x2 = CustomType{1.0f, 2};
+        REQUIRE(changed.size() == 1);
+        REQUIRE(changed[0] == "x2");
+    }
+}
@@ -74,7 +74,8 @@ typedef enum {
 class PANGOLIN_EXPORT DebayerVideo :
         public VideoInterface,
         public VideoFilterInterface,
-        public BufferAwareVideoInterface
+        public BufferAwareVideoInterface,
+        public FrameFilterInterface
 {
 public:
     DebayerVideo(std::unique_ptr<VideoInterface>& videoin, const std::vector<bayer_method_t> &method, color_filter_t tile, const WbGains& input_wb_gains);
@@ -108,9 +109,10 @@ public:
 
     bool DropNFrames(uint32_t n);
 
-protected:
-    void ProcessStreams(unsigned char* out, const unsigned char* in);
+    //! Implement FrameFilterInterface method
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
 
+protected:
     std::unique_ptr<VideoInterface> src;
     std::vector<VideoInterface*> videoin;
     std::vector<StreamInfo> streams;
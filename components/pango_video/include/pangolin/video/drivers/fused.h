@@ -0,0 +1,101 @@
+#pragma once
+
+#include <pangolin/video/video_interface.h>
+
+#include <memory>
+#include <vector>
+
+namespace pangolin
+{
+
+// Runs a chain of row filters (see RowFilterInterface) in a single pass.
+// Rather than each filter processing the whole frame into a buffer of its own
+// for the next to read back, every band of rows is taken through all of the
+// stages whilst it is still in cache. The output is identical to the unfused
+// chain, which FusedVideo owns and which remains reachable as its input.
+// Fusion is opt-in through the fuse:// scheme, e.g. fuse://shift//unpack//...
+// Since the fused filters are never grabbed from themselves, buffer and frame
+// properties are those of the base video that is.
+class PANGOLIN_EXPORT FusedVideo :
+    public VideoInterface,
+    public VideoFilterInterface,
+    public FrameFilterInterface,
+    public BufferAwareVideoInterface,
+    public VideoPropertiesInterface
+{
+public:
+    // Stages are ordered from the last applied (the owned top filter) to the
+    // first, whose input is base.
+    FusedVideo(std::unique_ptr<VideoInterface>& top, const std::vector<RowFilterInterface*>& stages, VideoInterface* base);
+    ~FusedVideo();
+
+    //! Implement VideoInput::Start()
+    void Start();
+
+    //! Implement VideoInput::Stop()
+    void Stop();
+
+    //! Implement VideoInput::SizeBytes()
+    size_t SizeBytes() const;
+
+    //! Implement VideoInput::Streams()
+    const std::vector<StreamInfo>& Streams() const;
+
+    //! Implement VideoInput::GrabNext()
+    bool GrabNext( unsigned char* image, bool wait = true );
+
+    //! Implement VideoInput::GrabNewest()
+    bool GrabNewest( unsigned char* image, bool wait = true );
+
+    //! Implement VideoFilterInterface method
+    std::vector<VideoInterface*>& InputStreams();
+
+    //! Implement BufferAwareVideoInterface method
+    uint32_t AvailableFrames() const;
+
+    //! Implement BufferAwareVideoInterface method
+    bool DropNFrames(uint32_t n);
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& DeviceProperties() const;
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& FrameProperties() const;
+
+    //! Implement FrameFilterInterface method. The input frame is laid out as
+    //! the streams of Base().
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
+
+    const std::vector<RowFilterInterface*>& Stages() const { return stages; }
+
+    VideoInterface* Base() const { return base; }
+
+protected:
+    // Intermediate band storage, per stream and stage
+    using Scratch = std::vector<std::vector<std::unique_ptr<unsigned char[]>>>;
+
+    void AllocateScratch(Scratch& scratch) const;
+
+    void Process(unsigned char* image, const unsigned char* buffer, Scratch& scratch);
+
+    std::unique_ptr<VideoInterface> src;
+    std::vector<VideoInterface*> videoin;
+    std::vector<RowFilterInterface*> stages;
+    std::vector<VideoInterface*> stage_videos;
+    VideoInterface* base;
+    std::unique_ptr<unsigned char[]> buffer;
+    picojson::value device_properties;
+    picojson::value frame_properties;
+
+    // Rows per band, per stream
+    std::vector<size_t> band_rows;
+    Scratch scratch;
+};
+
+// Replace a run of two or more row filters at the top of video with a
+// FusedVideo, absorbing any FusedVideo already below them. Returns video
+// unchanged when there is nothing to fuse.
+PANGOLIN_EXPORT
+std::unique_ptr<VideoInterface> FuseVideoFilters(std::unique_ptr<VideoInterface> video);
+
+}
@@ -27,8 +27,8 @@
 
 #pragma once
 
-#include <pangolin/pangolin.h>
-#include <pangolin/video/video.h>
+#include <pangolin/video/video_interface.h>
+#include <map>
 #include <set>
 
 namespace pangolin
@@ -38,7 +38,9 @@ namespace pangolin
 class PANGOLIN_EXPORT GammaVideo :
     public VideoInterface,
     public VideoFilterInterface,
-    public BufferAwareVideoInterface
+    public BufferAwareVideoInterface,
+    public RowFilterInterface,
+    public FrameFilterInterface
 {
 public:
     GammaVideo(std::unique_ptr<VideoInterface>& videoin, const std::map<size_t, float> &stream_gammas);
@@ -69,6 +71,12 @@ public:
 
     bool DropNFrames(uint32_t n);
 
+    //! Implement RowFilterInterface method
+    void ProcessRows(size_t stream, Image<uint8_t>& out, const Image<uint8_t>& in);
+
+    //! Implement FrameFilterInterface method
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
+
 protected:
     void Process(uint8_t* image, const uint8_t* buffer);
 
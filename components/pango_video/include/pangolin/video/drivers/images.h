@@ -30,22 +30,31 @@
 #include <pangolin/video/video_interface.h>
 #include <pangolin/image/image_io.h>
 
+#include <condition_variable>
 #include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace pangolin
 {
 
 // Video class that outputs test video signal.
+// If prefetch > 0, the next prefetch frames are decoded ahead of time by
+// prefetch_threads background threads into a bounded cache of frame buffers,
+// which also retains recently played frames to serve nearby Seek()s.
 class PANGOLIN_EXPORT ImagesVideo : public VideoInterface, public VideoPlaybackInterface, public VideoPropertiesInterface
 {
 public:
-    ImagesVideo(const std::string& wildcard_path);
+    ImagesVideo(const std::string& wildcard_path, size_t prefetch = 0, size_t prefetch_threads = 1);
 
     ImagesVideo(
         const std::string& wildcard_path, const PixelFormat& raw_fmt,
         size_t raw_width, size_t raw_height, size_t raw_pitch,
-        size_t raw_offset, size_t raw_planes
+        size_t raw_offset, size_t raw_planes,
+        size_t prefetch = 0, size_t prefetch_threads = 1
     );
 
     // Explicitly delete copy ctor and assignment operator.
@@ -90,9 +99,11 @@ public:
 protected:
     typedef std::vector<TypedImage> Frame;
     
-    const std::string& Filename(size_t frameNum, size_t channelNum) {
+    const std::string& Filename(size_t frameNum, size_t channelNum) const {
         return filenames[channelNum][frameNum];
     }
+
+    TypedImage LoadChannel(size_t i, size_t c) const;
     
     void PopulateFilenames(const std::string& wildcard_path);
 
@@ -101,7 +112,20 @@ protected:
     bool LoadFrame(size_t i);
 
     void ConfigureStreamSizes();
+
+    void StartPrefetch(size_t threads);
+
+    // Queue frames within the prefetch window of next_frame_id for decoding,
+    // and evict cached frames furthest from it. Requires cache_mutex.
+    void SchedulePrefetch();
+
+    // Decode all channels of frame i into buffer of size_bytes
+    bool DecodeInto(size_t i, unsigned char* buffer) const;
+
+    void PrefetchLoop();
     
+    bool GrabPrefetched( unsigned char* image, bool wait );
+
     std::vector<StreamInfo> streams;
     size_t size_bytes;
     
@@ -123,6 +147,21 @@ protected:
     picojson::value device_properties;
     picojson::value json_frames;
     picojson::value null_props;
+
+    struct PrefetchedFrame {
+        enum State { Queued, Decoding, Ready, Failed } state;
+        std::unique_ptr<unsigned char[]> buffer;
+    };
+
+    size_t prefetch;
+    std::map<size_t, PrefetchedFrame> cache;
+    std::vector<std::unique_ptr<unsigned char[]>> buffer_pool;
+    std::deque<size_t> decode_queue;
+    std::mutex cache_mutex;
+    std::condition_variable decode_cond;
+    std::condition_variable ready_cond;
+    std::vector<std::thread> prefetch_threads;
+    bool should_run;
 };
 
 }
@@ -31,13 +31,25 @@
 #include <pangolin/video/video_output_interface.h>
 #include <pangolin/log/packetstream_writer.h>
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace pangolin
 {
 
+// Writes each frame as one image file per stream. Images are encoded and
+// written by a pool of num_threads workers, so WriteStreams only copies the
+// frame unless max_queued frames are already waiting, in which case it blocks
+// until one completes. The json index is written, in frame order, on close.
 class PANGOLIN_EXPORT ImagesVideoOutput : public VideoOutputInterface
 {
 public:
-    ImagesVideoOutput(const std::string& image_folder, const std::string& json_file_out, const std::string &image_file_extension);
+    ImagesVideoOutput(const std::string& image_folder, const std::string& json_file_out, const std::string &image_file_extension, size_t num_threads = 1, size_t max_queued = 2);
     ~ImagesVideoOutput();
 
     const std::vector<StreamInfo>& Streams() const override;
@@ -45,7 +57,23 @@ public:
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
     bool IsPipe() const override;
 
+    // Number of frames accepted by WriteStreams but not yet fully written
+    size_t Backlog() const;
+
 protected:
+    struct Job {
+        size_t frame;
+        size_t stream;
+        std::string filename;
+    };
+
+    struct PendingFrame {
+        std::unique_ptr<unsigned char[]> data;
+        size_t streams_remaining;
+    };
+
+    void WriterLoop();
+
     std::vector<StreamInfo> streams;
     std::string input_uri;
     picojson::value device_properties;
@@ -55,6 +83,18 @@ protected:
     std::string image_folder;
     std::string image_file_extension;
     std::ofstream file;
+
+    size_t frame_size_bytes;
+    size_t max_queued;
+    std::map<size_t, PendingFrame> pending;
+    std::deque<Job> jobs;
+    std::vector<std::unique_ptr<unsigned char[]>> buffer_pool;
+    std::exception_ptr writer_error;
+    mutable std::mutex queue_mutex;
+    std::condition_variable job_cond;
+    std::condition_variable space_cond;
+    std::vector<std::thread> writers;
+    bool should_run;
 };
 
 }
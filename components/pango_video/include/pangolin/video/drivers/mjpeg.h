@@ -29,16 +29,23 @@
 
 #include <pangolin/video/video_interface.h>
 #include <pangolin/image/typed_image.h>
+#include <pangolin/utils/bounded_queue.h>
+#include <pangolin/utils/reorder_queue.h>
 #include <fstream>
+#include <thread>
 
 namespace pangolin
 {
 
-// Video class that outputs test video signal.
+// Video class that plays back a Motion Jpeg file (concatenated jpegs). The
+// position of every jpeg is found on opening, so that frames can be sought
+// and decoded ahead of time by a pool of num_threads workers, into a pool of
+// depth reused frame buffers. With num_threads = 0, frames are decoded on
+// the calling thread straight into the caller's buffer.
 class PANGOLIN_EXPORT MjpegVideo : public VideoInterface, public VideoPlaybackInterface
 {
 public:
-    MjpegVideo(const std::string& filename);
+    MjpegVideo(const std::string& filename, size_t num_threads = 0, size_t depth = 0);
     ~MjpegVideo();
 
     //! Implement VideoInput::Start()
@@ -64,14 +71,40 @@ public:
     size_t Seek(size_t frameid) override;
 
 protected:
-    bool LoadNext();
+    struct Frame
+    {
+        std::vector<char> jpeg;
+        std::vector<unsigned char> image;
+    };
+    using FramePtr = std::unique_ptr<Frame>;
+    using Job = std::pair<size_t, FramePtr>;
+
+    // Read the compressed bytes of frame frameid
+    void ReadJpeg(size_t frameid, std::vector<char>& jpeg);
+    void Decode(const std::vector<char>& jpeg, unsigned char* image) const;
+
+    void StartDecoding();
+    void StopDecoding();
+    void Read(size_t first_frame);
+    void Work();
+    void Fail(const std::exception& e);
 
     std::vector<StreamInfo> streams;
     size_t size_bytes;
     std::ifstream bFile;
-    TypedImage next_image;
     std::vector<std::streampos> offsets;
+    std::streampos file_end;
     size_t next_frame_id;
+    std::vector<char> jpeg_buffer;
+
+    size_t num_threads;
+    size_t depth;
+    bool decoding;
+    std::unique_ptr<BoundedQueue<FramePtr>> free_frames;
+    std::unique_ptr<BoundedQueue<Job>> todo;
+    std::unique_ptr<ReorderQueue<FramePtr>> done;
+    std::thread reader;
+    std::vector<std::thread> workers;
 };
 
 }
@@ -36,7 +36,9 @@ namespace pangolin
 class PANGOLIN_EXPORT PackVideo :
     public VideoInterface,
     public VideoFilterInterface,
-    public BufferAwareVideoInterface
+    public BufferAwareVideoInterface,
+    public RowFilterInterface,
+    public FrameFilterInterface
 {
 public:
     PackVideo(std::unique_ptr<VideoInterface>& videoin, PixelFormat new_fmt);
@@ -67,6 +69,12 @@ public:
 
     bool DropNFrames(uint32_t n);
 
+    //! Implement RowFilterInterface method
+    void ProcessRows(size_t stream, Image<unsigned char>& out, const Image<unsigned char>& in);
+
+    //! Implement FrameFilterInterface method
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
+
 protected:
     void Process(unsigned char* image, const unsigned char* buffer);
 
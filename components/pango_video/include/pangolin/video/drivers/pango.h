@@ -57,15 +57,22 @@ public:
 
     bool GrabNewest( unsigned char* image, bool wait = true ) override;
 
+    // Read the next frame's packet without decoding it, updating the frame
+    // properties as GrabNext does. Decoding with DecodePacket can then be
+    // spread over several threads.
+    bool GrabPacket(std::vector<char>& packet);
+
+    // Decode a packet from GrabPacket into image (of SizeBytes()). Safe to
+    // call concurrently.
+    void DecodePacket(const std::vector<char>& packet, unsigned char* image) const;
+
     // Implement VideoPropertiesInterface
     const picojson::value& DeviceProperties() const override {
         if (-1 == _src_id) throw std::runtime_error("Not initialised");
         return _device_properties;
     }
 
-    const picojson::value& FrameProperties() const override {
-        return _frame_properties;
-    }
+    const picojson::value& FrameProperties() const override;
 
     // Implement VideoPlaybackInterface
 
@@ -82,6 +89,7 @@ private:
 
 protected:
     int FindPacketStreamSource();
+    void Decode(std::istream& is, unsigned char* image) const;
     void SetupStreams(const PacketStreamSource& src);
 
     const std::string _filename;
@@ -96,7 +104,8 @@ protected:
     std::vector<StreamInfo> _streams;
     std::vector<ImageDecoderFunc> stream_decoder;
     picojson::value _device_properties;
-    picojson::value _frame_properties;
+    mutable picojson::value _frame_properties;
+    mutable std::string _frame_properties_binary;
     std::string _source_uri;
 
     sigslot::scoped_connection session_seek;
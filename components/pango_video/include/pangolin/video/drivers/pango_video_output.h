@@ -39,7 +39,7 @@ namespace pangolin
 class PANGOLIN_EXPORT PangoVideoOutput : public VideoOutputInterface
 {
 public:
-    PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris);
+    PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris, bool binary_meta = false);
     ~PangoVideoOutput();
 
     const std::vector<StreamInfo>& Streams() const override;
@@ -47,7 +47,15 @@ public:
     int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
     bool IsPipe() const override;
 
+    // Encode a frame into the packet WriteStreams would write, without writing
+    // it. Safe to call concurrently, so that frames can be encoded in
+    // parallel and then written in order with WriteEncoded.
+    void EncodeStreams(const unsigned char* data, std::vector<uint8_t>& encoded) const;
+    int WriteEncoded(const std::vector<uint8_t>& encoded, const picojson::value& frame_properties);
+
 protected:
+    bool ReadyToWrite();
+
 //    void WriteHeader();
 
     std::vector<StreamInfo> streams;
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <pangolin/video/video_interface.h>
+#include <pangolin/utils/bounded_queue.h>
+#include <pangolin/utils/reorder_queue.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pangolin
+{
+
+class PangoVideo;
+
+// Video class that processes several frames of its input at once. Frames are
+// grabbed ahead of time from the bottom of the chain, on a thread of their
+// own, and the filters above it that implement FrameFilterInterface (and the
+// decoding of .pango logs) run on a pool of workers. Frames are returned in
+// order with their properties. This suits offline playback, where frames are
+// independent and the chain is limited by the CPU rather than the source;
+// seeking through the wrapped video isn't supported.
+class PANGOLIN_EXPORT ParallelVideo :
+    public VideoInterface,
+    public VideoFilterInterface,
+    public VideoPropertiesInterface
+{
+public:
+    ParallelVideo(std::unique_ptr<VideoInterface>& videoin, size_t num_threads, size_t depth);
+    ~ParallelVideo();
+
+    //! Implement VideoInput::Start()
+    void Start();
+
+    //! Implement VideoInput::Stop()
+    void Stop();
+
+    //! Implement VideoInput::SizeBytes()
+    size_t SizeBytes() const;
+
+    //! Implement VideoInput::Streams()
+    const std::vector<StreamInfo>& Streams() const;
+
+    //! Implement VideoInput::GrabNext()
+    bool GrabNext( unsigned char* image, bool wait = true );
+
+    //! Implement VideoInput::GrabNewest()
+    bool GrabNewest( unsigned char* image, bool wait = true );
+
+    //! Implement VideoFilterInterface method
+    std::vector<VideoInterface*>& InputStreams();
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& DeviceProperties() const;
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& FrameProperties() const;
+
+    size_t NumStages() const { return stages.size(); }
+
+protected:
+    struct Frame
+    {
+        std::vector<char> packet;
+        std::vector<unsigned char> input;
+        std::vector<std::vector<unsigned char>> intermediate;
+        std::vector<unsigned char> output;
+        picojson::value properties;
+    };
+    using FramePtr = std::unique_ptr<Frame>;
+    using Job = std::pair<size_t, FramePtr>;
+
+    void Read();
+    void Work();
+    void Fail(const std::exception& e);
+    void Return(FramePtr frame, unsigned char* image);
+
+    std::unique_ptr<VideoInterface> src;
+    std::vector<VideoInterface*> videoin;
+
+    // Filters run by the workers, from the last applied to the first, and the
+    // video they take their frames from.
+    std::vector<FrameFilterInterface*> stages;
+    std::vector<VideoInterface*> stage_videos;
+    VideoInterface* base;
+    PangoVideo* base_pango;
+
+    size_t num_threads;
+    size_t depth;
+    bool running;
+    size_t next_seq;
+
+    std::unique_ptr<BoundedQueue<FramePtr>> free_frames;
+    std::unique_ptr<BoundedQueue<Job>> todo;
+    std::unique_ptr<ReorderQueue<FramePtr>> done;
+    std::thread reader;
+    std::vector<std::thread> workers;
+
+    mutable picojson::value device_properties;
+    picojson::value frame_properties;
+};
+
+}
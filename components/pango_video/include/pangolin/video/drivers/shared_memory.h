@@ -4,18 +4,97 @@
 #include <pangolin/utils/posix/condition_variable.h>
 #include <pangolin/utils/posix/shared_memory_buffer.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
 namespace pangolin
 {
 
-class SharedMemoryVideo : public VideoInterface
+// Layout of a shared memory segment written by SharedMemoryVideoOutput:
+//
+//   [SharedMemoryRingHeader][info json][slot 0]...[slot num_slots-1]
+//
+// where each slot is a SharedMemoryRingSlot followed by frame_bytes of image
+// data and up to props_capacity bytes of frame properties json. Slots are
+// guarded seqlock style: seq is odd whilst the writer is filling a slot and
+// 2*(frame_number+1) once it is complete, so readers can detect frames torn
+// by the writer lapping them without ever blocking it.
+struct SharedMemoryRingHeader
+{
+    static constexpr uint64_t Magic = 0x31474e4952474e50ull; // "PNGRING1"
+
+    std::atomic<uint64_t> magic;
+    uint64_t num_slots;
+    uint64_t slot_stride;
+    uint64_t slots_offset;
+    uint64_t frame_bytes;
+    uint64_t props_capacity;
+    uint64_t info_offset;
+    uint64_t info_bytes;
+    std::atomic<uint64_t> frames_written;
+};
+
+struct SharedMemoryRingSlot
+{
+    std::atomic<uint64_t> seq;
+    std::atomic<uint32_t> leases;
+    uint32_t props_bytes;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Shared memory ring requires address-free atomics");
+
+constexpr size_t SharedMemoryRingAlign = 64;
+constexpr size_t SharedMemoryRingSlotHeaderBytes = SharedMemoryRingAlign;
+
+inline size_t SharedMemoryRingAligned(size_t bytes)
+{
+    return (bytes + SharedMemoryRingAlign - 1) / SharedMemoryRingAlign * SharedMemoryRingAlign;
+}
+
+class PANGOLIN_EXPORT SharedMemoryVideo : public VideoInterface, public VideoPropertiesInterface
 {
 public:
+  // Zero-copy access to a frame within the ring. The writer avoids slots with
+  // outstanding leases while others are free, but if every slot is leased it
+  // will overwrite one anyway; check Valid() once finished with Data().
+  class PANGOLIN_EXPORT Lease
+  {
+  public:
+    Lease();
+    Lease(Lease&& o);
+    Lease& operator=(Lease&& o);
+    Lease(const Lease&) = delete;
+    ~Lease();
+
+    const unsigned char* Data() const { return data; }
+    const picojson::value& FrameProperties() const { return frame_properties; }
+    uint64_t FrameNumber() const { return seq/2 - 1; }
+
+    // True if Data() has not been touched by the writer since acquired
+    bool Valid() const;
+
+    void Release();
+
+  private:
+    friend class SharedMemoryVideo;
+    SharedMemoryRingSlot* slot;
+    uint64_t seq;
+    const unsigned char* data;
+    picojson::value frame_properties;
+  };
+
+  // Legacy single buffer written by an external process, guarded by flock
   SharedMemoryVideo(size_t w, size_t h, std::string pix_fmt,
     const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory,
     const std::shared_ptr<ConditionVariableInterface>& buffer_full);
+
+  // Multi-slot ring written by SharedMemoryVideoOutput
+  SharedMemoryVideo(
+    const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory,
+    const std::shared_ptr<ConditionVariableInterface>& buffer_full);
+
   ~SharedMemoryVideo();
 
   size_t SizeBytes() const;
@@ -25,12 +104,43 @@ public:
   bool GrabNext(unsigned char *image, bool wait);
   bool GrabNewest(unsigned char *image, bool wait);
 
+  const picojson::value& DeviceProperties() const;
+  const picojson::value& FrameProperties() const;
+
+  // Lease the next (or newest) unseen frame in the ring without copying it.
+  // Only supported for segments written by SharedMemoryVideoOutput.
+  bool GrabNextLease(Lease& lease, bool wait = true);
+  bool GrabNewestLease(Lease& lease, bool wait = true);
+
+  // Frames published by the writer which this reader never saw
+  size_t FramesDropped() const { return _frames_dropped; }
+
+  static bool IsRing(const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory);
+
 private:
+  bool GrabLegacy(unsigned char* image, bool wait);
+  bool GrabRing(unsigned char* image, bool wait, bool newest);
+  bool AcquireLease(Lease& lease, bool wait, bool newest);
+
+  // Find the slot holding the oldest (or newest) complete frame not yet seen
+  SharedMemoryRingSlot* FindFrame(bool newest, uint64_t& seq) const;
+  bool WaitForFrame(bool wait) const;
+  void MarkSeen(uint64_t seq);
+
+  const unsigned char* SlotData(const SharedMemoryRingSlot* slot) const;
+  const char* SlotProps(const SharedMemoryRingSlot* slot) const;
+
   PixelFormat _fmt;
   size_t _frame_size;
   std::vector<StreamInfo> _streams;
   std::shared_ptr<SharedMemoryBufferInterface> _shared_memory;
   std::shared_ptr<ConditionVariableInterface> _buffer_full;
+
+  SharedMemoryRingHeader* _ring;
+  uint64_t _next_frame;
+  size_t _frames_dropped;
+  picojson::value _device_properties;
+  picojson::value _frame_properties;
 };
 
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <pangolin/video/video_output_interface.h>
+#include <pangolin/video/drivers/shared_memory.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pangolin
+{
+
+// Publish frames into a SharedMemoryRingHeader ring, for any number of local
+// shmem:// readers. Writing never waits on readers: a reader which falls more
+// than num_slots frames behind simply skips the frames it missed.
+class PANGOLIN_EXPORT SharedMemoryVideoOutput : public VideoOutputInterface
+{
+public:
+    SharedMemoryVideoOutput(const std::string& name, size_t num_slots, size_t props_capacity);
+    ~SharedMemoryVideoOutput();
+
+    const std::vector<StreamInfo>& Streams() const override;
+    void SetStreams(const std::vector<StreamInfo>& streams, const std::string& uri, const picojson::value& device_properties) override;
+    int WriteStreams(const unsigned char* data, const picojson::value& frame_properties) override;
+    bool IsPipe() const override;
+
+protected:
+    SharedMemoryRingSlot* Slot(size_t i);
+
+    // Mark and return a slot for writing, preferring those without leases
+    SharedMemoryRingSlot* ClaimSlot(uint64_t odd_seq);
+
+    const std::string name;
+    const size_t num_slots;
+    const size_t props_capacity;
+
+    std::vector<StreamInfo> streams;
+    std::shared_ptr<SharedMemoryBufferInterface> shared_memory;
+    std::shared_ptr<ConditionVariableInterface> buffer_full;
+    SharedMemoryRingHeader* ring;
+    size_t last_slot;
+    uint64_t frames_written;
+};
+
+}
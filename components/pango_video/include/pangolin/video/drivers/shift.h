@@ -34,7 +34,7 @@ namespace pangolin
 {
 
 // Video class that debayers its video input using the given method.
-class PANGOLIN_EXPORT ShiftVideo : public VideoInterface, public VideoFilterInterface
+class PANGOLIN_EXPORT ShiftVideo : public VideoInterface, public VideoFilterInterface, public RowFilterInterface, public FrameFilterInterface
 {
 public:
     ShiftVideo(std::unique_ptr<VideoInterface>& videoin,
@@ -62,6 +62,12 @@ public:
 
     std::vector<VideoInterface*>& InputStreams();
 
+    //! Implement RowFilterInterface method
+    void ProcessRows(size_t stream, Image<uint8_t>& out, const Image<uint8_t>& in);
+
+    //! Implement FrameFilterInterface method
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
+
 protected:
     void Process(uint8_t* buffer_out, const uint8_t* buffer_in);
 
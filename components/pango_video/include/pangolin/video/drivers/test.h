@@ -32,11 +32,28 @@
 namespace pangolin
 {
 
-// Video class that outputs test video signal.
-class PANGOLIN_EXPORT TestVideo : public VideoInterface
+// Video class that outputs a synthetic test signal: white noise, or a moving
+// pattern with optional noise on top. Output is deterministic for a given
+// seed, frames can be paced to a frame rate with jitter, and each frame
+// carries a monotonic capture time. Noise comes from a fast generator seeded
+// for each row of each frame, so it never repeats between rows or frames.
+class PANGOLIN_EXPORT TestVideo : public VideoInterface, public VideoPropertiesInterface
 {
 public:
-    TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt);
+    enum class Pattern
+    {
+        Noise,    // White noise across every byte
+        Gradient, // Diagonal ramp per channel, moving each frame
+        Bayer,    // RGGB mosaic of the gradient, for single channel formats
+        Depth     // Tilted plane with a sphere moving across it
+    };
+
+    // noise is the amplitude of noise added to a pattern, as a fraction of
+    // full scale. fps of 0 generates frames as fast as they are grabbed, and
+    // num_frames of 0 never ends.
+    TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt,
+              Pattern pattern = Pattern::Noise, float noise = 0.0f, uint64_t seed = 0,
+              double fps = 0.0, double jitter_us = 0.0, size_t num_frames = 0);
     ~TestVideo();
     
     //! Implement VideoInput::Start()
@@ -56,10 +73,43 @@ public:
     
     //! Implement VideoInput::GrabNewest()
     bool GrabNewest( unsigned char* image, bool wait = true ) override;
-    
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& DeviceProperties() const override;
+
+    //! Implement VideoPropertiesInterface method
+    const picojson::value& FrameProperties() const override;
+
+    static Pattern PatternFromString(const std::string& str);
+
 protected:
+    // How samples of the pixel format are stored
+    enum class SampleType { U8, U16, Packed, F32, Other };
+
+    void Generate(unsigned char* image);
+    void PatternRow(uint32_t* levels, size_t stream, size_t y) const;
+
     std::vector<StreamInfo> streams;
     size_t size_bytes;
+
+    Pattern pattern;
+    SampleType sample_type;
+    uint32_t max_level;
+    uint64_t seed;
+    int64_t period_us;
+    int64_t jitter_us;
+    size_t num_frames;
+
+    size_t frame;
+    int64_t start_us;
+    int64_t last_capture_us;
+
+    uint32_t noise_amplitude;
+    std::vector<uint32_t> gradient_lut;
+    std::vector<uint32_t> levels;
+
+    picojson::value device_properties;
+    picojson::value frame_properties;
 };
 
 }
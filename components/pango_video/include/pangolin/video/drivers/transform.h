@@ -42,7 +42,8 @@ enum class TransformOptions
 class PANGOLIN_EXPORT TransformVideo :
     public VideoInterface,
     public VideoFilterInterface,
-    public BufferAwareVideoInterface
+    public BufferAwareVideoInterface,
+    public FrameFilterInterface
 {
 public:
     TransformVideo(std::unique_ptr<VideoInterface>& videoin, const std::vector<TransformOptions>& flips);
@@ -73,6 +74,9 @@ public:
 
     bool DropNFrames(uint32_t n);
 
+    //! Implement FrameFilterInterface method
+    void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties);
+
 protected:
     void Process(unsigned char* image, const unsigned char* buffer);
 
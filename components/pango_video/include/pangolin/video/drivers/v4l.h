@@ -32,6 +32,10 @@
 #include <asm/types.h>
 #include <linux/videodev2.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace pangolin
 {
 
@@ -44,12 +48,50 @@ typedef enum {
 struct buffer {
     void*  start;
     size_t length;
+    int    dmabuf_fd;
 };
 
 class PANGOLIN_EXPORT V4lVideo : public VideoInterface, public VideoUvcInterface, public VideoPropertiesInterface
 {
 public:
-    V4lVideo(const char* dev_name, uint32_t period, io_method io = IO_METHOD_MMAP, unsigned iwidth=0, unsigned iheight=0, unsigned v4l_format=V4L2_PIX_FMT_YUYV);
+    // Shared with leases, so that they can tell when the video has gone
+    struct LeaseOwner;
+
+    // Zero-copy access to a driver buffer (io=mmap only). The buffer is only
+    // returned to the driver once released, so holding more leases than the
+    // configured buffer count allows will stall capture. Data() is only valid
+    // whilst the V4lVideo exists; releasing a lease after it has been
+    // destroyed does nothing.
+    class PANGOLIN_EXPORT Lease
+    {
+    public:
+        Lease();
+        Lease(Lease&& o);
+        Lease& operator=(Lease&& o);
+        Lease(const Lease&) = delete;
+        ~Lease();
+
+        const unsigned char* Data() const { return data; }
+        size_t SizeBytes() const { return bytes; }
+        const picojson::value& FrameProperties() const { return frame_properties; }
+
+        // DMABUF file descriptor of the buffer, or -1 unless opened with dmabuf=1
+        int DmaBufFd() const { return dmabuf_fd; }
+
+        void Release();
+
+    private:
+        friend class V4lVideo;
+        std::shared_ptr<LeaseOwner> owner;
+        unsigned index;
+        const unsigned char* data;
+        size_t bytes;
+        int dmabuf_fd;
+        picojson::value frame_properties;
+    };
+
+    V4lVideo(const char* dev_name, uint32_t period, io_method io = IO_METHOD_MMAP, unsigned iwidth=0, unsigned iheight=0, unsigned v4l_format=V4L2_PIX_FMT_YUYV,
+             unsigned num_buffers = 4, bool export_dmabuf = false);
     ~V4lVideo();
 
     //! Implement VideoInput::Start()
@@ -70,6 +112,9 @@ public:
     //! Implement VideoInput::GrabNewest()
     bool GrabNewest( unsigned char* image, bool wait = true );
 
+    //! Dequeue the next frame without copying it out of the driver buffer
+    bool GrabNextLease( Lease& lease, bool wait = true );
+
     //! Implement VideoUvcInterface::IoCtrl()
     int IoCtrl(uint8_t unit, uint8_t ctrl, unsigned char* data, int len, UvcRequestCode req_code);
 
@@ -96,10 +141,13 @@ protected:
 
 
     int ReadFrame(unsigned char* image, bool wait = true);
+    bool WaitForFrame(bool wait);
+    void Requeue(unsigned index);
     void Mainloop();
 
     void init_read(unsigned int buffer_size);
     void init_mmap(const char* dev_name);
+    void export_dmabufs();
     void init_userp(const char* dev_name, unsigned int buffer_size);
 
     void init_device(const char* dev_name, unsigned iwidth, unsigned iheight, unsigned ifps, unsigned v4l_format = V4L2_PIX_FMT_YUYV, v4l2_field field = V4L2_FIELD_INTERLACED);
@@ -114,7 +162,17 @@ protected:
     int       fd;
     buffer*   buffers;
     unsigned  int n_buffers;
+    unsigned  int num_buffers_requested;
+    bool export_dmabuf;
+
+    // Buffers currently held by leases rather than queued with the driver.
+    // lease_mutex also guards running and the QBUF / STREAMON / STREAMOFF
+    // calls, so that a lease released whilst starting or stopping is queued
+    // exactly once.
+    std::mutex lease_mutex;
+    std::vector<bool> leased;
     bool running;
+    std::shared_ptr<LeaseOwner> lease_owner;
     unsigned width;
     unsigned height;
     float fps;
@@ -30,6 +30,8 @@
 #include <pangolin/video/video.h>
 #include <pangolin/video/video_output.h>
 
+#include <mutex>
+
 namespace pangolin
 {
 
@@ -62,7 +64,7 @@ struct PANGOLIN_EXPORT VideoInput
     /////////////////////////////////////////////////////////////
 
     VideoInput();
-    VideoInput(VideoInput&& other) = default;
+    VideoInput(VideoInput&& other);
     VideoInput(const std::string &input_uri, const std::string &output_uri = "pango:[buffer_size_mb=100]//video_log.pango");
     ~VideoInput();
 
@@ -97,6 +99,11 @@ struct PANGOLIN_EXPORT VideoInput
         return dynamic_cast<VideoType*>(video_src.get());
     }
 
+    // Output that frames are recorded to, or nullptr if not yet recording
+    VideoOutputInterface* Recorder() {
+        return video_recorder.get();
+    }
+
     const std::string& LogFilename() const;
     std::string& LogFilename();
 
@@ -115,12 +122,19 @@ struct PANGOLIN_EXPORT VideoInput
 protected:
     void InitialiseRecorder();
 
+    // Write a grabbed frame to the recorder, if it should be
+    void RecordGrabbed(unsigned char* image, bool success);
+
     Uri uri_input;
     Uri uri_output;
 
     std::unique_ptr<VideoInterface> video_src;
     std::unique_ptr<VideoOutputInterface> video_recorder;
 
+    // Guards video_recorder and the recording state below, so that recording
+    // can be started and stopped whilst another thread waits in GrabNext.
+    mutable std::mutex recorder_mutex;
+
     // Use to store either video_src or video_file for VideoFilterInterface,
     // depending on which is active
     std::vector<VideoInterface*> videos;
@@ -155,6 +155,32 @@ struct PANGOLIN_EXPORT VideoFilterInterface
     virtual std::vector<VideoInterface*>& InputStreams() = 0;
 };
 
+//! Implemented by filters whose output rows each depend only on the same row
+//! of their input, such as per-pixel operations. OpenVideo fuses consecutive
+//! filters of this kind, so that frames pass through the whole run a band of
+//! rows at a time whilst still in cache (see FusedVideo).
+struct PANGOLIN_EXPORT RowFilterInterface
+{
+    virtual ~RowFilterInterface() {}
+
+    //! Filter a band of rows of stream from in, laid out as the filter's input
+    //! stream, to out, laid out as its output stream. Both have the same height.
+    virtual void ProcessRows(size_t stream, Image<unsigned char>& out, const Image<unsigned char>& in) = 0;
+};
+
+//! Implemented by filters that can process a whole frame handed to them
+//! rather than one they grabbed, so that several frames may be in flight at
+//! once (see ParallelVideo). ProcessFrame may be called concurrently, so it
+//! must not modify the filter.
+struct PANGOLIN_EXPORT FrameFilterInterface
+{
+    virtual ~FrameFilterInterface() {}
+
+    //! Filter the frame in, laid out as the filter's input streams, into out,
+    //! laid out as its own. frame_properties are those of the input frame.
+    virtual void ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& frame_properties) = 0;
+};
+
 struct PANGOLIN_EXPORT VideoUvcInterface
 {
     virtual ~VideoUvcInterface() {}
@@ -27,6 +27,7 @@
 
 #include <pangolin/video/drivers/debayer.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
@@ -261,8 +262,9 @@ void ProcessImage(Image<Tout>& img_out, const Image<Tin>& img_in, bayer_method_t
     }
 }
 
-void DebayerVideo::ProcessStreams(unsigned char* out, const unsigned char *in)
+void DebayerVideo::ProcessFrame(unsigned char* out, const unsigned char *in, const picojson::value& frame_properties)
 {
+    PANGO_TRACE_SCOPE("video", "DebayerVideo::Process");
     const bool has_metadata_line = frame_properties.get_value<bool>(PANGO_HAS_LINE0_METADATA, false);
 
     for(size_t s=0; s<streams.size(); ++s) {
@@ -292,7 +294,7 @@ bool DebayerVideo::GrabNext( unsigned char* image, bool wait )
 {
     if(videoin[0]->GrabNext(buffer.get(),wait)) {
         frame_properties = GetVideoFrameProperties(videoin[0]);
-        ProcessStreams(image, buffer.get());
+        ProcessFrame(image, buffer.get(), frame_properties);
         return true;
     }else{
         return false;
@@ -304,7 +306,7 @@ bool DebayerVideo::GrabNewest( unsigned char* image, bool wait )
 {
     if(videoin[0]->GrabNewest(buffer.get(),wait)) {
         frame_properties = GetVideoFrameProperties(videoin[0]);
-        ProcessStreams(image, buffer.get());
+        ProcessFrame(image, buffer.get(), frame_properties);
         return true;
     }else{
         return false;
@@ -0,0 +1,260 @@
+#include <pangolin/video/drivers/fused.h>
+#include <pangolin/factory/factory_registry.h>
+#include <pangolin/video/video.h>
+#include <pangolin/utils/trace.h>
+#include <pangolin/video/video_exception.h>
+
+#include <algorithm>
+
+namespace pangolin
+{
+
+namespace
+{
+
+// Size of the band of rows that each stage processes at a time, chosen so
+// that the band and its intermediates stay in cache.
+const size_t BandBytes = 64 * 1024;
+
+Image<unsigned char> Band(const Image<unsigned char>& img, size_t r0, size_t rows)
+{
+    return Image<unsigned char>(const_cast<unsigned char*>(img.RowPtr(r0)), img.w, rows, img.pitch);
+}
+
+// A filter can only be fused with its input if every stream keeps its height,
+// since row r of the output must come from row r of the input.
+bool SameRows(VideoInterface* filter, VideoInterface* input)
+{
+    const std::vector<StreamInfo>& out = filter->Streams();
+    const std::vector<StreamInfo>& in = input->Streams();
+    if(out.size() != in.size()) return false;
+    for(size_t s=0; s < out.size(); ++s) {
+        if(out[s].Height() != in[s].Height()) return false;
+    }
+    return true;
+}
+
+}
+
+FusedVideo::FusedVideo(std::unique_ptr<VideoInterface>& top, const std::vector<RowFilterInterface*>& stages, VideoInterface* base)
+    : src(std::move(top)), stages(stages), base(base)
+{
+    videoin.push_back(src.get());
+    buffer.reset(new unsigned char[base->SizeBytes()]);
+    device_properties = GetVideoDeviceProperties(src.get());
+
+    // Recover the video of each stage, whose output streams describe the
+    // layout of the stage's intermediate rows.
+    for(RowFilterInterface* stage : stages) {
+        VideoInterface* video = dynamic_cast<VideoInterface*>(stage);
+        if(!video) throw VideoException("FusedVideo: stage is not a video.");
+        stage_videos.push_back(video);
+    }
+
+    const size_t num_streams = base->Streams().size();
+    band_rows.resize(num_streams);
+    for(size_t s=0; s < num_streams; ++s) {
+        size_t max_pitch = base->Streams()[s].Pitch();
+        for(VideoInterface* video : stage_videos) {
+            max_pitch = std::max(max_pitch, video->Streams()[s].Pitch());
+        }
+        band_rows[s] = std::max<size_t>(1, BandBytes / std::max<size_t>(1, max_pitch));
+    }
+    AllocateScratch(scratch);
+}
+
+void FusedVideo::AllocateScratch(Scratch& scratch) const
+{
+    // The top stage writes straight into the output frame
+    scratch.resize(band_rows.size());
+    for(size_t s=0; s < band_rows.size(); ++s) {
+        scratch[s].resize(stages.size());
+        for(size_t i=1; i < stages.size(); ++i) {
+            scratch[s][i].reset(new unsigned char[band_rows[s] * stage_videos[i]->Streams()[s].Pitch()]);
+        }
+    }
+}
+
+FusedVideo::~FusedVideo()
+{
+}
+
+//! Implement VideoInput::Start()
+void FusedVideo::Start()
+{
+    src->Start();
+}
+
+//! Implement VideoInput::Stop()
+void FusedVideo::Stop()
+{
+    src->Stop();
+}
+
+//! Implement VideoInput::SizeBytes()
+size_t FusedVideo::SizeBytes() const
+{
+    return src->SizeBytes();
+}
+
+//! Implement VideoInput::Streams()
+const std::vector<StreamInfo>& FusedVideo::Streams() const
+{
+    return src->Streams();
+}
+
+void FusedVideo::Process(unsigned char* image, const unsigned char* buffer, Scratch& scratch)
+{
+    PANGO_TRACE_SCOPE("video", "FusedVideo::Process");
+    for(size_t s=0; s < band_rows.size(); ++s) {
+        const Image<unsigned char> img_in = base->Streams()[s].StreamImage(buffer);
+        const Image<unsigned char> img_out = Streams()[s].StreamImage(image);
+
+        for(size_t r0=0; r0 < img_out.h; r0 += band_rows[s]) {
+            const size_t rows = std::min(band_rows[s], img_out.h - r0);
+            Image<unsigned char> in = Band(img_in, r0, rows);
+
+            for(size_t i = stages.size(); i-- > 0; ) {
+                const StreamInfo& si = stage_videos[i]->Streams()[s];
+                Image<unsigned char> out = (i == 0) ?
+                    Band(img_out, r0, rows) :
+                    Image<unsigned char>(scratch[s][i].get(), si.Width(), rows, si.Pitch());
+                stages[i]->ProcessRows(s, out, in);
+                in = out;
+            }
+        }
+    }
+}
+
+//! Implement VideoInput::GrabNext()
+bool FusedVideo::GrabNext( unsigned char* image, bool wait )
+{
+    if(base->GrabNext(buffer.get(), wait)) {
+        frame_properties = GetVideoFrameProperties(base);
+        Process(image, buffer.get(), scratch);
+        return true;
+    }else{
+        return false;
+    }
+}
+
+//! Implement VideoInput::GrabNewest()
+bool FusedVideo::GrabNewest( unsigned char* image, bool wait )
+{
+    if(base->GrabNewest(buffer.get(), wait)) {
+        frame_properties = GetVideoFrameProperties(base);
+        Process(image, buffer.get(), scratch);
+        return true;
+    }else{
+        return false;
+    }
+}
+
+std::vector<VideoInterface*>& FusedVideo::InputStreams()
+{
+    return videoin;
+}
+
+uint32_t FusedVideo::AvailableFrames() const
+{
+    BufferAwareVideoInterface* vpi = dynamic_cast<BufferAwareVideoInterface*>(base);
+    if(!vpi)
+    {
+        pango_print_warn("Fused: base interface is not buffer aware.");
+        return 0;
+    }
+    else
+    {
+        return vpi->AvailableFrames();
+    }
+}
+
+bool FusedVideo::DropNFrames(uint32_t n)
+{
+    BufferAwareVideoInterface* vpi = dynamic_cast<BufferAwareVideoInterface*>(base);
+    if(!vpi)
+    {
+        pango_print_warn("Fused: base interface is not buffer aware.");
+        return false;
+    }
+    else
+    {
+        return vpi->DropNFrames(n);
+    }
+}
+
+const picojson::value& FusedVideo::DeviceProperties() const
+{
+    return device_properties;
+}
+
+const picojson::value& FusedVideo::FrameProperties() const
+{
+    return frame_properties;
+}
+
+void FusedVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    // Band storage is small, so each concurrent call can have its own
+    Scratch local;
+    AllocateScratch(local);
+    Process(out, in, local);
+}
+
+std::unique_ptr<VideoInterface> FuseVideoFilters(std::unique_ptr<VideoInterface> video)
+{
+    std::vector<RowFilterInterface*> stages;
+    VideoInterface* base = video.get();
+
+    while(true) {
+        if(FusedVideo* fused = dynamic_cast<FusedVideo*>(base)) {
+            // Extend an existing fusion, bypassing it entirely
+            if(stages.empty()) break;
+            stages.insert(stages.end(), fused->Stages().begin(), fused->Stages().end());
+            base = fused->Base();
+            break;
+        }
+
+        RowFilterInterface* stage = dynamic_cast<RowFilterInterface*>(base);
+        VideoFilterInterface* filter = dynamic_cast<VideoFilterInterface*>(base);
+        if(!stage || !filter || filter->InputStreams().size() != 1) break;
+
+        VideoInterface* input = filter->InputStreams()[0];
+        if(!SameRows(base, input)) break;
+
+        stages.push_back(stage);
+        base = input;
+    }
+
+    if(stages.size() < 2) {
+        return video;
+    }
+
+    return std::unique_ptr<VideoInterface>(new FusedVideo(video, stages, base));
+}
+
+PANGOLIN_REGISTER_FACTORY(FusedVideo)
+{
+    struct FusedVideoFactory final : public TypedFactoryInterface<VideoInterface> {
+        std::map<std::string,Precedence> Schemes() const override
+        {
+            return {{"fuse",10}};
+        }
+        const char* Description() const override
+        {
+            return "Video Filter: run the chain of row filters below in a single pass.";
+        }
+        ParamSet Params() const override
+        {
+            return {{}};
+        }
+        std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
+            std::unique_ptr<VideoInterface> subvid = pangolin::OpenVideo(uri.url);
+            return FuseVideoFilters(std::move(subvid));
+        }
+    };
+
+    return FactoryRegistry::I()->RegisterFactory<VideoInterface>(std::make_shared<FusedVideoFactory>());
+}
+
+}
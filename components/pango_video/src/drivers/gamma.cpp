@@ -27,8 +27,16 @@
 
 #include <pangolin/video/drivers/gamma.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
+#include <pangolin/video/video.h>
+
+#ifdef __AVX2__
 #include <pangolin/utils/avx_math.h>
+#endif
+
+#include <cmath>
+#include <cstring>
 
 namespace pangolin
 {
@@ -102,6 +110,7 @@ const std::vector<StreamInfo>& GammaVideo::Streams() const
 template <typename T>
 void ApplyGamma(Image<uint8_t>& out,
                        const Image<uint8_t>& in,
+                       const size_t row_elems,
                        const float gamma,
                        const float channel_max_value);
 
@@ -109,6 +118,7 @@ void ApplyGamma(Image<uint8_t>& out,
 template <>
 void ApplyGamma<uint8_t>(Image<uint8_t>& out,
                          const Image<uint8_t>& in,
+                         const size_t row_elems,
                          const float gamma,
                          const float channel_max_value)
 {
@@ -128,8 +138,8 @@ void ApplyGamma<uint8_t>(Image<uint8_t>& out,
     {
         uint8_t* pout = out.ptr + r * out.pitch;
         uint8_t* pin = in.ptr + r * in.pitch;
-        const uint8_t* pin_end = in.ptr + (r + 1) * in.pitch;
-        const uint32_t numElems = in.pitch / sizeof(uint8_t);
+        const uint8_t* pin_end = pin + row_elems;
+        const uint32_t numElems = row_elems;
 
         constexpr int vecElems = 8;
 
@@ -165,6 +175,7 @@ void ApplyGamma<uint8_t>(Image<uint8_t>& out,
 template <>
 void ApplyGamma<uint16_t>(Image<uint8_t>& out,
                           const Image<uint8_t>& in,
+                          const size_t row_elems,
                           const float gamma,
                           const float channel_max_value)
 {
@@ -172,8 +183,8 @@ void ApplyGamma<uint16_t>(Image<uint8_t>& out,
     {
         uint16_t* pout = (uint16_t*)(out.ptr + r * out.pitch);
         uint16_t* pin = (uint16_t*)(in.ptr + r * in.pitch);
-        const uint16_t* pin_end = (uint16_t*)(in.ptr + (r + 1) * in.pitch);
-        const uint32_t numElems = in.pitch / sizeof(uint16_t);
+        const uint16_t* pin_end = pin + row_elems;
+        const uint32_t numElems = row_elems;
 
         constexpr int vecElems = 8;
 
@@ -192,11 +203,11 @@ void ApplyGamma<uint16_t>(Image<uint8_t>& out,
             __m256i gammaValuesI = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvtps_epi32(gammaValues), _mm256_set1_epi32(0)), _mm256_set1_epi32(65535));
 
             //Unshuffle shorts to end of vector
-            gammaValuesI = _mm256_packs_epi32(gammaValuesI, _mm256_setzero_si256());
+            gammaValuesI = _mm256_packus_epi32(gammaValuesI, _mm256_setzero_si256());
             gammaValuesI = _mm256_permute4x64_epi64(gammaValuesI, 0xD8);
 
             // Copy result out
-            *(__m128i*)pout = _mm256_castsi256_si128(gammaValuesI);
+            _mm_storeu_si128((__m128i*)pout, _mm256_castsi256_si128(gammaValuesI));
         }
 
         //Remainder loose ends
@@ -209,14 +220,15 @@ void ApplyGamma<uint16_t>(Image<uint8_t>& out,
 template <typename T>
 void ApplyGamma(Image<uint8_t>& out,
                 const Image<uint8_t>& in,
+                const size_t row_elems,
                 const float gamma,
                 const float channel_max_value)
 {
     for(size_t r = 0; r < out.h; ++r)
     {
         T* pout = (T*)(out.ptr + r*out.pitch);
-        T* pin = (T*)(in.ptr + r*in.pitch);
-        const T* pin_end = (T*)(in.ptr + (r+1)*in.pitch);
+        const T* pin = (const T*)(in.ptr + r*in.pitch);
+        const T* pin_end = pin + row_elems;
         while(pin != pin_end) {
             *(pout++) = T(std::pow(float(*(pin++)) / channel_max_value, gamma) * channel_max_value + 0.5f);
         }
@@ -224,54 +236,65 @@ void ApplyGamma(Image<uint8_t>& out,
 }
 #endif
 
-void GammaVideo::Process(uint8_t* buffer_out, const uint8_t* buffer_in)
+void GammaVideo::ProcessRows(size_t s, Image<uint8_t>& img_out, const Image<uint8_t>& img_in)
 {
-    for(size_t s=0; s<streams.size(); ++s) {
-        Image<uint8_t> img_out = Streams()[s].StreamImage(buffer_out);
-        const Image<uint8_t> img_in  = videoin[0]->Streams()[s].StreamImage(buffer_in);
-        const size_t bytes_per_pixel = Streams()[s].PixFormat().bpp / 8;
+    const size_t bytes_per_pixel = Streams()[s].PixFormat().bpp / 8;
 
-        auto i = stream_gammas.find(s);
+    auto i = stream_gammas.find(s);
 
-        if(i != stream_gammas.end() && i->second != 0.0f && i->second != 1.0f)
-        {
-            const float gamma = i->second;
+    if(i != stream_gammas.end() && i->second != 0.0f && i->second != 1.0f)
+    {
+        const float gamma = i->second;
 
-            if(Streams()[s].PixFormat().format == "GRAY8" ||
-               Streams()[s].PixFormat().format == "RGB24" ||
-               Streams()[s].PixFormat().format == "BGR24" ||
-               Streams()[s].PixFormat().format == "RGBA32" ||
-               Streams()[s].PixFormat().format == "BGRA32")
-            {
-                ApplyGamma<uint8_t>(img_out, img_in, gamma, std::pow(2, Streams()[s].PixFormat().channel_bit_depth) - 1);
-            }
-            else if(Streams()[s].PixFormat().format == "GRAY16LE" ||
-                    Streams()[s].PixFormat().format == "RGB48" ||
-                    Streams()[s].PixFormat().format == "BGR48" ||
-                    Streams()[s].PixFormat().format == "RGBA64" ||
-                    Streams()[s].PixFormat().format == "BGRA64")
-            {
-                ApplyGamma<uint16_t>(img_out, img_in, gamma, std::pow(2, Streams()[s].PixFormat().channel_bit_depth) - 1);
-            }
-            else
-            {
-                throw VideoException("GammaVideo: Stream format not supported");
-            }
+        if(Streams()[s].PixFormat().format == "GRAY8" ||
+           Streams()[s].PixFormat().format == "RGB24" ||
+           Streams()[s].PixFormat().format == "BGR24" ||
+           Streams()[s].PixFormat().format == "RGBA32" ||
+           Streams()[s].PixFormat().format == "BGRA32")
+        {
+            ApplyGamma<uint8_t>(img_out, img_in, img_in.w * Streams()[s].PixFormat().channels, gamma, std::pow(2, Streams()[s].PixFormat().channel_bit_depth) - 1);
+        }
+        else if(Streams()[s].PixFormat().format == "GRAY16LE" ||
+                Streams()[s].PixFormat().format == "RGB48" ||
+                Streams()[s].PixFormat().format == "BGR48" ||
+                Streams()[s].PixFormat().format == "RGBA64" ||
+                Streams()[s].PixFormat().format == "BGRA64")
+        {
+            ApplyGamma<uint16_t>(img_out, img_in, img_in.w * Streams()[s].PixFormat().channels, gamma, std::pow(2, Streams()[s].PixFormat().channel_bit_depth) - 1);
         }
         else
         {
-            //straight copy
-            if( img_out.w != img_in.w || img_out.h != img_in.h ) {
-                throw std::runtime_error("GammaVideo: Incompatible image sizes");
-            }
+            throw VideoException("GammaVideo: Stream format not supported");
+        }
+    }
+    else
+    {
+        //straight copy
+        if( img_out.w != img_in.w || img_out.h != img_in.h ) {
+            throw std::runtime_error("GammaVideo: Incompatible image sizes");
+        }
 
-            for(size_t y=0; y < img_out.h; ++y) {
-                std::memcpy(img_out.RowPtr((int)y), img_in.RowPtr((int)y), bytes_per_pixel * img_in.w);
-            }
+        for(size_t y=0; y < img_out.h; ++y) {
+            std::memcpy(img_out.RowPtr((int)y), img_in.RowPtr((int)y), bytes_per_pixel * img_in.w);
         }
     }
 }
 
+void GammaVideo::Process(uint8_t* buffer_out, const uint8_t* buffer_in)
+{
+    PANGO_TRACE_SCOPE("video", "GammaVideo::Process");
+    for(size_t s=0; s<streams.size(); ++s) {
+        Image<uint8_t> img_out = Streams()[s].StreamImage(buffer_out);
+        const Image<uint8_t> img_in  = videoin[0]->Streams()[s].StreamImage(buffer_in);
+        ProcessRows(s, img_out, img_in);
+    }
+}
+
+void GammaVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    Process(out, in);
+}
+
 //! Implement VideoInput::GrabNext()
 bool GammaVideo::GrabNext( uint8_t* image, bool wait )
 {
@@ -330,46 +353,43 @@ bool GammaVideo::DropNFrames(uint32_t n)
 PANGOLIN_REGISTER_FACTORY(GammaVideo)
 {
     struct GammaVideoFactory final : public TypedFactoryInterface<VideoInterface> {
-        GammaVideoFactory()
+        std::map<std::string,Precedence> Schemes() const override
         {
-            param_set_ = {{
-                {"gamma\\d+","1.0","gammaK, where 1 <= K <= N where N is the number of streams"}
+            return {{"gamma",10}};
+        }
+        const char* Description() const override
+        {
+            return "Video Filter: gamma correct pixel values.";
+        }
+        ParamSet Params() const override
+        {
+            return {{
+                {"gamma\\d+","1.0","gammaN, N:[1,streams]. Gamma exponent applied to normalised pixel values."},
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
-
-            ParamReader reader(param_set_, uri);
-            // Gamma for each stream
             std::map<size_t, float> stream_gammas;
+
+            ParamReader reader(Params(), uri);
+
             for(size_t i=0; i<100; ++i)
             {
                 const std::string gamma_key = pangolin::FormatString("gamma%",i+1);
 
-                if(uri.Contains(gamma_key))
+                if(reader.Contains(gamma_key))
                 {
-                    stream_gammas[i] = reader.Get<float>(gamma_key, 1.0f);
+                    stream_gammas[i] = reader.Get<float>(gamma_key);
                 }
             }
 
             std::unique_ptr<VideoInterface> subvid = pangolin::OpenVideo(uri.url);
-
-            return std::unique_ptr<VideoInterface> (new GammaVideo(subvid, stream_gammas));
-        }
-        FactoryUseInfo Help( const std::string& scheme ) const override {
-            return FactoryUseInfo(scheme, "Gamma corrects a set of video streams", param_set_);
-        }
-
-        bool ValidateUri( const std::string& scheme, const Uri& uri, std::unordered_set<std::string>& unrecognized_params) const override {
-            return ValidateUriAgainstParamSet(scheme, param_set_, uri, unrecognized_params );
+            return std::unique_ptr<VideoInterface>(
+                new GammaVideo(subvid, stream_gammas)
+            );
         }
-
-        bool IsValidated( const std::string& ) const override {return true;}
-
-        ParamSet param_set_;
     };
 
-    auto factory = std::make_shared<GammaVideoFactory>();
-    FactoryRegistry::I()->RegisterFactory<VideoInterface>(factory, 10, "gamma");
+    return FactoryRegistry::I()->RegisterFactory<VideoInterface>(std::make_shared<GammaVideoFactory>());
 }
 
 }
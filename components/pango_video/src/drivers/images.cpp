@@ -27,6 +27,7 @@
 
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/log.h>
 #include <pangolin/video/drivers/images.h>
 #include <pangolin/video/iostream_operators.h>
 
@@ -36,27 +37,45 @@
 namespace pangolin
 {
 
+TypedImage ImagesVideo::LoadChannel(size_t i, size_t c) const
+{
+    const std::string& filename = Filename(i,c);
+    const ImageFileType file_type = FileType(filename);
+
+    if(file_type == ImageFileTypeUnknown && unknowns_are_raw) {
+        // if raw_pitch is zero, assume image is packed.
+        const size_t pitch = raw_pitch ? raw_pitch : raw_fmt.bpp * raw_width / 8;
+        return LoadImage( filename, raw_fmt, raw_width, raw_height, pitch, raw_offset, raw_planes);
+    }else{
+        return LoadImage( filename, file_type );
+    }
+}
+
 bool ImagesVideo::LoadFrame(size_t i)
 {
     if( i < num_files) {
         Frame& frame = loaded[i];
         for(size_t c=0; c< num_channels; ++c) {
-            const std::string& filename = Filename(i,c);
-            const ImageFileType file_type = FileType(filename);
-
-            if(file_type == ImageFileTypeUnknown && unknowns_are_raw) {
-                // if raw_pitch is zero, assume image is packed.
-                const size_t pitch = raw_pitch ? raw_pitch : raw_fmt.bpp * raw_width / 8;
-                frame.push_back( LoadImage( filename, raw_fmt, raw_width, raw_height, pitch, raw_offset, raw_planes) );
-            }else{
-                frame.push_back( LoadImage( filename, file_type ) );
-            }
+            frame.push_back( LoadChannel(i,c) );
         }
         return true;
     }
     return false;
 }
 
+bool ImagesVideo::DecodeInto(size_t i, unsigned char* buffer) const
+{
+    for(size_t c=0; c < num_channels; ++c) {
+        const TypedImage img = LoadChannel(i,c);
+        const StreamInfo& si = streams[c];
+        if(!img.ptr || img.w != si.Width() || img.h != si.Height() || img.pitch != si.Pitch()) {
+            return false;
+        }
+        std::memcpy(buffer + (size_t)si.Offset(), img.ptr, si.SizeBytes());
+    }
+    return true;
+}
+
 void ImagesVideo::PopulateFilenamesFromJson(const std::string& filename)
 {
     std::ifstream ifs( PathExpand(filename));
@@ -142,9 +161,9 @@ void ImagesVideo::ConfigureStreamSizes()
     }
 }
 
-ImagesVideo::ImagesVideo(const std::string& wildcard_path)
+ImagesVideo::ImagesVideo(const std::string& wildcard_path, size_t prefetch, size_t prefetch_threads)
     : num_files(-1), num_channels(0), next_frame_id(0),
-      unknowns_are_raw(false)
+      unknowns_are_raw(false), prefetch(prefetch), should_run(false)
 {
     // Work out which files to sequence
     PopulateFilenames(wildcard_path);
@@ -154,7 +173,7 @@ ImagesVideo::ImagesVideo(const std::string& wildcard_path)
 
     ConfigureStreamSizes();
 
-    // TODO: Queue frames in another thread.
+    StartPrefetch(prefetch_threads);
 }
 
 ImagesVideo::ImagesVideo(
@@ -162,12 +181,13 @@ ImagesVideo::ImagesVideo(
     const PixelFormat& raw_fmt,
     size_t raw_width, size_t raw_height,
     size_t raw_pitch, size_t raw_offset,
-    size_t raw_planes
+    size_t raw_planes,
+    size_t prefetch, size_t prefetch_threads
 ) : num_files(-1), num_channels(0), next_frame_id(0),
     unknowns_are_raw(true), raw_fmt(raw_fmt),
     raw_width(raw_width), raw_height(raw_height),
     raw_planes(raw_planes), raw_pitch(raw_pitch),
-    raw_offset(raw_offset)
+    raw_offset(raw_offset), prefetch(prefetch), should_run(false)
 {
     // Work out which files to sequence
     PopulateFilenames(wildcard_path);
@@ -177,11 +197,145 @@ ImagesVideo::ImagesVideo(
 
     ConfigureStreamSizes();
 
-    // TODO: Queue frames in another thread.
+    StartPrefetch(prefetch_threads);
 }
 
 ImagesVideo::~ImagesVideo()
 {
+    {
+        std::lock_guard<std::mutex> l(cache_mutex);
+        should_run = false;
+    }
+    decode_cond.notify_all();
+    for(std::thread& t : prefetch_threads) {
+        t.join();
+    }
+}
+
+void ImagesVideo::StartPrefetch(size_t threads)
+{
+    if(prefetch == 0) return;
+
+    // Frames are served from the cache from now on
+    loaded[0].clear();
+
+    should_run = true;
+    for(size_t t=0; t < std::max<size_t>(1, threads); ++t) {
+        prefetch_threads.emplace_back(&ImagesVideo::PrefetchLoop, this);
+    }
+
+    std::lock_guard<std::mutex> l(cache_mutex);
+    SchedulePrefetch();
+}
+
+void ImagesVideo::SchedulePrefetch()
+{
+    const size_t begin = next_frame_id;
+    const size_t end = std::min(num_files, next_frame_id + prefetch);
+    auto in_window = [&](size_t i){ return begin <= i && i < end; };
+
+    // Forget requests we no longer need, e.g. after a Seek
+    for(auto it = decode_queue.begin(); it != decode_queue.end(); ) {
+        if(!in_window(*it)) {
+            auto f = cache.find(*it);
+            buffer_pool.push_back(std::move(f->second.buffer));
+            cache.erase(f);
+            it = decode_queue.erase(it);
+        }else{
+            ++it;
+        }
+    }
+
+    for(size_t i = begin; i < end; ++i) {
+        if(cache.find(i) == cache.end()) {
+            PrefetchedFrame& f = cache[i];
+            f.state = PrefetchedFrame::Queued;
+            if(buffer_pool.size()) {
+                f.buffer = std::move(buffer_pool.back());
+                buffer_pool.pop_back();
+            }else{
+                f.buffer.reset(new unsigned char[size_bytes]);
+            }
+            decode_queue.push_back(i);
+        }
+    }
+
+    // Keep up to another window's worth of decoded frames behind (or
+    // beyond) the current position for Seek to reuse, evicting furthest first
+    while(cache.size() > 2*prefetch) {
+        auto evict = cache.end();
+        size_t evict_dist = 0;
+        for(auto it = cache.begin(); it != cache.end(); ++it) {
+            const PrefetchedFrame::State st = it->second.state;
+            if(in_window(it->first) || st == PrefetchedFrame::Queued || st == PrefetchedFrame::Decoding) continue;
+            const size_t dist = it->first < begin ? begin - it->first : it->first - begin;
+            if(dist >= evict_dist) {
+                evict = it;
+                evict_dist = dist;
+            }
+        }
+        if(evict == cache.end()) break;
+        buffer_pool.push_back(std::move(evict->second.buffer));
+        cache.erase(evict);
+    }
+
+    if(decode_queue.size()) {
+        decode_cond.notify_all();
+    }
+}
+
+void ImagesVideo::PrefetchLoop()
+{
+    std::unique_lock<std::mutex> l(cache_mutex);
+
+    while(true) {
+        decode_cond.wait(l, [&](){ return !should_run || !decode_queue.empty(); });
+        if(!should_run) return;
+
+        const size_t i = decode_queue.front();
+        decode_queue.pop_front();
+
+        // Frames being decoded are never evicted, so this remains valid
+        PrefetchedFrame& f = cache.at(i);
+        f.state = PrefetchedFrame::Decoding;
+
+        l.unlock();
+        bool success = false;
+        try {
+            success = DecodeInto(i, f.buffer.get());
+        }catch(const std::exception& e) {
+            pango_print_warn("ImagesVideo: unable to load frame %zu: %s\n", i, e.what());
+        }
+        l.lock();
+
+        f.state = success ? PrefetchedFrame::Ready : PrefetchedFrame::Failed;
+        ready_cond.notify_all();
+    }
+}
+
+bool ImagesVideo::GrabPrefetched( unsigned char* image, bool wait )
+{
+    std::unique_lock<std::mutex> l(cache_mutex);
+
+    while(true) {
+        if(next_frame_id >= num_files) return false;
+
+        // Look the frame up again after every wait, since a Seek may have
+        // moved next_frame_id and evicted the frame we were waiting for.
+        SchedulePrefetch();
+        const PrefetchedFrame& f = cache.at(next_frame_id);
+
+        if(f.state == PrefetchedFrame::Ready) {
+            std::memcpy(image, f.buffer.get(), size_bytes);
+            next_frame_id++;
+            SchedulePrefetch();
+            return true;
+        }else if(f.state == PrefetchedFrame::Failed || !wait) {
+            return false;
+        }
+
+        ready_cond.wait(l);
+    }
 }
 
 //! Implement VideoInput::Start()
@@ -209,8 +363,12 @@ const std::vector<StreamInfo>& ImagesVideo::Streams() const
 }
 
 //! Implement VideoInput::GrabNext()
-bool ImagesVideo::GrabNext( unsigned char* image, bool /*wait*/ )
+bool ImagesVideo::GrabNext( unsigned char* image, bool wait )
 {
+    if(prefetch) {
+        return GrabPrefetched(image, wait);
+    }
+
     if(next_frame_id < loaded.size()) {
         Frame& frame = loaded[next_frame_id];
 
@@ -254,7 +412,13 @@ size_t ImagesVideo::GetTotalFrames() const
 
 size_t ImagesVideo::Seek(size_t frameid)
 {
+    std::lock_guard<std::mutex> l(cache_mutex);
     next_frame_id = std::max(size_t(0), std::min(frameid, num_files));
+    if(prefetch) {
+        SchedulePrefetch();
+        // Wake any waiting grab to look for the new frame
+        ready_cond.notify_all();
+    }
     return next_frame_id;
 }
 
@@ -295,13 +459,17 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideo)
                 {"size","640x480","RAW files only. Image size, required if fmt is specified"},
                 {"pitch","0","RAW files only. Specify distance from the start of one row to the next in bytes. If not specified, assumed image is packed."},
                 {"offset","0","Offset from the start of the file in bytes where the image starts"},
-                {"planes","1","Number of channel planes (outer array channels) for raw image. fmt should be the format of an element in the individual plane."}
+                {"planes","1","Number of channel planes (outer array channels) for raw image. fmt should be the format of an element in the individual plane."},
+                {"prefetch","0","Number of upcoming frames to decode in the background. 0 decodes each frame on demand."},
+                {"threads","1","Number of threads decoding frames when prefetch > 0."}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
             ParamReader reader(Params(),uri);
 
             const bool raw = reader.Contains("fmt");
+            const size_t prefetch = reader.Get<size_t>("prefetch");
+            const size_t threads = reader.Get<size_t>("threads");
             const std::string path = PathExpand(uri.url);
 
             if(raw) {
@@ -312,10 +480,10 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideo)
                 const size_t image_offset = reader.Get<int>("offset");
                 const size_t image_planes = reader.Get<int>("planes");
                 return std::unique_ptr<VideoInterface>( new ImagesVideo(
-                    path, fmt, dim.x, dim.y, image_pitch, image_offset, image_planes
+                    path, fmt, dim.x, dim.y, image_pitch, image_offset, image_planes, prefetch, threads
                 ));
             }else{
-                return std::unique_ptr<VideoInterface>( new ImagesVideo(path) );
+                return std::unique_ptr<VideoInterface>( new ImagesVideo(path, prefetch, threads) );
             }
         }
     };
@@ -29,13 +29,15 @@
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/image/image_io.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/log.h>
 #include <pangolin/video/drivers/images_out.h>
 
 namespace pangolin {
 
-ImagesVideoOutput::ImagesVideoOutput(const std::string& image_folder, const std::string& json_file_out, const std::string& image_file_extension)
+ImagesVideoOutput::ImagesVideoOutput(const std::string& image_folder, const std::string& json_file_out, const std::string& image_file_extension, size_t num_threads, size_t max_queued)
     : json_frames(picojson::array_type,true),
-      image_index(0), image_folder( PathExpand(image_folder) + "/" ), image_file_extension(image_file_extension)
+      image_index(0), image_folder( PathExpand(image_folder) + "/" ), image_file_extension(image_file_extension),
+      frame_size_bytes(0), max_queued(std::max<size_t>(1, max_queued)), should_run(true)
 {
     if(!json_file_out.empty()) {
         file.open(json_file_out);
@@ -43,10 +45,32 @@ ImagesVideoOutput::ImagesVideoOutput(const std::string& image_folder, const std:
             throw std::runtime_error("Unable to open json file for writing, " + json_file_out + ". Make sure output folder already exists.");
         }
     }
+
+    for(size_t t=0; t < std::max<size_t>(1, num_threads); ++t) {
+        writers.emplace_back(&ImagesVideoOutput::WriterLoop, this);
+    }
 }
 
 ImagesVideoOutput::~ImagesVideoOutput()
 {
+    // Finish writing everything queued
+    {
+        std::lock_guard<std::mutex> l(queue_mutex);
+        should_run = false;
+    }
+    job_cond.notify_all();
+    for(std::thread& t : writers) {
+        t.join();
+    }
+
+    if(writer_error) {
+        try {
+            std::rethrow_exception(writer_error);
+        }catch(const std::exception& e) {
+            pango_print_error("ImagesVideoOutput: failed to write images: %s\n", e.what());
+        }
+    }
+
     if(file.is_open())
     {
         const std::string video_uri = "images://" + image_folder + "archive.json";
@@ -68,23 +92,67 @@ const std::vector<StreamInfo>& ImagesVideoOutput::Streams() const
 
 void ImagesVideoOutput::SetStreams(const std::vector<StreamInfo>& streams, const std::string& uri, const picojson::value& device_properties)
 {
+    std::lock_guard<std::mutex> l(queue_mutex);
+    if(pending.size()) {
+        throw std::runtime_error("ImagesVideoOutput: unable to change streams whilst writing.");
+    }
+
     this->streams = streams;
     this->input_uri = uri;
     this->device_properties = device_properties;
+
+    frame_size_bytes = 0;
+    for(const StreamInfo& si : streams) {
+        frame_size_bytes = std::max(frame_size_bytes, (size_t)si.Offset() + si.SizeBytes());
+    }
+    buffer_pool.clear();
+}
+
+size_t ImagesVideoOutput::Backlog() const
+{
+    std::lock_guard<std::mutex> l(queue_mutex);
+    return pending.size();
 }
 
 int ImagesVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
 {
     picojson::value json_filenames(picojson::array_type, true);
 
-    // Write each stream image to file.
-    for(size_t s=0; s < streams.size(); ++s) {
-        const pangolin::StreamInfo& si = streams[s];
-        const std::string filename = pangolin::FormatString("image_%%%_%.%",std::setfill('0'),std::setw(10),image_index, s, image_file_extension);
-        json_filenames.push_back(filename);
-        const Image<unsigned char> img = si.StreamImage(data);
-        pangolin::SaveImage(img, si.PixFormat(), image_folder + filename);
+    std::unique_ptr<unsigned char[]> buffer;
+    {
+        std::unique_lock<std::mutex> l(queue_mutex);
+        space_cond.wait(l, [&](){ return pending.size() < max_queued || writer_error; });
+        if(writer_error) {
+            std::rethrow_exception(writer_error);
+        }
+        if(buffer_pool.size()) {
+            buffer = std::move(buffer_pool.back());
+            buffer_pool.pop_back();
+        }
+    }
+
+    // Take a copy so that the caller can reuse data immediately
+    if(!buffer) buffer.reset(new unsigned char[frame_size_bytes]);
+    std::copy(data, data + frame_size_bytes, buffer.get());
+
+    {
+        std::lock_guard<std::mutex> l(queue_mutex);
+        PendingFrame& frame = pending[image_index];
+        frame.data = std::move(buffer);
+        frame.streams_remaining = streams.size();
+
+        for(size_t s=0; s < streams.size(); ++s) {
+            const std::string filename = pangolin::FormatString("image_%%%_%.%",std::setfill('0'),std::setw(10),image_index, s, image_file_extension);
+            json_filenames.push_back(filename);
+            jobs.push_back({image_index, s, filename});
+        }
+
+        if(streams.empty()) {
+            buffer_pool.push_back(std::move(frame.data));
+            pending.erase(image_index);
+        }
     }
+    job_cond.notify_all();
 
     // Add frame_properties to json file.
     picojson::value json_frame;
@@ -96,6 +164,38 @@ int ImagesVideoOutput::WriteStreams(const unsigned char* data, const picojson::v
     return 0;
 }
 
+void ImagesVideoOutput::WriterLoop()
+{
+    std::unique_lock<std::mutex> l(queue_mutex);
+
+    while(true) {
+        job_cond.wait(l, [&](){ return !should_run || !jobs.empty(); });
+        if(jobs.empty()) return;
+
+        const Job job = jobs.front();
+        jobs.pop_front();
+        PendingFrame& frame = pending.at(job.frame);
+        const StreamInfo& si = streams[job.stream];
+
+        // frame is only erased once all of its streams are written
+        l.unlock();
+        try {
+            const Image<unsigned char> img = si.StreamImage(frame.data.get());
+            pangolin::SaveImage(img, si.PixFormat(), image_folder + job.filename);
+        }catch(...) {
+            std::lock_guard<std::mutex> el(queue_mutex);
+            if(!writer_error) writer_error = std::current_exception();
+        }
+        l.lock();
+
+        if(--frame.streams_remaining == 0) {
+            buffer_pool.push_back(std::move(frame.data));
+            pending.erase(job.frame);
+            space_cond.notify_all();
+        }
+    }
+}
+
 bool ImagesVideoOutput::IsPipe() const
 {
     return false;
@@ -115,7 +215,9 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideoOutput)
         ParamSet Params() const override
         {
             return {{
-                {"fmt","png","Output image format. Possible values are all Pangolin image formats e.g.: png,jpg,jpeg,ppm,pgm,pxm,pdm,zstd,lzf,p12b,exr,pango"}
+                {"fmt","png","Output image format. Possible values are all Pangolin image formats e.g.: png,jpg,jpeg,ppm,pgm,pxm,pdm,zstd,lzf,p12b,exr,pango"},
+                {"threads","0","Number of threads encoding and writing images. 0 for one per core."},
+                {"queue","0","Maximum number of frames waiting to be written before the producer blocks. 0 for twice the number of threads."}
             }};
         }
         std::unique_ptr<VideoOutputInterface> Open(const Uri& uri) override {
@@ -124,13 +226,17 @@ PANGOLIN_REGISTER_FACTORY(ImagesVideoOutput)
             const std::string images_folder = PathExpand(uri.url);
             const std::string json_filename = images_folder + "/archive.json";
             const std::string image_extension = reader.Get<std::string>("fmt");
+            size_t threads = reader.Get<size_t>("threads");
+            if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            size_t queue = reader.Get<size_t>("queue");
+            if(queue == 0) queue = 2 * threads;
 
             if(FileExists(json_filename)) {
                 throw std::runtime_error("Dataset already exists in directory.");
             }
 
             return std::unique_ptr<VideoOutputInterface>(
-                new ImagesVideoOutput(images_folder, json_filename, image_extension)
+                new ImagesVideoOutput(images_folder, json_filename, image_extension, threads, queue)
             );
         }
     };
@@ -4,14 +4,19 @@
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/image/image_io.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/memstreambuf.h>
+#include <pangolin/utils/trace.h>
 
 namespace pangolin
 {
 
-// this is defined in image_io_jpg.cpp but not in any public headers.
+// these are defined in image_io_jpg.cpp but not in any public headers.
 std::vector<std::streampos> GetMJpegOffsets(std::ifstream& is);
+void LoadJpg(std::istream& is, Image<unsigned char>& image, const PixelFormat& fmt);
 
-MjpegVideo::MjpegVideo(const std::string& filename)
+MjpegVideo::MjpegVideo(const std::string& filename, size_t num_threads, size_t depth)
+    : next_frame_id(0), num_threads(num_threads),
+      depth(depth ? depth : std::max<size_t>(1, 2 * num_threads)), decoding(false)
 {
     const std::string full_path = PathExpand(filename);
     if(!FileExists(full_path)) {
@@ -29,31 +34,42 @@ MjpegVideo::MjpegVideo(const std::string& filename)
     }
 
     offsets = GetMJpegOffsets(bFile);
+    if(offsets.empty()) {
+        throw VideoException("Unable to load first jpeg in mjpeg stream");
+    }
+    bFile.clear();
+    bFile.seekg(0, std::ios::end);
+    file_end = bFile.tellg();
 
-    next_image = LoadImage(bFile, ImageFileType::ImageFileTypeJpg);
-    if(!next_image.IsValid()) {
+    ReadJpeg(0, jpeg_buffer);
+    imemstreambuf buf(jpeg_buffer.data(), jpeg_buffer.size());
+    std::istream is(&buf);
+    const TypedImage first_image = LoadImage(is, ImageFileType::ImageFileTypeJpg);
+    if(!first_image.IsValid()) {
         throw VideoException("Unable to load first jpeg in mjpeg stream");
     }
 
-    streams.emplace_back(next_image.fmt, next_image.w, next_image.h, next_image.pitch, nullptr);
-    size_bytes = next_image.SizeBytes();
+    streams.emplace_back(first_image.fmt, first_image.w, first_image.h, first_image.pitch, nullptr);
+    size_bytes = first_image.SizeBytes();
 }
 
 MjpegVideo::~MjpegVideo()
 {
-
+    StopDecoding();
 }
 
 //! Implement VideoInput::Start()
 void MjpegVideo::Start()
 {
-
+    if(num_threads > 0 && !decoding) {
+        StartDecoding();
+    }
 }
 
 //! Implement VideoInput::Stop()
 void MjpegVideo::Stop()
 {
-
+    StopDecoding();
 }
 
 //! Implement VideoInput::SizeBytes()
@@ -68,28 +84,127 @@ const std::vector<StreamInfo>& MjpegVideo::Streams() const
     return streams;
 }
 
-bool MjpegVideo::LoadNext()
+void MjpegVideo::ReadJpeg(size_t frameid, std::vector<char>& jpeg)
 {
-    if(!next_image.IsValid() && bFile.good()) {
-        try {
-            next_image = LoadImage(bFile, ImageFileType::ImageFileTypeJpg);
-        }  catch (const std::runtime_error&) {
-            return false;
+    PANGO_TRACE_SCOPE("video", "MjpegVideo::ReadJpeg");
+    const std::streampos end = frameid + 1 < offsets.size() ? offsets[frameid + 1] : file_end;
+    jpeg.resize(end - offsets[frameid]);
+    bFile.clear();
+    bFile.seekg(offsets[frameid]);
+    bFile.read(jpeg.data(), jpeg.size());
+    if(!bFile) {
+        throw VideoException("MjpegVideo: Unable to read jpeg for frame " + std::to_string(frameid));
+    }
+}
+
+void MjpegVideo::Decode(const std::vector<char>& jpeg, unsigned char* image) const
+{
+    PANGO_TRACE_SCOPE("video", "MjpegVideo::Decode");
+    imemstreambuf buf(jpeg.data(), jpeg.size());
+    std::istream is(&buf);
+    Image<unsigned char> dst = streams[0].StreamImage(image);
+    LoadJpg(is, dst, streams[0].PixFormat());
+}
+
+void MjpegVideo::StartDecoding()
+{
+    free_frames.reset(new BoundedQueue<FramePtr>(depth));
+    todo.reset(new BoundedQueue<Job>(depth));
+    done.reset(new ReorderQueue<FramePtr>());
+
+    for(size_t i=0; i < depth; ++i) {
+        FramePtr frame(new Frame);
+        frame->image.resize(size_bytes);
+        free_frames->Push(std::move(frame));
+    }
+
+    decoding = true;
+    reader = std::thread(&MjpegVideo::Read, this, next_frame_id);
+    for(size_t i=0; i < num_threads; ++i) {
+        workers.emplace_back(&MjpegVideo::Work, this);
+    }
+}
+
+void MjpegVideo::StopDecoding()
+{
+    if(decoding) {
+        free_frames->Close();
+        todo->Close();
+        done->Abort();
+        reader.join();
+        for(std::thread& w : workers) w.join();
+        workers.clear();
+        decoding = false;
+    }
+}
+
+void MjpegVideo::Read(size_t first_frame)
+{
+    Tracer::Instance().SetThreadName("MjpegVideo reader");
+    try{
+        FramePtr frame;
+        for(size_t frameid = first_frame; frameid < offsets.size(); ++frameid) {
+            if(!free_frames->Pop(frame)) return;
+            ReadJpeg(frameid, frame->jpeg);
+            if(!todo->Push(Job(frameid, std::move(frame)))) return;
+        }
+        done->Finish(offsets.size());
+        todo->Close();
+    }catch(const std::exception& e) {
+        Fail(e);
+    }
+}
+
+void MjpegVideo::Work()
+{
+    Tracer::Instance().SetThreadName("MjpegVideo worker");
+    try{
+        Job job;
+        while(todo->Pop(job)) {
+            Decode(job.second->jpeg, job.second->image.data());
+            done->Put(job.first, std::move(job.second));
         }
+    }catch(const std::exception& e) {
+        Fail(e);
     }
-    return next_image.IsValid();
+}
+
+void MjpegVideo::Fail(const std::exception& e)
+{
+    pango_print_warn("MjpegVideo: %s\n", e.what());
+    free_frames->Close();
+    todo->Close();
+    done->Abort();
 }
 
 //! Implement VideoInput::GrabNext()
 bool MjpegVideo::GrabNext( unsigned char* image, bool /*wait*/ )
 {
-    if( LoadNext() ) {
-        memcpy(image, next_image.ptr, size_bytes);
-        next_image.Deallocate();
-        ++next_frame_id;
-        return true;
+    PANGO_TRACE_SCOPE("video", "MjpegVideo::GrabNext");
+    if(next_frame_id >= offsets.size()) {
+        return false;
+    }
+
+    if(num_threads == 0) {
+        try {
+            ReadJpeg(next_frame_id, jpeg_buffer);
+            Decode(jpeg_buffer, image);
+        }  catch (const std::runtime_error&) {
+            return false;
+        }
+    }else{
+        if(!decoding) StartDecoding();
+
+        FramePtr frame;
+        if(!done->Get(next_frame_id, frame)) {
+            return false;
+        }
+        memcpy(image, frame->image.data(), size_bytes);
+        free_frames->Push(std::move(frame));
     }
-    return false;
+
+    ++next_frame_id;
+    return true;
 }
 
 //! Implement VideoInput::GrabNewest()
@@ -110,16 +225,13 @@ size_t MjpegVideo::GetTotalFrames() const
 
 size_t MjpegVideo::Seek(size_t frameid)
 {
+    // Clamp to within range
+    frameid = std::min(frameid, offsets.size()-1);
+
     if(frameid != next_frame_id) {
-        // Clamp to within range
-        next_frame_id = std::min(frameid, offsets.size()-1);
-        // Clear any eof markers etc
-        bFile.clear();
-        bFile.seekg(offsets[next_frame_id]);
-        // Remove any cached image data
-        next_image.Deallocate();
-    }else{
-        // Do nothing
+        // Frames decoded ahead are for the old position
+        StopDecoding();
+        next_frame_id = frameid;
     }
     return next_frame_id;
 }
@@ -139,10 +251,15 @@ PANGOLIN_REGISTER_FACTORY(MjpegVideo)
         ParamSet Params() const override
         {
             return {{
+                {"threads","2","Number of threads decoding ahead. 0 to decode on grabbing, straight into the caller's buffer."},
+                {"depth","0","Maximum number of frames decoded ahead. 0 for twice the number of threads."}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
-            return std::unique_ptr<VideoInterface>(new MjpegVideo(uri.url));
+            ParamReader reader(Params(), uri);
+            const size_t threads = reader.Get<size_t>("threads");
+            const size_t depth = reader.Get<size_t>("depth");
+            return std::unique_ptr<VideoInterface>(new MjpegVideo(uri.url, threads, depth));
         }
     };
 
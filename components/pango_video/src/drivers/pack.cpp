@@ -27,20 +27,10 @@
 
 #include <pangolin/video/drivers/pack.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
-#ifdef DEBUGUNPACK
-  #include <pangolin/utils/timer.h>
-  #define TSTART() pangolin::basetime start,last,now; start = pangolin::TimeNow(); last = start;
-  #define TGRABANDPRINT(...)  now = pangolin::TimeNow(); fprintf(stderr,"UNPACK: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr, " %fms.\n",1000*pangolin::TimeDiff_s(last, now)); last = now;
-  #define DBGPRINT(...) fprintf(stderr,"UNPACK: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr,"\n");
-#else
-  #define TSTART()
-  #define TGRABANDPRINT(...)
-  #define DBGPRINT(...)
-#endif
-
 namespace pangolin
 {
 
@@ -158,30 +148,38 @@ void ConvertTo12bit(
     }
 }
 
+void PackVideo::ProcessRows(size_t s, Image<unsigned char>& img_out, const Image<unsigned char>& img_in)
+{
+    const int bits_out = Streams()[s].PixFormat().bpp;
+
+    if(videoin[0]->Streams()[s].PixFormat().format == "GRAY16LE") {
+        if(bits_out == 8) {
+            ConvertTo8bit<uint16_t>(img_out, img_in);
+        }else if( bits_out == 10) {
+            ConvertTo10bit<uint16_t>(img_out, img_in);
+        }else if( bits_out == 12){
+            ConvertTo12bit<uint16_t>(img_out, img_in);
+        }else{
+            throw pangolin::VideoException("Unsupported bitdepths.");
+        }
+    }else{
+            throw pangolin::VideoException("Unsupported input pix format.");
+    }
+}
+
 void PackVideo::Process(unsigned char* image, const unsigned char* buffer)
 {
-    TSTART()
+    PANGO_TRACE_SCOPE("video", "PackVideo::Process");
     for(size_t s=0; s<streams.size(); ++s) {
         const Image<unsigned char> img_in  = videoin[0]->Streams()[s].StreamImage(buffer);
         Image<unsigned char> img_out = Streams()[s].StreamImage(image);
-
-        const int bits_out = Streams()[s].PixFormat().bpp;
-
-        if(videoin[0]->Streams()[s].PixFormat().format == "GRAY16LE") {
-            if(bits_out == 8) {
-                ConvertTo8bit<uint16_t>(img_out, img_in);
-            }else if( bits_out == 10) {
-                ConvertTo10bit<uint16_t>(img_out, img_in);
-            }else if( bits_out == 12){
-                ConvertTo12bit<uint16_t>(img_out, img_in);
-            }else{
-                throw pangolin::VideoException("Unsupported bitdepths.");
-            }
-        }else{
-                throw pangolin::VideoException("Unsupported input pix format.");
-        }
+        ProcessRows(s, img_out, img_in);
     }
-    TGRABANDPRINT("Packing took ")
+}
+
+void PackVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    Process(out, in);
 }
 
 //! Implement VideoInput::GrabNext()
@@ -271,7 +269,3 @@ PANGOLIN_REGISTER_FACTORY(PackVideo)
 }
 
 }
-
-#undef TSTART
-#undef TGRABANDPRINT
-#undef DBGPRINT
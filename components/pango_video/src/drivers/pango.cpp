@@ -26,10 +26,13 @@
  */
 
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/log/packet_meta.h>
 #include <pangolin/log/playback_session.h>
 #include <pangolin/utils/file_extension.h>
 #include <pangolin/utils/file_utils.h>
+#include <pangolin/utils/memstreambuf.h>
 #include <pangolin/utils/signal_slot.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/drivers/pango.h>
 
 #include <functional>
@@ -90,33 +93,38 @@ void PangoVideo::Stop()
 
 bool PangoVideo::GrabNext(unsigned char* image, bool /*wait*/)
 {
+    PANGO_TRACE_SCOPE("video", "PangoVideo::GrabNext");
     try
     {
         Packet fi = _reader->NextFrame(_src_id);
-        _frame_properties = fi.meta;
+        // Binary metadata is decoded on demand in FrameProperties()
+        _frame_properties = std::move(fi.meta);
+        _frame_properties_binary = std::move(fi.meta_binary);
 
-        if(_fixed_size) {
-            fi.Stream().read(reinterpret_cast<char*>(image), _size_bytes);
-        }else{
-            for(size_t s=0; s < _streams.size(); ++s) {
-                StreamInfo& si = _streams[s];
-                pangolin::Image<unsigned char> dst = si.StreamImage(image);
-
-                if(stream_decoder[s]) {
-                    pangolin::TypedImage img = stream_decoder[s](fi.Stream());
-                    PANGO_ENSURE(img.IsValid());
-
-                    // TODO: We can avoid this copy by decoding directly into img
-                    for(size_t row =0; row < dst.h; ++row) {
-                        std::memcpy(dst.RowPtr(row), img.RowPtr(row), si.RowBytes());
-                    }
-                }else{
-                    for(size_t row =0; row < dst.h; ++row) {
-                        fi.Stream().read((char*)dst.RowPtr(row), si.RowBytes());
-                    }
-                }
-            }
-        }
+        Decode(fi.Stream(), image);
+
+        _event_promise.WaitAndRenew(_source->NextPacketTime());
+        return true;
+    }
+    catch(...)
+    {
+        _frame_properties = picojson::value();
+        _frame_properties_binary.clear();
+        return false;
+    }
+}
+
+bool PangoVideo::GrabPacket(std::vector<char>& packet)
+{
+    PANGO_TRACE_SCOPE("video", "PangoVideo::GrabPacket");
+    try
+    {
+        Packet fi = _reader->NextFrame(_src_id);
+        _frame_properties = std::move(fi.meta);
+        _frame_properties_binary = std::move(fi.meta_binary);
+
+        packet.resize(fi.BytesRemaining());
+        fi.Stream().read(packet.data(), packet.size());
 
         _event_promise.WaitAndRenew(_source->NextPacketTime());
         return true;
@@ -124,10 +132,54 @@ bool PangoVideo::GrabNext(unsigned char* image, bool /*wait*/)
     catch(...)
     {
         _frame_properties = picojson::value();
+        _frame_properties_binary.clear();
         return false;
     }
 }
 
+void PangoVideo::DecodePacket(const std::vector<char>& packet, unsigned char* image) const
+{
+    imemstreambuf buf(packet.data(), packet.size());
+    std::istream is(&buf);
+    Decode(is, image);
+}
+
+void PangoVideo::Decode(std::istream& is, unsigned char* image) const
+{
+    PANGO_TRACE_SCOPE("video", "PangoVideo::Decode");
+    if(_fixed_size) {
+        is.read(reinterpret_cast<char*>(image), _size_bytes);
+    }else{
+        for(size_t s=0; s < _streams.size(); ++s) {
+            const StreamInfo& si = _streams[s];
+            pangolin::Image<unsigned char> dst = si.StreamImage(image);
+
+            if(stream_decoder[s]) {
+                pangolin::TypedImage img = stream_decoder[s](is);
+                PANGO_ENSURE(img.IsValid());
+
+                // TODO: We can avoid this copy by decoding directly into img
+                for(size_t row =0; row < dst.h; ++row) {
+                    std::memcpy(dst.RowPtr(row), img.RowPtr(row), si.RowBytes());
+                }
+            }else{
+                for(size_t row =0; row < dst.h; ++row) {
+                    is.read((char*)dst.RowPtr(row), si.RowBytes());
+                }
+            }
+        }
+    }
+}
+
+const picojson::value& PangoVideo::FrameProperties() const
+{
+    if(!_frame_properties_binary.empty()) {
+        _frame_properties = DecodeBinaryMeta(_frame_properties_binary.data(), _frame_properties_binary.size());
+        _frame_properties_binary.clear();
+    }
+    return _frame_properties;
+}
+
 bool PangoVideo::GrabNewest( unsigned char* image, bool wait )
 {
     return GrabNext(image, wait);
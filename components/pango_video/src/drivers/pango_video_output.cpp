@@ -31,6 +31,7 @@
 #include <pangolin/utils/picojson.h>
 #include <pangolin/utils/sigstate.h>
 #include <pangolin/utils/timer.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/drivers/pango_video_output.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video_interface.h>
@@ -51,7 +52,7 @@ void SigPipeHandler(int sig)
     SigState::I().sig_callbacks.at(sig).value = true;
 }
 
-PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris)
+PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_size_bytes, const std::map<size_t, std::string> &stream_encoder_uris, bool binary_meta)
     : filename(filename),
       packetstream_buffer_size_bytes(buffer_size_bytes),
       packetstreamsrcid(-1),
@@ -60,6 +61,8 @@ PangoVideoOutput::PangoVideoOutput(const std::string& filename, size_t buffer_si
       fixed_size(true),
       stream_encoder_uris(stream_encoder_uris)
 {
+    packetstream.SetBinaryMeta(binary_meta);
+
     if(!is_pipe)
     {
         packetstream.Open(filename, packetstream_buffer_size_bytes);
@@ -149,10 +152,8 @@ void PangoVideoOutput::SetStreams(const std::vector<StreamInfo>& st, const std::
     }
 }
 
-int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
+bool PangoVideoOutput::ReadyToWrite()
 {
-    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
-
 #ifndef _WIN_
     if (is_pipe)
     {
@@ -197,68 +198,101 @@ int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::va
         }
 
         if (!packetstream.IsOpen())
-            return 0;
+            return false;
     }
 #endif
 
+    return true;
+}
+
+int PangoVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
+{
+    PANGO_TRACE_SCOPE("video", "PangoVideoOutput::WriteStreams");
+    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
+
+    if(!ReadyToWrite())
+        return 0;
+
     if(!fixed_size) {
-        // TODO: Make this more efficient (without so many allocs and memcpy's)
+        std::vector<uint8_t> encoded;
+        EncodeStreams(data, encoded);
+        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties);
+    }else{
+        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(data), host_reception_time_us, total_frame_size, frame_properties);
+    }
 
-        std::vector<memstreambuf> encoded_stream_data;
+    return 0;
+}
 
-        // Create buffers for compressed data: the first will be reused for all the data later
-        encoded_stream_data.emplace_back(total_frame_size);
-        for(size_t i=1; i < streams.size(); ++i) {
-            encoded_stream_data.emplace_back(streams[i].SizeBytes());
-        }
+void PangoVideoOutput::EncodeStreams(const unsigned char* data, std::vector<uint8_t>& encoded) const
+{
+    PANGO_TRACE_SCOPE("video", "PangoVideoOutput::EncodeStreams");
+    if(fixed_size) {
+        encoded.assign(data, data + total_frame_size);
+        return;
+    }
+
+    // TODO: Make this more efficient (without so many allocs and memcpy's)
 
-        // lambda encodes frame data i to encoded_stream_data[i]
-        auto encode_stream = [&](int i){
-            encoded_stream_data[i].clear();
-            std::ostream encode_stream(&encoded_stream_data[i]);
+    std::vector<memstreambuf> encoded_stream_data;
+
+    // Create buffers for compressed data: the first will be reused for all the data later
+    encoded_stream_data.emplace_back(total_frame_size);
+    for(size_t i=1; i < streams.size(); ++i) {
+        encoded_stream_data.emplace_back(streams[i].SizeBytes());
+    }
 
-            const StreamInfo& si = streams[i];
-            const Image<unsigned char> stream_image = si.StreamImage(data);
+    // lambda encodes frame data i to encoded_stream_data[i]
+    auto encode_stream = [&](int i){
+        encoded_stream_data[i].clear();
+        std::ostream encode_stream(&encoded_stream_data[i]);
 
-            if(stream_encoders[i]) {
-                // Encode to buffer
-                stream_encoders[i](encode_stream, stream_image);
+        const StreamInfo& si = streams[i];
+        const Image<unsigned char> stream_image = si.StreamImage(data);
+
+        if(stream_encoders[i]) {
+            // Encode to buffer
+            stream_encoders[i](encode_stream, stream_image);
+        }else{
+            if(stream_image.IsContiguous()) {
+                encode_stream.write((char*)stream_image.ptr, streams[i].SizeBytes());
             }else{
-                if(stream_image.IsContiguous()) {
-                    encode_stream.write((char*)stream_image.ptr, streams[i].SizeBytes());
-                }else{
-                    for(size_t row=0; row < stream_image.h; ++row) {
-                        encode_stream.write((char*)stream_image.RowPtr(row), si.RowBytes());
-                    }
+                for(size_t row=0; row < stream_image.h; ++row) {
+                    encode_stream.write((char*)stream_image.RowPtr(row), si.RowBytes());
                 }
             }
-            return true;
-        };
-
-        // Compress each stream (>0 in another thread)
-        std::vector<std::future<bool>> encode_finished;
-        for(size_t i=1; i < streams.size(); ++i) {
-            encode_finished.emplace_back(std::async(std::launch::async, [&,i](){
-                return encode_stream(i);
-            }));
         }
-        // Encode stream 0 in this thread
-        encode_stream(0);
+        return true;
+    };
 
-        // Reuse our first compression stream for the rest of the data too.
-        std::vector<uint8_t>& encoded = encoded_stream_data[0].buffer;
+    // Compress each stream (>0 in another thread)
+    std::vector<std::future<bool>> encode_finished;
+    for(size_t i=1; i < streams.size(); ++i) {
+        encode_finished.emplace_back(std::async(std::launch::async, [&,i](){
+            return encode_stream(i);
+        }));
+    }
+    // Encode stream 0 in this thread
+    encode_stream(0);
 
-        // Wait on all threads to finish and copy into data packet
-        for(size_t i=1; i < streams.size(); ++i) {
-            encode_finished[i-1].get();
-            encoded.insert(encoded.end(), encoded_stream_data[i].buffer.begin(), encoded_stream_data[i].buffer.end());
-        }
+    // Reuse our first compression stream for the rest of the data too.
+    encoded = std::move(encoded_stream_data[0].buffer);
 
-        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties);
-    }else{
-        packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(data), host_reception_time_us, total_frame_size, frame_properties);
+    // Wait on all threads to finish and copy into data packet
+    for(size_t i=1; i < streams.size(); ++i) {
+        encode_finished[i-1].get();
+        encoded.insert(encoded.end(), encoded_stream_data[i].buffer.begin(), encoded_stream_data[i].buffer.end());
     }
+}
+
+int PangoVideoOutput::WriteEncoded(const std::vector<uint8_t>& encoded, const picojson::value& frame_properties)
+{
+    const int64_t host_reception_time_us = frame_properties.get_value(PANGO_HOST_RECEPTION_TIME_US, Time_us(TimeNow()));
+
+    if(!ReadyToWrite())
+        return 0;
 
+    packetstream.WriteSourcePacket(packetstreamsrcid, reinterpret_cast<const char*>(encoded.data()), host_reception_time_us, encoded.size(), frame_properties);
     return 0;
 }
 
@@ -278,6 +312,7 @@ PANGOLIN_REGISTER_FACTORY(PangoVideoOutput)
             return {{
                 {"buffer_size_mb","100","Buffer size in MB"},
                 {"unique_filename","","This is flag to create a unique file name in the case of file already exists."},
+                {"binary_meta","0","Write frame properties in a compact binary encoding instead of JSON. Cheaper for high-rate sources, but unreadable by older Pangolin versions."},
                 {"encoder(\\d+)?"," ","encoder or encoderN, 1 <= N <= 100. The default values of encoderN are set to encoder"}
             }};
         }
@@ -308,7 +343,7 @@ PANGOLIN_REGISTER_FACTORY(PangoVideoOutput)
             }
 
             return std::unique_ptr<VideoOutputInterface>(
-                new PangoVideoOutput(filename, buffer_size_bytes, stream_encoder_uris)
+                new PangoVideoOutput(filename, buffer_size_bytes, stream_encoder_uris, reader.Get<bool>("binary_meta"))
             );
         }
     };
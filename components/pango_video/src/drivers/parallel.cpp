@@ -0,0 +1,254 @@
+#include <pangolin/video/drivers/parallel.h>
+#include <pangolin/video/drivers/fused.h>
+#include <pangolin/video/drivers/pango.h>
+#include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
+#include <pangolin/video/iostream_operators.h>
+#include <pangolin/video/video.h>
+
+#include <cstring>
+
+namespace pangolin
+{
+
+ParallelVideo::ParallelVideo(std::unique_ptr<VideoInterface>& src_, size_t num_threads, size_t depth)
+    : src(std::move(src_)), base(nullptr), base_pango(nullptr),
+      num_threads(num_threads), depth(depth), running(false), next_seq(0)
+{
+    if(!src) {
+        throw VideoException("ParallelVideo: VideoInterface in must not be null");
+    }
+    videoin.push_back(src.get());
+
+    // Take over the filters that can process frames they're handed, down to
+    // the first video that has to be grabbed from.
+    base = src.get();
+    while(true) {
+        FrameFilterInterface* stage = dynamic_cast<FrameFilterInterface*>(base);
+        VideoFilterInterface* filter = dynamic_cast<VideoFilterInterface*>(base);
+        if(!stage || !filter || filter->InputStreams().size() != 1) break;
+
+        stages.push_back(stage);
+        stage_videos.push_back(base);
+
+        // A fused chain takes its frames from below the filters it replaces
+        FusedVideo* fused = dynamic_cast<FusedVideo*>(base);
+        base = fused ? fused->Base() : filter->InputStreams()[0];
+    }
+    base_pango = dynamic_cast<PangoVideo*>(base);
+}
+
+ParallelVideo::~ParallelVideo()
+{
+    Stop();
+}
+
+//! Implement VideoInput::Start()
+void ParallelVideo::Start()
+{
+    if(running) return;
+
+    src->Start();
+
+    free_frames.reset(new BoundedQueue<FramePtr>(depth));
+    todo.reset(new BoundedQueue<Job>(depth));
+    done.reset(new ReorderQueue<FramePtr>());
+
+    for(size_t i=0; i < depth; ++i) {
+        FramePtr frame(new Frame);
+        frame->output.resize(src->SizeBytes());
+        if(!stages.empty()) {
+            frame->input.resize(base->SizeBytes());
+            frame->intermediate.resize(stages.size());
+            for(size_t s=1; s < stages.size(); ++s) {
+                frame->intermediate[s].resize(stage_videos[s]->SizeBytes());
+            }
+        }
+        free_frames->Push(std::move(frame));
+    }
+
+    next_seq = 0;
+    running = true;
+    reader = std::thread(&ParallelVideo::Read, this);
+    for(size_t i=0; i < num_threads; ++i) {
+        workers.emplace_back(&ParallelVideo::Work, this);
+    }
+}
+
+//! Implement VideoInput::Stop()
+void ParallelVideo::Stop()
+{
+    if(running) {
+        free_frames->Close();
+        todo->Close();
+        done->Abort();
+        reader.join();
+        for(std::thread& w : workers) w.join();
+        workers.clear();
+        running = false;
+    }
+    src->Stop();
+}
+
+//! Implement VideoInput::SizeBytes()
+size_t ParallelVideo::SizeBytes() const
+{
+    return src->SizeBytes();
+}
+
+//! Implement VideoInput::Streams()
+const std::vector<StreamInfo>& ParallelVideo::Streams() const
+{
+    return src->Streams();
+}
+
+void ParallelVideo::Read()
+{
+    Tracer::Instance().SetThreadName("ParallelVideo reader");
+    try{
+        size_t seq = 0;
+        FramePtr frame;
+        while(free_frames->Pop(frame)) {
+            PANGO_TRACE_SCOPE("video", "ParallelVideo::Grab");
+            unsigned char* image = stages.empty() ? frame->output.data() : frame->input.data();
+            const bool grabbed = base_pango ?
+                base_pango->GrabPacket(frame->packet) :
+                base->GrabNext(image, true);
+            if(!grabbed) break;
+
+            frame->properties = GetVideoFrameProperties(base);
+            if(!todo->Push(Job(seq++, std::move(frame)))) break;
+        }
+        done->Finish(seq);
+        todo->Close();
+    }catch(const std::exception& e) {
+        Fail(e);
+    }
+}
+
+void ParallelVideo::Work()
+{
+    Tracer::Instance().SetThreadName("ParallelVideo worker");
+    try{
+        Job job;
+        while(todo->Pop(job)) {
+            PANGO_TRACE_SCOPE("video", "ParallelVideo::Process");
+            Frame& frame = *job.second;
+            unsigned char* in = stages.empty() ? frame.output.data() : frame.input.data();
+            if(base_pango) {
+                base_pango->DecodePacket(frame.packet, in);
+            }
+            for(size_t i = stages.size(); i-- > 0; ) {
+                unsigned char* out = (i == 0) ? frame.output.data() : frame.intermediate[i].data();
+                stages[i]->ProcessFrame(out, in, frame.properties);
+                in = out;
+            }
+            done->Put(job.first, std::move(job.second));
+        }
+    }catch(const std::exception& e) {
+        Fail(e);
+    }
+}
+
+void ParallelVideo::Fail(const std::exception& e)
+{
+    // The caller doesn't have the opportunity to catch exceptions here.
+    pango_print_warn("ParallelVideo caught exception (%s)\n", e.what());
+    free_frames->Close();
+    todo->Close();
+    done->Abort();
+}
+
+void ParallelVideo::Return(FramePtr frame, unsigned char* image)
+{
+    std::memcpy(image, frame->output.data(), frame->output.size());
+    frame_properties = std::move(frame->properties);
+    free_frames->Push(std::move(frame));
+}
+
+//! Implement VideoInput::GrabNext()
+bool ParallelVideo::GrabNext( unsigned char* image, bool wait )
+{
+    PANGO_TRACE_SCOPE("video", "ParallelVideo::GrabNext");
+    if(!running) return false;
+
+    FramePtr frame;
+    if(!done->Get(next_seq, frame, wait)) return false;
+    ++next_seq;
+
+    Return(std::move(frame), image);
+    return true;
+}
+
+//! Implement VideoInput::GrabNewest()
+bool ParallelVideo::GrabNewest( unsigned char* image, bool wait )
+{
+    PANGO_TRACE_SCOPE("video", "ParallelVideo::GrabNewest");
+    if(!running) return false;
+
+    FramePtr frame;
+    if(!done->Get(next_seq, frame, wait)) return false;
+    ++next_seq;
+
+    // Skip over any later frames that are already finished
+    FramePtr newer;
+    while(done->Get(next_seq, newer, false)) {
+        ++next_seq;
+        free_frames->Push(std::move(frame));
+        frame = std::move(newer);
+    }
+
+    Return(std::move(frame), image);
+    return true;
+}
+
+std::vector<VideoInterface*>& ParallelVideo::InputStreams()
+{
+    return videoin;
+}
+
+const picojson::value& ParallelVideo::DeviceProperties() const
+{
+    device_properties = GetVideoDeviceProperties(videoin[0]);
+    return device_properties;
+}
+
+const picojson::value& ParallelVideo::FrameProperties() const
+{
+    return frame_properties;
+}
+
+PANGOLIN_REGISTER_FACTORY(ParallelVideo)
+{
+    struct ParallelVideoFactory final : public TypedFactoryInterface<VideoInterface> {
+        std::map<std::string,Precedence> Schemes() const override
+        {
+            return {{"parallel",10}};
+        }
+        const char* Description() const override
+        {
+            return "Video Filter: processes several frames of the sub-video's filters at once, returning them in order.";
+        }
+        ParamSet Params() const override
+        {
+            return {{
+                {"threads","0","Number of worker threads. 0 for one per core."},
+                {"depth","0","Maximum number of frames in flight. 0 for twice the number of threads."}
+            }};
+        }
+        std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
+            ParamReader reader(Params(), uri);
+            size_t threads = reader.Get<size_t>("threads");
+            if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            size_t depth = reader.Get<size_t>("depth");
+            if(depth == 0) depth = 2 * threads;
+
+            std::unique_ptr<VideoInterface> subvid = pangolin::OpenVideo(uri.url);
+            return std::unique_ptr<VideoInterface>(new ParallelVideo(subvid, threads, depth));
+        }
+    };
+
+    return FactoryRegistry::I()->RegisterFactory<VideoInterface>(std::make_shared<ParallelVideoFactory>());
+}
+
+}
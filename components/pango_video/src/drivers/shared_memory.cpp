@@ -2,28 +2,131 @@
 #include <pangolin/video/drivers/shared_memory.h>
 #include <pangolin/video/iostream_operators.h>
 
+#include <cstring>
+#include <thread>
+
 using namespace std;
 
 namespace pangolin
 {
 
+SharedMemoryVideo::Lease::Lease()
+    : slot(nullptr), seq(0), data(nullptr)
+{
+}
+
+SharedMemoryVideo::Lease::Lease(Lease&& o)
+    : slot(nullptr), seq(0), data(nullptr)
+{
+    *this = std::move(o);
+}
+
+SharedMemoryVideo::Lease& SharedMemoryVideo::Lease::operator=(Lease&& o)
+{
+    if(this != &o) {
+        Release();
+        slot = o.slot;
+        seq = o.seq;
+        data = o.data;
+        frame_properties = std::move(o.frame_properties);
+        o.slot = nullptr;
+        o.data = nullptr;
+    }
+    return *this;
+}
+
+SharedMemoryVideo::Lease::~Lease()
+{
+    Release();
+}
+
+bool SharedMemoryVideo::Lease::Valid() const
+{
+    // Order the caller's reads of Data() before re-checking the sequence
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot && slot->seq.load(std::memory_order_relaxed) == seq;
+}
+
+void SharedMemoryVideo::Lease::Release()
+{
+    if(slot) {
+        slot->leases.fetch_sub(1);
+        slot = nullptr;
+        data = nullptr;
+    }
+}
+
 SharedMemoryVideo::SharedMemoryVideo(size_t w, size_t h, std::string pix_fmt,
     const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory,
     const std::shared_ptr<ConditionVariableInterface>& buffer_full) :
     _fmt(PixelFormatFromString(pix_fmt)),
     _frame_size(w*h*_fmt.bpp/8),
     _shared_memory(shared_memory),
-    _buffer_full(buffer_full)
+    _buffer_full(buffer_full),
+    _ring(nullptr),
+    _next_frame(0),
+    _frames_dropped(0)
 {
     const size_t pitch = w * _fmt.bpp/8;
     const StreamInfo stream(_fmt, w, h, pitch, 0);
     _streams.push_back(stream);
 }
 
+SharedMemoryVideo::SharedMemoryVideo(
+    const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory,
+    const std::shared_ptr<ConditionVariableInterface>& buffer_full) :
+    _frame_size(0),
+    _shared_memory(shared_memory),
+    _buffer_full(buffer_full),
+    _ring(reinterpret_cast<SharedMemoryRingHeader*>(shared_memory->ptr())),
+    _next_frame(0),
+    _frames_dropped(0)
+{
+    if( !IsRing(shared_memory) || _ring->num_slots == 0 ||
+        _shared_memory->size() < _ring->slots_offset + _ring->num_slots * _ring->slot_stride ||
+        _shared_memory->size() < _ring->info_offset + _ring->info_bytes )
+    {
+        throw VideoException("SharedMemoryVideo: invalid shared memory ring");
+    }
+
+    picojson::value info;
+    const char* info_begin = reinterpret_cast<const char*>(_shared_memory->ptr() + _ring->info_offset);
+    std::string err;
+    picojson::parse(info, info_begin, info_begin + _ring->info_bytes, &err);
+    if(!err.empty() || !info.contains("streams")) {
+        throw VideoException("SharedMemoryVideo: unable to parse stream description", err);
+    }
+
+    _frame_size = _ring->frame_bytes;
+    _device_properties = info["device"];
+
+    for(const picojson::value& json_stream : info["streams"].get<picojson::array>()) {
+        PixelFormat fmt = PixelFormatFromString(json_stream["encoding"].get<std::string>());
+        fmt.channel_bit_depth = json_stream.get_value<int64_t>("channel_bit_depth", 0);
+        _streams.emplace_back(
+            fmt,
+            json_stream["width"].get<int64_t>(),
+            json_stream["height"].get<int64_t>(),
+            json_stream["pitch"].get<int64_t>(),
+            reinterpret_cast<unsigned char*>(json_stream["offset"].get<int64_t>())
+        );
+    }
+
+    // Start from the most recent frame published
+    const uint64_t written = _ring->frames_written.load(std::memory_order_acquire);
+    _next_frame = written ? written - 1 : 0;
+}
+
 SharedMemoryVideo::~SharedMemoryVideo()
 {
 }
 
+bool SharedMemoryVideo::IsRing(const std::shared_ptr<SharedMemoryBufferInterface>& shared_memory)
+{
+    return shared_memory && shared_memory->size() >= sizeof(SharedMemoryRingHeader) &&
+        reinterpret_cast<SharedMemoryRingHeader*>(shared_memory->ptr())->magic.load(std::memory_order_acquire) == SharedMemoryRingHeader::Magic;
+}
+
 void SharedMemoryVideo::Start()
 {
 }
@@ -42,7 +145,37 @@ const std::vector<StreamInfo>& SharedMemoryVideo::Streams() const
     return _streams;
 }
 
+const picojson::value& SharedMemoryVideo::DeviceProperties() const
+{
+    return _device_properties;
+}
+
+const picojson::value& SharedMemoryVideo::FrameProperties() const
+{
+    return _frame_properties;
+}
+
 bool SharedMemoryVideo::GrabNext(unsigned char* image, bool wait)
+{
+    return _ring ? GrabRing(image, wait, false) : GrabLegacy(image, wait);
+}
+
+bool SharedMemoryVideo::GrabNewest(unsigned char* image, bool wait)
+{
+    return _ring ? GrabRing(image, wait, true) : GrabLegacy(image, wait);
+}
+
+bool SharedMemoryVideo::GrabNextLease(Lease& lease, bool wait)
+{
+    return AcquireLease(lease, wait, false);
+}
+
+bool SharedMemoryVideo::GrabNewestLease(Lease& lease, bool wait)
+{
+    return AcquireLease(lease, wait, true);
+}
+
+bool SharedMemoryVideo::GrabLegacy(unsigned char* image, bool wait)
 {
     // If a condition variable exists, try waiting on it.
     if(_buffer_full) {
@@ -64,9 +197,140 @@ bool SharedMemoryVideo::GrabNext(unsigned char* image, bool wait)
     return true;
 }
 
-bool SharedMemoryVideo::GrabNewest(unsigned char* image, bool wait)
+const unsigned char* SharedMemoryVideo::SlotData(const SharedMemoryRingSlot* slot) const
 {
-    return GrabNext(image,wait);
+    return reinterpret_cast<const unsigned char*>(slot) + SharedMemoryRingSlotHeaderBytes;
+}
+
+const char* SharedMemoryVideo::SlotProps(const SharedMemoryRingSlot* slot) const
+{
+    return reinterpret_cast<const char*>(SlotData(slot) + _ring->frame_bytes);
+}
+
+SharedMemoryRingSlot* SharedMemoryVideo::FindFrame(bool newest, uint64_t& seq) const
+{
+    SharedMemoryRingSlot* best = nullptr;
+
+    for(size_t i=0; i < _ring->num_slots; ++i) {
+        SharedMemoryRingSlot* slot = reinterpret_cast<SharedMemoryRingSlot*>(
+            _shared_memory->ptr() + _ring->slots_offset + i * _ring->slot_stride
+        );
+        const uint64_t s = slot->seq.load(std::memory_order_acquire);
+        if(s == 0 || (s & 1) || s/2 - 1 < _next_frame) continue;
+        if(!best || (newest ? s > seq : s < seq)) {
+            best = slot;
+            seq = s;
+        }
+    }
+
+    return best;
+}
+
+bool SharedMemoryVideo::WaitForFrame(bool wait) const
+{
+    while(_ring->frames_written.load(std::memory_order_acquire) <= _next_frame) {
+        if(!wait) return false;
+
+        // The writer doesn't hold the condition's mutex when publishing, so
+        // bound the wait in case we miss its broadcast.
+        if(_buffer_full) {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 10000000;
+            if(ts.tv_nsec >= 1000000000) {
+                ts.tv_sec += 1;
+                ts.tv_nsec -= 1000000000;
+            }
+            _buffer_full->wait(ts);
+        }else{
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+void SharedMemoryVideo::MarkSeen(uint64_t seq)
+{
+    const uint64_t frame = seq/2 - 1;
+    _frames_dropped += frame - _next_frame;
+    _next_frame = frame + 1;
+}
+
+bool SharedMemoryVideo::GrabRing(unsigned char* image, bool wait, bool newest)
+{
+    std::string props;
+
+    while(WaitForFrame(wait)) {
+        uint64_t seq;
+        const SharedMemoryRingSlot* slot = FindFrame(newest, seq);
+        if(!slot) {
+            // Writer lapped us whilst we searched
+            std::this_thread::yield();
+            continue;
+        }
+
+        memcpy(image, SlotData(slot), _frame_size);
+        props.assign(SlotProps(slot), std::min<uint64_t>(slot->props_bytes, _ring->props_capacity));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot->seq.load(std::memory_order_relaxed) != seq) {
+            // Torn by the writer, try again
+            continue;
+        }
+
+        _frame_properties = picojson::value();
+        if(!props.empty()) picojson::parse(_frame_properties, props);
+        MarkSeen(seq);
+        return true;
+    }
+
+    return false;
+}
+
+bool SharedMemoryVideo::AcquireLease(Lease& lease, bool wait, bool newest)
+{
+    if(!_ring) {
+        throw VideoException("SharedMemoryVideo: leases are only supported for shmem:// output rings");
+    }
+
+    lease.Release();
+    std::string props;
+
+    while(WaitForFrame(wait)) {
+        uint64_t seq;
+        SharedMemoryRingSlot* slot = FindFrame(newest, seq);
+        if(!slot) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // The writer checks leases after marking a slot, and we check the
+        // mark after taking a lease, so at least one of us will back off.
+        slot->leases.fetch_add(1);
+        if(slot->seq.load() != seq) {
+            slot->leases.fetch_sub(1);
+            continue;
+        }
+
+        lease.slot = slot;
+        lease.seq = seq;
+        lease.data = SlotData(slot);
+
+        props.assign(SlotProps(slot), std::min<uint64_t>(slot->props_bytes, _ring->props_capacity));
+        if(!lease.Valid()) {
+            // Every slot was leased and the writer reclaimed this one anyway
+            lease.Release();
+            continue;
+        }
+
+        _frame_properties = picojson::value();
+        if(!props.empty()) picojson::parse(_frame_properties, props);
+        lease.frame_properties = _frame_properties;
+        MarkSeen(seq);
+        return true;
+    }
+
+    return false;
 }
 
 PANGOLIN_REGISTER_FACTORY(SharedMemoryVideo)
@@ -83,18 +347,15 @@ PANGOLIN_REGISTER_FACTORY(SharedMemoryVideo)
         ParamSet Params() const override
         {
             return {{
-                {"fmt","RGB24","Pixel format: see pixel format help for all possible values"},
-                {"size","640x480","Image dimension"}
+                {"fmt","RGB24","Pixel format: see pixel format help for all possible values. Ignored for shmem:// output rings."},
+                {"size","640x480","Image dimension. Ignored for shmem:// output rings."}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
-            const ImageDim dim = uri.Get<ImageDim>("size", ImageDim(0, 0));
-            const std::string sfmt = uri.Get<std::string>("fmt", "GRAY8");
-            const PixelFormat fmt = PixelFormatFromString(sfmt);
             const std::string shmem_name = std::string("/") + uri.url;
             std::shared_ptr<SharedMemoryBufferInterface> shmem_buffer =
                 open_named_shared_memory_buffer(shmem_name, true);
-            if (dim.x == 0 || dim.y == 0 || !shmem_buffer) {
+            if (!shmem_buffer) {
                 throw VideoException("invalid shared memory parameters");
             }
 
@@ -102,6 +363,19 @@ PANGOLIN_REGISTER_FACTORY(SharedMemoryVideo)
             std::shared_ptr<ConditionVariableInterface> buffer_full =
                 open_named_condition_variable(cond_name);
 
+            if(SharedMemoryVideo::IsRing(shmem_buffer)) {
+                return std::unique_ptr<VideoInterface>(
+                    new SharedMemoryVideo(shmem_buffer, buffer_full)
+                );
+            }
+
+            const ImageDim dim = uri.Get<ImageDim>("size", ImageDim(0, 0));
+            const std::string sfmt = uri.Get<std::string>("fmt", "GRAY8");
+            const PixelFormat fmt = PixelFormatFromString(sfmt);
+            if (dim.x == 0 || dim.y == 0) {
+                throw VideoException("invalid shared memory parameters");
+            }
+
             return std::unique_ptr<VideoInterface>(
                 new SharedMemoryVideo(dim.x, dim.y, fmt, shmem_buffer,buffer_full)
             );
@@ -0,0 +1,207 @@
+#include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/log.h>
+#include <pangolin/video/drivers/shared_memory_output.h>
+#include <pangolin/video/video_exception.h>
+
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace pangolin
+{
+
+SharedMemoryVideoOutput::SharedMemoryVideoOutput(const std::string& name, size_t num_slots, size_t props_capacity)
+    : name(name),
+      num_slots(std::max<size_t>(1, num_slots)),
+      props_capacity(props_capacity),
+      ring(nullptr),
+      last_slot(0),
+      frames_written(0)
+{
+}
+
+SharedMemoryVideoOutput::~SharedMemoryVideoOutput()
+{
+}
+
+const std::vector<StreamInfo>& SharedMemoryVideoOutput::Streams() const
+{
+    return streams;
+}
+
+bool SharedMemoryVideoOutput::IsPipe() const
+{
+    return false;
+}
+
+void SharedMemoryVideoOutput::SetStreams(const std::vector<StreamInfo>& st, const std::string& uri, const picojson::value& properties)
+{
+    if(ring) {
+        throw std::runtime_error("Unable to add new streams");
+    }
+
+    streams = st;
+
+    picojson::value info(picojson::object_type, false);
+    picojson::value& json_streams = info["streams"];
+    info["uri"] = uri;
+    info["device"] = properties;
+
+    size_t frame_bytes = 0;
+    for(const StreamInfo& si : streams) {
+        frame_bytes = std::max(frame_bytes, (size_t)si.Offset() + si.SizeBytes());
+
+        picojson::value& json_stream = json_streams.push_back();
+        json_stream["channel_bit_depth"] = si.PixFormat().channel_bit_depth;
+        json_stream["encoding"] = si.PixFormat().format;
+        json_stream["width"] = si.Width();
+        json_stream["height"] = si.Height();
+        json_stream["pitch"] = si.Pitch();
+        json_stream["offset"] = (size_t)si.Offset();
+    }
+    const std::string info_json = info.serialize();
+
+    const size_t info_offset = SharedMemoryRingAligned(sizeof(SharedMemoryRingHeader));
+    const size_t slots_offset = info_offset + SharedMemoryRingAligned(info_json.size());
+    const size_t slot_stride = SharedMemoryRingAligned(SharedMemoryRingSlotHeaderBytes + frame_bytes + props_capacity);
+    const size_t total_bytes = slots_offset + num_slots * slot_stride;
+
+    // Don't reuse a stale segment left by a writer which didn't exit cleanly,
+    // since readers may still have it mapped at its old size.
+    const std::string shmem_name = "/" + name;
+    shm_unlink(shmem_name.c_str());
+    shm_unlink((shmem_name + "_cond").c_str());
+
+    shared_memory = create_named_shared_memory_buffer(shmem_name, total_bytes);
+    if(!shared_memory) {
+        throw VideoException("SharedMemoryVideoOutput: unable to create shared memory '" + shmem_name + "'");
+    }
+    buffer_full = create_named_condition_variable(shmem_name + "_cond");
+
+    unsigned char* base = shared_memory->ptr();
+    SharedMemoryRingHeader* header = new (base) SharedMemoryRingHeader;
+    header->magic.store(0);
+    header->num_slots = num_slots;
+    header->slot_stride = slot_stride;
+    header->slots_offset = slots_offset;
+    header->frame_bytes = frame_bytes;
+    header->props_capacity = props_capacity;
+    header->info_offset = info_offset;
+    header->info_bytes = info_json.size();
+    header->frames_written.store(0);
+    std::memcpy(base + info_offset, info_json.data(), info_json.size());
+
+    for(size_t i=0; i < num_slots; ++i) {
+        SharedMemoryRingSlot* slot = new (base + slots_offset + i * slot_stride) SharedMemoryRingSlot;
+        slot->seq.store(0);
+        slot->leases.store(0);
+        slot->props_bytes = 0;
+    }
+
+    // Readers ignore the segment until this is set
+    header->magic.store(SharedMemoryRingHeader::Magic, std::memory_order_release);
+    ring = header;
+    last_slot = num_slots - 1;
+}
+
+SharedMemoryRingSlot* SharedMemoryVideoOutput::Slot(size_t i)
+{
+    return reinterpret_cast<SharedMemoryRingSlot*>(shared_memory->ptr() + ring->slots_offset + i * ring->slot_stride);
+}
+
+SharedMemoryRingSlot* SharedMemoryVideoOutput::ClaimSlot(uint64_t odd_seq)
+{
+    for(size_t i=1; i <= num_slots; ++i) {
+        const size_t s = (last_slot + i) % num_slots;
+        SharedMemoryRingSlot* slot = Slot(s);
+        if(slot->leases.load() != 0) continue;
+
+        // A reader may have leased the slot since we looked; it checks seq
+        // after taking its lease, so re-check leases after marking.
+        const uint64_t prev_seq = slot->seq.exchange(odd_seq);
+        if(slot->leases.load() != 0) {
+            slot->seq.store(prev_seq);
+            continue;
+        }
+
+        last_slot = s;
+        return slot;
+    }
+
+    // Every slot is leased. Rather than stall, take the oldest, which
+    // invalidates its leases.
+    size_t oldest = 0;
+    for(size_t s=1; s < num_slots; ++s) {
+        if(Slot(s)->seq.load() < Slot(oldest)->seq.load()) oldest = s;
+    }
+    SharedMemoryRingSlot* slot = Slot(oldest);
+    slot->seq.store(odd_seq);
+    last_slot = oldest;
+    return slot;
+}
+
+int SharedMemoryVideoOutput::WriteStreams(const unsigned char* data, const picojson::value& frame_properties)
+{
+    if(!ring) {
+        throw std::runtime_error("SharedMemoryVideoOutput: SetStreams must be called before WriteStreams");
+    }
+
+    std::string props;
+    if(!frame_properties.is<picojson::null>()) {
+        props = frame_properties.serialize();
+        if(props.size() > props_capacity) {
+            pango_print_warn("SharedMemoryVideoOutput: frame properties (%zu bytes) exceed props_size. Dropping them.\n", props.size());
+            props.clear();
+        }
+    }
+
+    const uint64_t n = frames_written;
+    SharedMemoryRingSlot* slot = ClaimSlot(2*n + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    unsigned char* slot_data = reinterpret_cast<unsigned char*>(slot) + SharedMemoryRingSlotHeaderBytes;
+    std::memcpy(slot_data, data, ring->frame_bytes);
+    std::memcpy(slot_data + ring->frame_bytes, props.data(), props.size());
+    slot->props_bytes = (uint32_t)props.size();
+
+    slot->seq.store(2*n + 2, std::memory_order_release);
+    ring->frames_written.store(++frames_written, std::memory_order_release);
+
+    if(buffer_full) {
+        buffer_full->broadcast();
+    }
+
+    return 0;
+}
+
+PANGOLIN_REGISTER_FACTORY(SharedMemoryVideoOutput)
+{
+    struct SharedMemoryVideoOutputFactory final : public TypedFactoryInterface<VideoOutputInterface> {
+        std::map<std::string,Precedence> Schemes() const override
+        {
+            return {{"shmem",10}};
+        }
+        const char* Description() const override
+        {
+            return "Publish to a posix shared memory ring, readable by any number of local shmem:// inputs.";
+        }
+        ParamSet Params() const override
+        {
+            return {{
+                {"slots","4","Number of frames held in the ring"},
+                {"props_size","4096","Maximum size in bytes of each frame's serialized properties"}
+            }};
+        }
+        std::unique_ptr<VideoOutputInterface> Open(const Uri& uri) override {
+            ParamReader reader(Params(), uri);
+            return std::unique_ptr<VideoOutputInterface>(
+                new SharedMemoryVideoOutput(uri.url, reader.Get<size_t>("slots"), reader.Get<size_t>("props_size"))
+            );
+        }
+    };
+
+    return FactoryRegistry::I()->RegisterFactory<VideoOutputInterface>(std::make_shared<SharedMemoryVideoOutputFactory>());
+}
+
+}
@@ -27,6 +27,7 @@
 
 #include <pangolin/video/drivers/shift.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
@@ -145,34 +146,45 @@ void DoShift16to8(
     }
 }
 
-void ShiftVideo::Process(uint8_t* buffer_out, const uint8_t* buffer_in)
+void ShiftVideo::ProcessRows(size_t s, Image<uint8_t>& img_out, const Image<uint8_t>& img_in)
 {
-    for(size_t s=0; s<streams.size(); ++s) {
-        const Image<uint8_t> img_in  = videoin[0]->Streams()[s].StreamImage(buffer_in);
-        Image<uint8_t> img_out = Streams()[s].StreamImage(buffer_out);
-        const size_t bytes_per_pixel = Streams()[s].PixFormat().bpp / 8;
+    const size_t bytes_per_pixel = Streams()[s].PixFormat().bpp / 8;
 
-        auto i = shift_right_bits.find(s);
+    auto i = shift_right_bits.find(s);
 
-        if(i != shift_right_bits.end() && i->second != 0)
-        {
-            auto m = masks.find(s);
-            DoShift16to8(img_out, img_in, i->second, (m == masks.end() ? 0xffff : m->second), std::pow(2, videoin[0]->Streams()[s].PixFormat().channel_bit_depth) - 1);
+    if(i != shift_right_bits.end() && i->second != 0)
+    {
+        auto m = masks.find(s);
+        DoShift16to8(img_out, img_in, i->second, (m == masks.end() ? 0xffff : m->second), std::pow(2, videoin[0]->Streams()[s].PixFormat().channel_bit_depth) - 1);
+    }
+    else
+    {
+        //straight copy
+        if( img_out.w != img_in.w || img_out.h != img_in.h ) {
+            throw std::runtime_error("ShiftVideo: Incompatible image sizes");
         }
-        else
-        {
-            //straight copy
-            if( img_out.w != img_in.w || img_out.h != img_in.h ) {
-                throw std::runtime_error("ShiftVideo: Incompatible image sizes");
-            }
 
-            for(size_t y=0; y < img_out.h; ++y) {
-                std::memcpy(img_out.RowPtr((int)y), img_in.RowPtr((int)y), bytes_per_pixel * img_in.w);
-            }
+        for(size_t y=0; y < img_out.h; ++y) {
+            std::memcpy(img_out.RowPtr((int)y), img_in.RowPtr((int)y), bytes_per_pixel * img_in.w);
         }
     }
 }
 
+void ShiftVideo::Process(uint8_t* buffer_out, const uint8_t* buffer_in)
+{
+    PANGO_TRACE_SCOPE("video", "ShiftVideo::Process");
+    for(size_t s=0; s<streams.size(); ++s) {
+        const Image<uint8_t> img_in  = videoin[0]->Streams()[s].StreamImage(buffer_in);
+        Image<uint8_t> img_out = Streams()[s].StreamImage(buffer_out);
+        ProcessRows(s, img_out, img_in);
+    }
+}
+
+void ShiftVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    Process(out, in);
+}
+
 //! Implement VideoInput::GrabNext()
 bool ShiftVideo::GrabNext( uint8_t* image, bool wait )
 {
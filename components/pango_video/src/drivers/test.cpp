@@ -28,28 +28,168 @@
 #include <pangolin/video/drivers/test.h>
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/video/iostream_operators.h>
+#include <pangolin/utils/timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
 
 namespace pangolin
 {
 
-void setRandomData(unsigned char * arr, size_t size){
-  for(size_t i = 0 ; i < size;i++) {
-//      arr[i] = (unsigned char)(i * 255.0 / size);
-      arr[i] = (unsigned char)(rand()/(RAND_MAX/255.0));
-  }
+namespace
+{
+
+// Fast, seedable hash used for the noise and frame jitter
+inline uint64_t SplitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
 }
 
-TestVideo::TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt)
+// SplitMix64 sequence keyed on (seed, frame, stream, row), so that no two
+// rows of the video share their noise.
+class RowRandom
 {
-    const PixelFormat pfmt = PixelFormatFromString(pix_fmt);
+public:
+    RowRandom(uint64_t seed, uint64_t frame, uint64_t stream, uint64_t y)
+        : state(SplitMix64(SplitMix64(SplitMix64(SplitMix64(seed) ^ frame) ^ stream) ^ y))
+    {
+    }
 
-    size_bytes = 0;
+    uint64_t Next()
+    {
+        state += 0x9E3779B97F4A7C15ull;
+        return SplitMix64(state);
+    }
+
+    // Uniform in [0, range), for range < 2^32
+    uint32_t Below(uint32_t range)
+    {
+        return uint32_t(((Next() >> 32) * range) >> 32);
+    }
+
+private:
+    uint64_t state;
+};
+
+void FillRandom(unsigned char* row, size_t bytes, RowRandom& random)
+{
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+        const uint64_t r = random.Next();
+        std::memcpy(row + i, &r, sizeof(r));
+    }
+    if(i < bytes) {
+        const uint64_t r = random.Next();
+        std::memcpy(row + i, &r, bytes - i);
+    }
+}
+
+// Gradient period in pixels (a power of two) and movement per frame
+const size_t GradientPeriod = 256;
+const size_t GradientSpeed = 4;
+
+template<typename T>
+void StoreLevels(unsigned char* row, const uint32_t* levels, size_t n)
+{
+    T* out = reinterpret_cast<T*>(row);
+    for(size_t i=0; i < n; ++i) {
+        out[i] = T(levels[i]);
+    }
+}
+
+void StoreLevelsF32(unsigned char* row, const uint32_t* levels, size_t n, uint32_t max_level)
+{
+    float* out = reinterpret_cast<float*>(row);
+    const float scale = 1.0f / max_level;
+    for(size_t i=0; i < n; ++i) {
+        out[i] = levels[i] * scale;
+    }
+}
+
+// Pack levels of bits each, least significant first, as the pack driver does
+void PackLevels(unsigned char* out, const uint32_t* levels, size_t n, int bits)
+{
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for(size_t i=0; i < n; ++i) {
+        acc |= uint64_t(levels[i]) << acc_bits;
+        acc_bits += bits;
+        while(acc_bits >= 8) {
+            *(out++) = uint8_t(acc);
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    if(acc_bits > 0) {
+        *out = uint8_t(acc);
+    }
+}
+
+}
+
+TestVideo::TestVideo(size_t w, size_t h, size_t n, std::string pix_fmt,
+                     Pattern pattern, float noise, uint64_t seed,
+                     double fps, double jitter, size_t num_frames)
+    : size_bytes(0), pattern(pattern), seed(seed),
+      period_us(fps > 0.0 ? int64_t(1e6 / fps) : 0), num_frames(num_frames),
+      frame(0), start_us(TimeNow_us()), last_capture_us(0), noise_amplitude(0)
+{
+    const PixelFormat pfmt = PixelFormatFromString(pix_fmt);
 
     for(size_t c=0; c < n; ++c) {
-        const StreamInfo stream_info(pfmt, w, h, (w*pfmt.bpp)/8, 0);
-        streams.push_back(stream_info);
-        size_bytes += w*h*(pfmt.bpp)/8;
+        const size_t pitch = (w*pfmt.bpp + 7) / 8;
+        streams.emplace_back(pfmt, w, h, pitch, (unsigned char*)0 + size_bytes);
+        size_bytes += pitch*h;
+    }
+
+    const bool is_float = !pfmt.format.empty() && pfmt.format.back() == 'F';
+    if(!is_float && pfmt.channel_bit_depth == 8 && pfmt.bpp == 8*pfmt.channels) {
+        sample_type = SampleType::U8;
+        max_level = 0xff;
+    }else if(!is_float && pfmt.channel_bit_depth == 16 && pfmt.bpp == 16*pfmt.channels) {
+        sample_type = SampleType::U16;
+        max_level = 0xffff;
+    }else if(pfmt.channels == 1 && (pfmt.bpp == 10 || pfmt.bpp == 12)) {
+        sample_type = SampleType::Packed;
+        max_level = (1u << pfmt.bpp) - 1;
+    }else if(is_float && pfmt.channel_bit_depth == 32) {
+        sample_type = SampleType::F32;
+        max_level = 0xffff;
+    }else{
+        sample_type = SampleType::Other;
+        max_level = 0xff;
+    }
+
+    if(pattern != Pattern::Noise && sample_type == SampleType::Other) {
+        throw VideoException("TestVideo: Only the noise pattern supports format " + pfmt.format);
+    }
+    if(pattern == Pattern::Bayer && pfmt.channels != 1) {
+        throw VideoException("TestVideo: The bayer pattern needs a single channel format");
+    }
+
+    // Keep capture times monotonic
+    jitter_us = std::min<int64_t>(int64_t(jitter), period_us);
+
+    const size_t row_samples = w * pfmt.channels;
+    if(pattern != Pattern::Noise) {
+        levels.resize(row_samples);
+        gradient_lut.resize(GradientPeriod);
+        for(size_t i=0; i < GradientPeriod; ++i) {
+            gradient_lut[i] = uint32_t(uint64_t(i) * max_level / (GradientPeriod - 1));
+        }
+        noise_amplitude = uint32_t(std::lround(std::min(std::max(noise, 0.0f), 1.0f) * max_level));
     }
+
+    static const char* pattern_names[] = {"noise", "gradient", "bayer", "depth"};
+    device_properties["pattern"] = std::string(pattern_names[int(pattern)]);
+    device_properties["noise"] = double(noise);
+    device_properties["seed"] = int64_t(seed);
+    device_properties["fps"] = fps;
 }
 
 TestVideo::~TestVideo()
@@ -60,7 +200,7 @@ TestVideo::~TestVideo()
 //! Implement VideoInput::Start()
 void TestVideo::Start()
 {
-
+    start_us = TimeNow_us() - int64_t(frame) * period_us;
 }
 
 //! Implement VideoInput::Stop()
@@ -81,19 +221,154 @@ const std::vector<StreamInfo>& TestVideo::Streams() const
     return streams;
 }
 
+void TestVideo::PatternRow(uint32_t* levels, size_t stream, size_t y) const
+{
+    const StreamInfo& si = streams[stream];
+    const size_t w = si.Width();
+    const size_t channels = si.PixFormat().channels;
+    const size_t mask = GradientPeriod - 1;
+    const size_t shift = frame * GradientSpeed + stream * 17;
+
+    switch(pattern) {
+    case Pattern::Gradient:
+        for(size_t x=0; x < w; ++x) {
+            for(size_t c=0; c < channels; ++c) {
+                levels[x*channels + c] = gradient_lut[(x + y + shift + c*85) & mask];
+            }
+        }
+        break;
+    case Pattern::Bayer: {
+        // RGGB: red and green on even rows, green and blue on odd rows, each
+        // 2x2 cell sampling the same point of the gradient.
+        const size_t row_channel = y & 1;
+        for(size_t x=0; x < w; ++x) {
+            const size_t c = row_channel + (x & 1);
+            levels[x] = gradient_lut[(x/2 + y/2 + shift + c*85) & mask];
+        }
+        break;
+    }
+    case Pattern::Depth: {
+        const float t = frame * 0.05f + stream;
+        const float cx = w * (0.5f + 0.3f * std::sin(t));
+        const float cy = si.Height() * 0.5f;
+        const float r2 = std::pow(0.25f * std::min(w, si.Height()), 2.0f);
+        const float plane = 0.3f + 0.5f * y / si.Height();
+        const float dy2 = (y - cy) * (y - cy);
+        for(size_t x=0; x < w; ++x) {
+            const float d2 = (x - cx) * (x - cx) + dy2;
+            const float z = d2 < r2 ? plane - 0.2f * std::sqrt(1.0f - d2 / r2) : plane;
+            const uint32_t level = uint32_t(z * max_level);
+            for(size_t c=0; c < channels; ++c) {
+                levels[x*channels + c] = level;
+            }
+        }
+        break;
+    }
+    case Pattern::Noise:
+        break;
+    }
+}
+
+void TestVideo::Generate(unsigned char* image)
+{
+    for(size_t s=0; s < streams.size(); ++s) {
+        const StreamInfo& si = streams[s];
+        Image<unsigned char> img = si.StreamImage(image);
+        const size_t n = levels.size();
+
+        for(size_t y=0; y < img.h; ++y) {
+            unsigned char* row = img.RowPtr(y);
+            RowRandom random(seed, frame, s, y);
+
+            if(pattern == Pattern::Noise) {
+                FillRandom(row, si.RowBytes(), random);
+                continue;
+            }
+
+            PatternRow(levels.data(), s, y);
+            if(noise_amplitude > 0) {
+                const uint32_t range = 2 * noise_amplitude + 1;
+                for(size_t i=0; i < n; ++i) {
+                    const int64_t v = int64_t(levels[i]) + random.Below(range) - noise_amplitude;
+                    levels[i] = uint32_t(std::min<int64_t>(std::max<int64_t>(v, 0), max_level));
+                }
+            }
+
+            switch(sample_type) {
+            case SampleType::U8: StoreLevels<uint8_t>(row, levels.data(), n); break;
+            case SampleType::U16: StoreLevels<uint16_t>(row, levels.data(), n); break;
+            case SampleType::Packed: PackLevels(row, levels.data(), n, si.PixFormat().bpp); break;
+            case SampleType::F32: StoreLevelsF32(row, levels.data(), n, max_level); break;
+            case SampleType::Other: break;
+            }
+        }
+    }
+}
+
 //! Implement VideoInput::GrabNext()
-bool TestVideo::GrabNext( unsigned char* image, bool /*wait*/ )
+bool TestVideo::GrabNext( unsigned char* image, bool wait )
 {
-    setRandomData(image, size_bytes);
+    if(num_frames > 0 && frame >= num_frames) {
+        return false;
+    }
+
+    int64_t capture_us;
+    if(period_us > 0) {
+        const int64_t jitter = jitter_us > 0 ? int64_t(SplitMix64(seed ^ frame) % uint64_t(jitter_us + 1)) : 0;
+        capture_us = start_us + int64_t(frame) * period_us + jitter;
+        const int64_t now = TimeNow_us();
+        if(now < capture_us) {
+            if(!wait) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(capture_us - now));
+        }
+    }else{
+        capture_us = TimeNow_us();
+    }
+    capture_us = std::max(capture_us, last_capture_us + 1);
+    last_capture_us = capture_us;
+
+    Generate(image);
+
+    frame_properties = picojson::value();
+    frame_properties[PANGO_CAPTURE_TIME_US] = capture_us;
+    frame_properties[PANGO_HOST_RECEPTION_TIME_US] = TimeNow_us();
+    frame_properties[PANGO_FRAME_COUNTER] = int64_t(frame);
+    ++frame;
     return true;
 }
 
 //! Implement VideoInput::GrabNewest()
 bool TestVideo::GrabNewest( unsigned char* image, bool wait )
 {
+    // Skip any frames that are already due
+    if(period_us > 0) {
+        const int64_t elapsed_us = TimeNow_us() - start_us;
+        if(elapsed_us > 0) {
+            frame = std::max(frame, size_t(elapsed_us / period_us));
+        }
+    }
     return GrabNext(image,wait);
 }
 
+const picojson::value& TestVideo::DeviceProperties() const
+{
+    return device_properties;
+}
+
+const picojson::value& TestVideo::FrameProperties() const
+{
+    return frame_properties;
+}
+
+TestVideo::Pattern TestVideo::PatternFromString(const std::string& str)
+{
+    if(str == "noise") return Pattern::Noise;
+    else if(str == "gradient") return Pattern::Gradient;
+    else if(str == "bayer") return Pattern::Bayer;
+    else if(str == "depth") return Pattern::Depth;
+    else throw VideoException("TestVideo: Unknown pattern '" + str + "'");
+}
+
 PANGOLIN_REGISTER_FACTORY(TestVideo)
 {
     struct TestVideoFactory final : public TypedFactoryInterface<VideoInterface> {
@@ -103,14 +378,20 @@ PANGOLIN_REGISTER_FACTORY(TestVideo)
         }
         const char* Description() const override
         {
-            return "A test video feed with pixel-wise white noise.";
+            return "A synthetic test video feed of white noise or moving patterns, deterministic for a given seed.";
         }
         ParamSet Params() const override
         {
             return {{
                 {"size","640x480","Image dimension"},
                 {"n","1","Number of streams"},
-                {"fmt","RGB24","Pixel format: see pixel format help for all possible values"}
+                {"fmt","RGB24","Pixel format: see pixel format help for all possible values"},
+                {"pattern","noise","One of noise, gradient, bayer (single channel formats) or depth"},
+                {"noise","0","Amplitude of noise added to the pattern, as a fraction of full scale"},
+                {"seed","0","Seed for the noise. Identical seeds give identical video"},
+                {"fps","0","Frame rate to pace frames at. 0 to generate them as fast as they are grabbed"},
+                {"jitter_us","0","Maximum random delay of each frame, up to the frame period"},
+                {"frames","0","Number of frames before the video ends. 0 for no end"}
             }};
         }
         std::unique_ptr<VideoInterface> Open(const Uri& uri) override {
@@ -118,7 +399,13 @@ PANGOLIN_REGISTER_FACTORY(TestVideo)
             const ImageDim dim = reader.Get<ImageDim>("size");
             const int n = reader.Get<int>("n");
             std::string fmt  = reader.Get<std::string>("fmt");
-            return std::unique_ptr<VideoInterface>(new TestVideo(dim.x,dim.y,n,fmt));
+            return std::unique_ptr<VideoInterface>(new TestVideo(
+                dim.x, dim.y, n, fmt,
+                TestVideo::PatternFromString(reader.Get<std::string>("pattern")),
+                reader.Get<float>("noise"), reader.Get<uint64_t>("seed"),
+                reader.Get<double>("fps"), reader.Get<double>("jitter_us"),
+                reader.Get<size_t>("frames")
+            ));
         }
     };
 
@@ -26,21 +26,11 @@
  */
 
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/drivers/thread.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
-#ifdef DEBUGTHREAD
-  #include <pangolin/utils/timer.h>
-  #define TSTART() pangolin::basetime start,last,now; start = pangolin::TimeNow(); last = start;
-  #define TGRABANDPRINT(...)  now = pangolin::TimeNow(); fprintf(stderr,"THREAD: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr, " %fms.\n",1000*pangolin::TimeDiff_s(last, now)); last = now;
-  #define DBGPRINT(...) fprintf(stderr,"THREAD: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr,"\n");
-#else
-  #define TSTART()
-  #define TGRABANDPRINT(...)
-  #define DBGPRINT(...)
-#endif
-
 namespace pangolin
 {
 
@@ -127,7 +117,7 @@ bool ThreadVideo::DropNFrames(uint32_t n)
 //! Implement VideoInput::GrabNext()
 bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
 {
-    TSTART()
+    PANGO_TRACE_SCOPE("video", "ThreadVideo::GrabNext");
 
     if(queue.EmptyBuffers() == 0) {
        pango_print_warn("Thread %s(%12p) has run out of %d buffers\n", thread_name.c_str(), this, (int)queue.AvailableFrames());
@@ -135,7 +125,6 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
 
     if(queue.AvailableFrames() == 0 && !wait) {
         // No frames available, no wait, simply return false.
-        DBGPRINT("GrabNext no available frames no wait.");
         return false;
     }else{
         if(queue.AvailableFrames() == 0 && wait) {
@@ -144,8 +133,8 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
                 return false;
             }
             // Must return a frame so block on notification from grab thread.
+            PANGO_TRACE_SCOPE("video", "ThreadVideo::Wait");
             std::unique_lock<std::mutex> lk(cvMtx);
-            DBGPRINT("GrabNext no available frames wait for notification.");
             if(cv.wait_for(lk, std::chrono::milliseconds(capture_timout_ms)) == std::cv_status::timeout)
             {
                 pango_print_warn("ThreadVideo: GrabNext blocking read for frames reached timeout.\n");
@@ -156,16 +145,12 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
         // At least one valid frame in queue, return it.
         GrabResult grab = queue.getNext();
         if(grab.return_status) {
-            DBGPRINT("GrabNext at least one frame available.");
             const size_t buffer_size = videoin[0]->SizeBytes();
             std::memcpy(image, grab.buffer.get(), buffer_size);
             frame_properties = grab.frame_properties;
-        }else{
-            DBGPRINT("GrabNext returned false")
         }
         queue.returnOrAddUsedBuffer(std::move(grab));
 
-        TGRABANDPRINT("GrabNext took")
         return grab.return_status;
     }
 }
@@ -173,16 +158,15 @@ bool ThreadVideo::GrabNext( unsigned char* image, bool wait )
 //! Implement VideoInput::GrabNewest()
 bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
 {
-    TSTART()
+    PANGO_TRACE_SCOPE("video", "ThreadVideo::GrabNewest");
     if(queue.AvailableFrames() == 0 && !wait) {
         // No frames available, no wait, simply return false.
-        DBGPRINT("GrabNext no available frames no wait.");
         return false;
     }else{
         if(queue.AvailableFrames() == 0 && wait) {
             // Must return a frame so block on notification from grab thread.
+            PANGO_TRACE_SCOPE("video", "ThreadVideo::Wait");
             std::unique_lock<std::mutex> lk(cvMtx);
-            DBGPRINT("GrabNewest no available frames wait for notification.");
             if(cv.wait_for(lk, std::chrono::milliseconds(capture_timout_ms)) == std::cv_status::timeout)
             {
                 pango_print_warn("ThreadVideo: GrabNewest blocking read for frames reached timeout.\n");
@@ -191,7 +175,6 @@ bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
         }
 
         // At least one valid frame in queue, return it.
-        DBGPRINT("GrabNewest at least one frame available.");
         GrabResult grab = queue.getNewest();
         const bool success = grab.return_status;
         if(success) {
@@ -199,7 +182,6 @@ bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
             frame_properties = grab.frame_properties;
         }
         queue.returnOrAddUsedBuffer(std::move(grab));
-        TGRABANDPRINT("GrabNewest memcpy of available frame took")
 
         return success;
     }
@@ -207,7 +189,8 @@ bool ThreadVideo::GrabNewest( unsigned char* image, bool wait )
 
 void ThreadVideo::operator()()
 {
-    DBGPRINT("Grab thread Started.")
+    Tracer::Instance().SetThreadName(thread_name.empty() ? "ThreadVideo" : thread_name);
+
     // Spinning thread attempting to read from videoin[0] as fast as possible
     // relying on the videoin[0] blocking grab.
     while(!quit_grab_thread) {
@@ -218,6 +201,7 @@ void ThreadVideo::operator()()
 
             // Blocking grab (i.e. GrabNext with wait = true).
             try{
+                PANGO_TRACE_SCOPE("video", "ThreadVideo::Grab");
                 grab.return_status = videoin[0]->GrabNext(grab.buffer.get(), true);
             }catch(const VideoException& e) {
                 // User doesn't have the opportunity to catch exceptions here.
@@ -241,7 +225,6 @@ void ThreadVideo::operator()()
             }
             queue.addValidBuffer(std::move(grab));
 
-            DBGPRINT("Grab thread got frame. valid:%d free:%d",queue.AvailableFrames(),queue.EmptyBuffers())
             // Let listening threads know we got a frame in case they are waiting.
             cv.notify_all();
         }else{
@@ -249,7 +232,6 @@ void ThreadVideo::operator()()
         }
         std::this_thread::yield();
     }
-    DBGPRINT("Grab thread Stopped.")
 
     return;
 }
@@ -290,7 +272,3 @@ PANGOLIN_REGISTER_FACTORY(ThreadVideo)
 }
 
 }
-
-#undef TSTART
-#undef TGRABANDPRINT
-#undef DBGPRINT
@@ -27,6 +27,7 @@
 
 #include <pangolin/video/drivers/transform.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
@@ -438,7 +439,7 @@ void RotateCCW(Image<unsigned char>& img_out, const Image<unsigned char>& img_in
 
 void TransformVideo::Process(unsigned char* buffer_out, const unsigned char* buffer_in)
 {
-
+    PANGO_TRACE_SCOPE("video", "TransformVideo::Process");
     for(size_t s=0; s<streams.size(); ++s) {
         Image<unsigned char> img_out = Streams()[s].StreamImage(buffer_out);
         const Image<unsigned char> img_in  = videoin->Streams()[s].StreamImage(buffer_in);
@@ -474,6 +475,11 @@ void TransformVideo::Process(unsigned char* buffer_out, const unsigned char* buf
 
 }
 
+void TransformVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    Process(out, in);
+}
+
 //! Implement VideoInput::GrabNext()
 bool TransformVideo::GrabNext( unsigned char* image, bool wait )
 {
@@ -27,20 +27,10 @@
 
 #include <pangolin/video/drivers/unpack.h>
 #include <pangolin/factory/factory_registry.h>
+#include <pangolin/utils/trace.h>
 #include <pangolin/video/iostream_operators.h>
 #include <pangolin/video/video.h>
 
-#ifdef DEBUGUNPACK
-  #include <pangolin/utils/timer.h>
-  #define TSTART() pangolin::basetime start,last,now; start = pangolin::TimeNow(); last = start;
-  #define TGRABANDPRINT(...)  now = pangolin::TimeNow(); fprintf(stderr,"UNPACK: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr, " %fms.\n",1000*pangolin::TimeDiff_s(last, now)); last = now;
-  #define DBGPRINT(...) fprintf(stderr,"UNPACK: "); fprintf(stderr, __VA_ARGS__); fprintf(stderr,"\n");
-#else
-  #define TSTART()
-  #define TGRABANDPRINT(...)
-  #define DBGPRINT(...)
-#endif
-
 namespace pangolin
 {
 
@@ -157,39 +147,47 @@ void ConvertFrom12bit(
     }
 }
 
+void UnpackVideo::ProcessRows(size_t s, Image<unsigned char>& img_out, const Image<unsigned char>& img_in)
+{
+    const int bits_in  = videoin[0]->Streams()[s].PixFormat().bpp;
+
+    if(Streams()[s].PixFormat().format == "GRAY32F") {
+        if( bits_in == 8) {
+            ConvertFrom8bit<float>(img_out, img_in);
+        }else if( bits_in == 10) {
+            ConvertFrom10bit<float>(img_out, img_in);
+        }else if( bits_in == 12){
+            ConvertFrom12bit<float>(img_out, img_in);
+        }else{
+            throw pangolin::VideoException("Unsupported bitdepths.");
+        }
+    }else if(Streams()[s].PixFormat().format == "GRAY16LE") {
+        if( bits_in == 8) {
+            ConvertFrom8bit<uint16_t>(img_out, img_in);
+        }else if( bits_in == 10) {
+            ConvertFrom10bit<uint16_t>(img_out, img_in);
+        }else if( bits_in == 12){
+            ConvertFrom12bit<uint16_t>(img_out, img_in);
+        }else{
+            throw pangolin::VideoException("Unsupported bitdepths.");
+        }
+    }else{
+    }
+}
+
 void UnpackVideo::Process(unsigned char* image, const unsigned char* buffer)
 {
-    TSTART()
+    PANGO_TRACE_SCOPE("video", "UnpackVideo::Process");
     for(size_t s=0; s<streams.size(); ++s) {
         const Image<unsigned char> img_in  = videoin[0]->Streams()[s].StreamImage(buffer);
         Image<unsigned char> img_out = Streams()[s].StreamImage(image);
-
-        const int bits_in  = videoin[0]->Streams()[s].PixFormat().bpp;
-
-        if(Streams()[s].PixFormat().format == "GRAY32F") {
-            if( bits_in == 8) {
-                ConvertFrom8bit<float>(img_out, img_in);
-            }else if( bits_in == 10) {
-                ConvertFrom10bit<float>(img_out, img_in);
-            }else if( bits_in == 12){
-                ConvertFrom12bit<float>(img_out, img_in);
-            }else{
-                throw pangolin::VideoException("Unsupported bitdepths.");
-            }
-        }else if(Streams()[s].PixFormat().format == "GRAY16LE") {
-            if( bits_in == 8) {
-                ConvertFrom8bit<uint16_t>(img_out, img_in);
-            }else if( bits_in == 10) {
-                ConvertFrom10bit<uint16_t>(img_out, img_in);
-            }else if( bits_in == 12){
-                ConvertFrom12bit<uint16_t>(img_out, img_in);
-            }else{
-                throw pangolin::VideoException("Unsupported bitdepths.");
-            }
-        }else{
-        }
+        ProcessRows(s, img_out, img_in);
     }
-    TGRABANDPRINT("Unpacking took ")
+}
+
+void UnpackVideo::ProcessFrame(unsigned char* out, const unsigned char* in, const picojson::value& /*frame_properties*/)
+{
+    Process(out, in);
 }
 
 //! Implement VideoInput::GrabNext()
@@ -278,7 +276,3 @@ PANGOLIN_REGISTER_FACTORY(UnpackVideo)
 }
 
 }
-
-#undef TSTART
-#undef TGRABANDPRINT
-#undef DBGPRINT
@@ -43,6 +43,7 @@
 #include <linux/usb/video.h>
 #include <linux/uvcvideo.h>
 #include <malloc.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -77,11 +78,66 @@ inline std::string V4lToString(int32_t v)
     return std::string(cc);
 }
 
-V4lVideo::V4lVideo(const char* dev_name, uint32_t period, io_method io, unsigned iwidth, unsigned iheight, unsigned v4l_format)
-    : io(io), fd(-1), buffers(0), n_buffers(0), running(false), period(period)
+struct V4lVideo::LeaseOwner
 {
+    std::mutex mutex;
+    V4lVideo* video;
+};
+
+V4lVideo::Lease::Lease()
+    : index(0), data(nullptr), bytes(0), dmabuf_fd(-1)
+{
+}
+
+V4lVideo::Lease::Lease(Lease&& o)
+    : owner(std::move(o.owner)), index(o.index), data(o.data), bytes(o.bytes), dmabuf_fd(o.dmabuf_fd),
+      frame_properties(std::move(o.frame_properties))
+{
+    o.data = nullptr;
+}
+
+V4lVideo::Lease& V4lVideo::Lease::operator=(Lease&& o)
+{
+    if(this != &o) {
+        Release();
+        owner = std::move(o.owner);
+        index = o.index;
+        data = o.data;
+        bytes = o.bytes;
+        dmabuf_fd = o.dmabuf_fd;
+        frame_properties = std::move(o.frame_properties);
+        o.data = nullptr;
+    }
+    return *this;
+}
+
+V4lVideo::Lease::~Lease()
+{
+    Release();
+}
+
+void V4lVideo::Lease::Release()
+{
+    if(owner) {
+        std::lock_guard<std::mutex> l(owner->mutex);
+        if(owner->video) owner->video->Requeue(index);
+        owner.reset();
+        data = nullptr;
+        bytes = 0;
+        dmabuf_fd = -1;
+    }
+}
+
+V4lVideo::V4lVideo(const char* dev_name, uint32_t period, io_method io, unsigned iwidth, unsigned iheight, unsigned v4l_format, unsigned num_buffers, bool export_dmabuf)
+    : io(io), fd(-1), buffers(0), n_buffers(0), num_buffers_requested(num_buffers), export_dmabuf(export_dmabuf), running(false),
+      lease_owner(std::make_shared<LeaseOwner>()), period(period)
+{
+    lease_owner->video = this;
     open_device(dev_name);
     init_device(dev_name,iwidth,iheight,0,v4l_format);
+    if(export_dmabuf) {
+        export_dmabufs();
+    }
     InitPangoDeviceProperties();
 
     Start();
@@ -89,11 +145,14 @@ V4lVideo::V4lVideo(const char* dev_name, uint32_t period, io_method io, unsigned
 
 V4lVideo::~V4lVideo()
 {
-    if(running)
     {
-        Stop();
+        // Leases released from now on don't touch this
+        std::lock_guard<std::mutex> l(lease_owner->mutex);
+        lease_owner->video = nullptr;
     }
 
+    Stop();
+
     uninit_device();
     close_device();
 }
@@ -114,40 +173,41 @@ size_t V4lVideo::SizeBytes() const
     return image_size;
 }
 
-bool V4lVideo::GrabNext( unsigned char* image, bool wait )
+bool V4lVideo::WaitForFrame(bool wait)
 {
-    for (;;) {
-        fd_set fds;
-        struct timeval tv;
-        int r;
-
-        FD_ZERO (&fds);
-        FD_SET (fd, &fds);
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
 
-        /* Timeout. */
-        tv.tv_sec = 0;
-        tv.tv_usec = 2 * period;
+    // Twice the frame period is longer than any reasonable frame interval
+    const int timeout_ms = wait ? (int)((2 * period + 999) / 1000) : 0;
 
-        r = select (fd + 1, &fds, NULL, NULL, &tv);
+    for (;;) {
+        const int r = poll(&pfd, 1, timeout_ms);
 
         if (-1 == r) {
             if (EINTR == errno)
                 continue;
 
             // This is a terminal condition that must be propogated up.
-            throw VideoException ("select", strerror(errno));
+            throw VideoException ("poll", strerror(errno));
         }
 
-        if (0 == r) {
-            // Timeout has occured - This is longer than any reasonable frame interval,
-            // but not necessarily terminal, so return false to indicate that no frame was captured.
+        // Timeout isn't necessarily terminal, so just report no frame
+        return r > 0;
+    }
+}
+
+bool V4lVideo::GrabNext( unsigned char* image, bool wait )
+{
+    for (;;) {
+        if (!WaitForFrame(wait))
             return false;
-        }
 
         if (ReadFrame(image, wait))
             break;
 
-        /* EAGAIN - continue select loop. */
+        /* EAGAIN - continue poll loop. */
     }
 
     return true;
@@ -159,6 +219,65 @@ bool V4lVideo::GrabNewest( unsigned char* image, bool wait )
     return GrabNext(image,wait);
 }
 
+bool V4lVideo::GrabNextLease( Lease& lease, bool wait )
+{
+    lease.Release();
+
+    if (io != IO_METHOD_MMAP)
+        throw VideoException("V4lVideo: leases require method=mmap");
+
+    for (;;) {
+        if (!WaitForFrame(wait))
+            return false;
+
+        struct v4l2_buffer buf;
+        CLEAR (buf);
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+
+        if (-1 == xioctl (fd, VIDIOC_DQBUF, &buf)) {
+            if (EAGAIN == errno)
+                continue;
+            throw VideoException("VIDIOC_DQBUF", strerror(errno));
+        }
+        // This is a hack, this ts sould come from the device.
+        frame_properties[PANGO_HOST_RECEPTION_TIME_US] = picojson::value(pangolin::Time_us(pangolin::TimeNow()));
+
+        assert (buf.index < n_buffers);
+        {
+            std::lock_guard<std::mutex> l(lease_mutex);
+            leased[buf.index] = true;
+        }
+
+        lease.owner = lease_owner;
+        lease.index = buf.index;
+        lease.data = (const unsigned char*)buffers[buf.index].start;
+        lease.bytes = buf.bytesused;
+        lease.dmabuf_fd = buffers[buf.index].dmabuf_fd;
+        lease.frame_properties = frame_properties;
+        return true;
+    }
+}
+
+void V4lVideo::Requeue(unsigned index)
+{
+    std::lock_guard<std::mutex> l(lease_mutex);
+    leased[index] = false;
+
+    // Otherwise Start() will queue it. Start() and Stop() hold lease_mutex
+    // throughout, so running matches the state of the stream.
+    if (running) {
+        struct v4l2_buffer buf;
+        CLEAR (buf);
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = index;
+
+        if (-1 == xioctl (fd, VIDIOC_QBUF, &buf))
+            pango_print_warn("V4lVideo: VIDIOC_QBUF error: %s\n", strerror(errno));
+    }
+}
+
 int V4lVideo::ReadFrame(unsigned char* image, bool wait)
 {
     struct v4l2_buffer buf;
@@ -271,6 +390,7 @@ int V4lVideo::ReadFrame(unsigned char* image, bool wait)
 
 void V4lVideo::Stop()
 {
+    std::lock_guard<std::mutex> l(lease_mutex);
     if(running) {
         enum v4l2_buf_type type;
 
@@ -298,6 +418,7 @@ void V4lVideo::Stop()
 
 void V4lVideo::Start()
 {
+    std::lock_guard<std::mutex> l(lease_mutex);
     if(!running) {
         unsigned int i;
         enum v4l2_buf_type type;
@@ -311,6 +432,9 @@ void V4lVideo::Start()
             for (i = 0; i < n_buffers; ++i) {
                 struct v4l2_buffer buf;
 
+                if (leased[i])
+                    continue;
+
                 CLEAR (buf);
 
                 buf.type        = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -366,9 +490,12 @@ void V4lVideo::uninit_device()
         break;
 
     case IO_METHOD_MMAP:
-        for (i = 0; i < n_buffers; ++i)
+        for (i = 0; i < n_buffers; ++i) {
+            if (buffers[i].dmabuf_fd >= 0)
+                close (buffers[i].dmabuf_fd);
             if (-1 == munmap (buffers[i].start, buffers[i].length))
                 throw VideoException ("munmap");
+        }
         break;
 
     case IO_METHOD_USERPTR:
@@ -389,6 +516,7 @@ void V4lVideo::init_read(unsigned int buffer_size)
     }
 
     buffers[0].length = buffer_size;
+    buffers[0].dmabuf_fd = -1;
     buffers[0].start = malloc (buffer_size);
 
     if (!buffers[0].start) {
@@ -402,7 +530,7 @@ void V4lVideo::init_mmap(const char* /*dev_name*/)
 
     CLEAR (req);
 
-    req.count               = 4;
+    req.count               = num_buffers_requested;
     req.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory              = V4L2_MEMORY_MMAP;
 
@@ -437,6 +565,7 @@ void V4lVideo::init_mmap(const char* /*dev_name*/)
             throw VideoException ("VIDIOC_QUERYBUF", strerror(errno));
 
         buffers[n_buffers].length = buf.length;
+        buffers[n_buffers].dmabuf_fd = -1;
         buffers[n_buffers].start =
                 mmap (NULL /* start anywhere */,
                       buf.length,
@@ -447,6 +576,31 @@ void V4lVideo::init_mmap(const char* /*dev_name*/)
         if (MAP_FAILED == buffers[n_buffers].start)
             throw VideoException ("mmap");
     }
+
+    leased.assign(n_buffers, false);
+}
+
+void V4lVideo::export_dmabufs()
+{
+    if (io != IO_METHOD_MMAP)
+        throw VideoException("V4lVideo: dmabuf export requires method=mmap");
+
+    for (unsigned int i = 0; i < n_buffers; ++i) {
+        struct v4l2_exportbuffer expbuf;
+
+        CLEAR (expbuf);
+
+        expbuf.type     = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index    = i;
+        expbuf.flags    = O_RDONLY | O_CLOEXEC;
+
+        if (-1 == xioctl (fd, VIDIOC_EXPBUF, &expbuf)) {
+            pango_print_warn("V4lVideo: unable to export DMABUF: %s\n", strerror(errno));
+            return;
+        }
+
+        buffers[i].dmabuf_fd = expbuf.fd;
+    }
 }
 
 void V4lVideo::init_userp(const char* /*dev_name*/, unsigned int buffer_size)
@@ -459,7 +613,7 @@ void V4lVideo::init_userp(const char* /*dev_name*/, unsigned int buffer_size)
 
     CLEAR (req);
 
-    req.count               = 4;
+    req.count               = num_buffers_requested;
     req.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory              = V4L2_MEMORY_USERPTR;
 
@@ -471,14 +625,15 @@ void V4lVideo::init_userp(const char* /*dev_name*/, unsigned int buffer_size)
         }
     }
 
-    buffers = (buffer*)calloc(4, sizeof(buffer));
+    buffers = (buffer*)calloc(req.count, sizeof(buffer));
 
     if (!buffers) {
         throw VideoException( "Out of memory\n");
     }
 
-    for (n_buffers = 0; n_buffers < 4; ++n_buffers) {
+    for (n_buffers = 0; n_buffers < req.count; ++n_buffers) {
         buffers[n_buffers].length = buffer_size;
+        buffers[n_buffers].dmabuf_fd = -1;
         buffers[n_buffers].start = memalign (/* boundary */ page_size,
                                              buffer_size);
 
@@ -793,6 +948,8 @@ PANGOLIN_REGISTER_FACTORY(V4lVideo)
                 {"size","0x0","Desired image size"},
                 {"format","YUYV422","Desired image format"},
                 {"period","50000","Period in microsecs"},
+                {"buffers","4","Number of driver buffers to request"},
+                {"dmabuf","0","Export driver buffers as DMABUF file descriptors, available through V4lVideo::Lease"},
                 {"ExposureTime","10000","Exposure time in microsecs"},
                 {"Gain","1","Image gain parameter"}
             }};
@@ -833,8 +990,10 @@ PANGOLIN_REGISTER_FACTORY(V4lVideo)
             }
 
             uint32_t period = reader.Get<int>("period");
+            const unsigned num_buffers = reader.Get<int>("buffers");
+            const bool dmabuf = reader.Get<bool>("dmabuf");
 
-            V4lVideo* video_raw = new V4lVideo(uri.url.c_str(), period, method, desired_dim.x, desired_dim.y, format);
+            V4lVideo* video_raw = new V4lVideo(uri.url.c_str(), period, method, desired_dim.x, desired_dim.y, format, num_buffers, dmabuf);
             if(video_raw  && uri.Contains("ExposureTime")) {
                 static_cast<V4lVideo*>(video_raw)->SetExposure(reader.Get<int>("ExposureTime"));
             }
@@ -23,6 +23,7 @@ void PrintPixelFormats(std::ostream& out, bool color)
 void VideoHelp( std::ostream& out, const std::string& scheme_filter, HelpVerbosity verbosity)
 {
     RegisterFactoriesVideoInterface();
+    FactoryRegistry::I()->LoadAllPlugins();
 
 #ifndef _WIN32_
     const bool use_color = true;
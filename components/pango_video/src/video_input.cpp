@@ -27,6 +27,7 @@
 
 #include <pangolin/video/video_input.h>
 #include <pangolin/video/video_output.h>
+#include <pangolin/utils/trace.h>
 
 namespace pangolin
 {
@@ -36,6 +37,15 @@ VideoInput::VideoInput()
 {
 }
 
+VideoInput::VideoInput(VideoInput&& other)
+    : uri_input(std::move(other.uri_input)), uri_output(std::move(other.uri_output)),
+      video_src(std::move(other.video_src)), video_recorder(std::move(other.video_recorder)),
+      videos(std::move(other.videos)), buffer_size_bytes(other.buffer_size_bytes),
+      frame_num(other.frame_num), record_frame_skip(other.record_frame_skip),
+      record_once(other.record_once), record_continuous(other.record_continuous)
+{
+}
+
 VideoInput::VideoInput(
     const std::string& input_uri,
     const std::string& output_uri
@@ -69,7 +79,10 @@ void VideoInput::Open(
 void VideoInput::Close()
 {
     // Reset this first so that recording data gets written out to disk ASAP.
-    video_recorder.reset();
+    {
+        std::lock_guard<std::mutex> l(recorder_mutex);
+        video_recorder.reset();
+    }
 
     video_src.reset();
     videos.clear();
@@ -129,20 +142,26 @@ void VideoInput::Record()
     videos[0] = video_src.get();
 
     // Initialise recorder and ensure src is started
-    InitialiseRecorder();
+    {
+        std::lock_guard<std::mutex> l(recorder_mutex);
+        InitialiseRecorder();
+        frame_num = 0;
+        record_continuous = true;
+    }
     video_src->Start();
-    frame_num = 0;
-    record_continuous = true;
 }
 
 void VideoInput::RecordOneFrame()
 {
     // Append to existing video.
-    if(!video_recorder) {
-        InitialiseRecorder();
+    {
+        std::lock_guard<std::mutex> l(recorder_mutex);
+        if(!video_recorder) {
+            InitialiseRecorder();
+        }
+        record_continuous = false;
+        record_once = true;
     }
-    record_continuous = false;
-    record_once = true;
 
     // Switch sub-video
     videos.resize(1);
@@ -167,52 +186,53 @@ void VideoInput::Start()
 
 void VideoInput::Stop()
 {
-    if(IsRecording()) {
+    std::unique_lock<std::mutex> l(recorder_mutex);
+    if(video_recorder) {
         video_recorder.reset();
     }else{
+        l.unlock();
         video_src->Stop();
     }
 }
 
-bool VideoInput::GrabNext( unsigned char* image, bool wait )
+void VideoInput::RecordGrabbed(unsigned char* image, bool success)
 {
+    std::lock_guard<std::mutex> l(recorder_mutex);
     frame_num++;
 
     const bool should_record = (record_continuous && !(frame_num % record_frame_skip)) || record_once;
 
-    const bool success = video_src->GrabNext(image, wait);
-
     if( should_record && video_recorder != 0 && success) {
         video_recorder->WriteStreams(image, GetVideoFrameProperties(video_src.get()) );
         record_once = false;
     }
+}
 
+bool VideoInput::GrabNext( unsigned char* image, bool wait )
+{
+    PANGO_TRACE_SCOPE("video", "VideoInput::GrabNext");
+    const bool success = video_src->GrabNext(image, wait);
+    RecordGrabbed(image, success);
     return success;
 }
 
 bool VideoInput::GrabNewest( unsigned char* image, bool wait )
 {
-    frame_num++;
-
-    const bool should_record = (record_continuous && !(frame_num % record_frame_skip)) || record_once;
+    PANGO_TRACE_SCOPE("video", "VideoInput::GrabNewest");
     const bool success = video_src->GrabNewest(image,wait);
-
-    if( should_record && video_recorder != 0 && success)
-    {
-        video_recorder->WriteStreams(image, GetVideoFrameProperties(video_src.get()) );
-        record_once = false;
-    }
-
+    RecordGrabbed(image, success);
     return success;
 }
 
 void VideoInput::SetTimelapse(size_t one_in_n_frames)
 {
+    std::lock_guard<std::mutex> l(recorder_mutex);
     record_frame_skip = one_in_n_frames;
 }
 
 bool VideoInput::IsRecording() const
 {
+    std::lock_guard<std::mutex> l(recorder_mutex);
     return video_recorder != 0;
 }
 
@@ -0,0 +1,75 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/video/video.h>
+#include <pangolin/video/video_output.h>
+#include <pangolin/video/drivers/fused.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+TEST_CASE( "Row filter chains are fused without changing their output" )
+{
+    {
+        auto test = pangolin::OpenVideo("test:[size=96x1000,n=1,fmt=GRAY16LE]//");
+        auto output = pangolin::OpenVideoOutput("pango://test_fused.pango");
+        output->SetStreams(test->Streams(), "test://", picojson::value());
+        std::vector<unsigned char> frame(test->SizeBytes());
+        for(int i=0; i < 3; ++i) {
+            REQUIRE(test->GrabNext(frame.data()));
+            output->WriteStreams(frame.data());
+        }
+    }
+
+    const std::string uri = "gamma:[gamma1=2.2]//shift:[shift1=2]//unpack:[fmt=GRAY16LE]//pack:[fmt=GRAY10]//file://test_fused.pango";
+    auto fused = pangolin::OpenVideo("fuse://" + uri);
+    auto* fused_video = dynamic_cast<pangolin::FusedVideo*>(fused.get());
+    REQUIRE(fused_video);
+    REQUIRE(fused_video->Stages().size() == 4);
+
+    // Fusion is opt-in
+    auto reference = pangolin::OpenVideo(uri);
+    REQUIRE(!dynamic_cast<pangolin::FusedVideo*>(reference.get()));
+    REQUIRE(fused->SizeBytes() == reference->SizeBytes());
+
+    std::vector<unsigned char> a(fused->SizeBytes()), b(reference->SizeBytes());
+    for(int i=0; i < 3; ++i) {
+        REQUIRE(fused->GrabNext(a.data()));
+        REQUIRE(reference->GrabNext(b.data()));
+        REQUIRE(std::memcmp(a.data(), b.data(), a.size()) == 0);
+    }
+
+    // Frames are grabbed from the base video, so its properties are reported
+    REQUIRE(pangolin::GetVideoFrameProperties(fused.get()) == pangolin::GetVideoFrameProperties(fused_video->Base()));
+    REQUIRE(dynamic_cast<pangolin::BufferAwareVideoInterface*>(fused.get()));
+
+    fused.reset();
+    reference.reset();
+    std::remove("test_fused.pango");
+}
+
+TEST_CASE( "Gamma is applied to every channel of each pixel" )
+{
+    const std::string src = "test:[size=37x5,n=1,fmt=RGB24]//";
+    auto video = pangolin::OpenVideo("gamma:[gamma1=2.2]//" + src);
+    auto reference = pangolin::OpenVideo(src);
+
+    std::vector<unsigned char> a(video->SizeBytes()), b(reference->SizeBytes());
+    REQUIRE(video->GrabNext(a.data()));
+    REQUIRE(reference->GrabNext(b.data()));
+
+    const pangolin::Image<unsigned char> out = video->Streams()[0].StreamImage(a.data());
+    const pangolin::Image<unsigned char> in = reference->Streams()[0].StreamImage(b.data());
+    for(size_t y=0; y < in.h; ++y) {
+        for(size_t x=0; x < 3*in.w; ++x) {
+            const int expected = int(std::pow(in.RowPtr(y)[x] / 255.0f, 2.2f) * 255.0f + 0.5f);
+            REQUIRE(std::abs(int(out.RowPtr(y)[x]) - expected) <= 1);
+        }
+    }
+}
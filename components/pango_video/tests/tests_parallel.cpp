@@ -0,0 +1,47 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/video/video.h>
+#include <pangolin/video/video_output.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+TEST_CASE( "Parallel filters return frames in order with their properties" )
+{
+    {
+        auto test = pangolin::OpenVideo("test:[size=64x48,n=1,fmt=RGB24]//");
+        auto output = pangolin::OpenVideoOutput("pango://test_parallel.pango");
+        output->SetStreams(test->Streams(), "test://", picojson::value());
+        std::vector<unsigned char> frame(test->SizeBytes());
+        for(int i=0; i < 20; ++i) {
+            REQUIRE(test->GrabNext(frame.data()));
+            picojson::value props;
+            props[PANGO_FRAME_COUNTER] = i;
+            output->WriteStreams(frame.data(), props);
+        }
+    }
+
+    auto parallel = pangolin::OpenVideo("parallel:[threads=3,depth=4]//flipx://file://test_parallel.pango");
+    auto reference = pangolin::OpenVideo("flipx://file://test_parallel.pango");
+    parallel->Start();
+    reference->Start();
+
+    std::vector<unsigned char> a(parallel->SizeBytes()), b(reference->SizeBytes());
+    for(int i=0; i < 20; ++i) {
+        REQUIRE(parallel->GrabNext(a.data()));
+        REQUIRE(reference->GrabNext(b.data()));
+        REQUIRE(std::memcmp(a.data(), b.data(), a.size()) == 0);
+        REQUIRE(pangolin::GetVideoFrameProperties(parallel.get())[PANGO_FRAME_COUNTER].get<int64_t>() == i);
+    }
+    REQUIRE(!parallel->GrabNext(a.data()));
+
+    parallel.reset();
+    reference.reset();
+    std::remove("test_parallel.pango");
+}
@@ -0,0 +1,59 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/video/video.h>
+#include <pangolin/video/video_output.h>
+#include <pangolin/video/drivers/shared_memory.h>
+
+#include <cstring>
+
+TEST_CASE( "Shared memory ring output and readers" )
+{
+    const pangolin::StreamInfo si(pangolin::PixelFormatFromString("GRAY8"), 8, 4, 8, 0);
+    auto output = pangolin::OpenVideoOutput("shmem:[slots=3]//pango_test_ring");
+    output->SetStreams({si}, "test://", picojson::value());
+
+    auto video = pangolin::OpenVideo("shmem://pango_test_ring");
+    REQUIRE(video->SizeBytes() == 32);
+    REQUIRE(video->Streams()[0].PixFormat().format == "GRAY8");
+
+    auto* shmem = dynamic_cast<pangolin::SharedMemoryVideo*>(video.get());
+    REQUIRE(shmem);
+
+    unsigned char frame[32];
+    unsigned char image[32];
+    REQUIRE(!video->GrabNext(image, false));
+
+    for(int i=0; i < 5; ++i) {
+        std::memset(frame, i, sizeof(frame));
+        picojson::value props;
+        props[PANGO_FRAME_COUNTER] = i;
+        output->WriteStreams(frame, props);
+    }
+
+    // Only the last 3 frames are still in the ring
+    REQUIRE(video->GrabNext(image, false));
+    REQUIRE(image[0] == 2);
+    REQUIRE(shmem->FrameProperties()[PANGO_FRAME_COUNTER].get<int64_t>() == 2);
+    REQUIRE(shmem->FramesDropped() == 2);
+
+    {
+        // A leased slot isn't overwritten while others are free
+        pangolin::SharedMemoryVideo::Lease lease;
+        REQUIRE(shmem->GrabNextLease(lease, false));
+        REQUIRE(lease.Data()[31] == 3);
+        std::memset(frame, 5, sizeof(frame));
+        output->WriteStreams(frame, picojson::value());
+        output->WriteStreams(frame, picojson::value());
+        REQUIRE(lease.Valid());
+        REQUIRE(lease.Data()[31] == 3);
+    }
+
+    REQUIRE(video->GrabNewest(image, false));
+    REQUIRE(image[0] == 5);
+    REQUIRE(!video->GrabNext(image, false));
+}
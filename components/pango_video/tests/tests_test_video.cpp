@@ -0,0 +1,51 @@
+#define CATCH_CONFIG_MAIN
+#if __has_include(<catch2/catch.hpp>)
+#include <catch2/catch.hpp>
+#else
+#include <catch2/catch_test_macros.hpp>
+#endif
+
+#include <pangolin/video/video.h>
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+TEST_CASE( "Test video is reproducible from its seed" )
+{
+    const std::string uri = "test:[size=40x30,n=2,fmt=GRAY10,pattern=bayer,noise=0.1,seed=7,frames=3]//";
+    auto a = pangolin::OpenVideo(uri);
+    auto b = pangolin::OpenVideo(uri);
+    REQUIRE(a->Streams().size() == 2);
+    REQUIRE(size_t(a->Streams()[1].Offset() - a->Streams()[0].Offset()) == a->Streams()[0].SizeBytes());
+
+    std::vector<unsigned char> x(a->SizeBytes()), y(b->SizeBytes());
+    int64_t last_capture = -1;
+    for(int i=0; i < 3; ++i) {
+        REQUIRE(a->GrabNext(x.data()));
+        REQUIRE(b->GrabNext(y.data()));
+        REQUIRE(std::memcmp(x.data(), y.data(), x.size()) == 0);
+
+        const picojson::value& props = pangolin::GetVideoFrameProperties(a.get());
+        REQUIRE(props[PANGO_FRAME_COUNTER].get<int64_t>() == i);
+        REQUIRE(props[PANGO_CAPTURE_TIME_US].get<int64_t>() > last_capture);
+        last_capture = props[PANGO_CAPTURE_TIME_US].get<int64_t>();
+    }
+    REQUIRE(!a->GrabNext(x.data()));
+}
+
+TEST_CASE( "Test video noise doesn't repeat between rows or frames" )
+{
+    auto video = pangolin::OpenVideo("test:[size=64x32,n=2,fmt=GRAY8,seed=3]//");
+    const size_t row_bytes = video->Streams()[0].RowBytes();
+
+    std::set<std::vector<unsigned char>> rows;
+    std::vector<unsigned char> image(video->SizeBytes());
+    for(int i=0; i < 4; ++i) {
+        REQUIRE(video->GrabNext(image.data()));
+        for(size_t r=0; r < image.size() / row_bytes; ++r) {
+            const unsigned char* row = image.data() + r * row_bytes;
+            REQUIRE(rows.emplace(row, row + row_bytes).second);
+        }
+    }
+}
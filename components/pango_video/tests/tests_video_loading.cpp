@@ -8,6 +8,10 @@
 #include <pangolin/video/video.h>
 #include <pangolin/factory/factory_registry.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 TEST_CASE( "Loading built in video driver" ) {
     // If this throws, we've probably messed up the factory loading stuff again...
     auto video = pangolin::OpenVideo("test:[size=123x345,n=1,fmt=RGB24]//");
@@ -28,3 +32,18 @@ TEST_CASE( "Error when providing the wrong arguments" )
 {
     REQUIRE_THROWS_AS(pangolin::OpenVideo("test:[width=123,height=345,n=3,fmt=RGB24]//"), pangolin::FactoryRegistry::ParameterMismatchException);
 }
+
+TEST_CASE( "Opening videos from several threads at once" )
+{
+    std::atomic<int> opened(0);
+    std::vector<std::thread> threads;
+    for(int t=0; t < 4; ++t) {
+        threads.emplace_back([&](){
+            for(int i=0; i < 20; ++i) {
+                if(pangolin::OpenVideo("test:[size=8x8,n=1,fmt=GRAY8]//")) ++opened;
+            }
+        });
+    }
+    for(std::thread& t : threads) t.join();
+    REQUIRE(opened == 80);
+}
@@ -96,6 +96,10 @@ struct X11Window : public WindowInterface
 
     void ProcessEvents() override;
 
+    bool WaitEvents(double timeout_s) override;
+
+    void Wake() override;
+
     // References the X11 display and context.
     std::shared_ptr<X11Display> display;
     std::shared_ptr<X11GlContext> glcontext;
@@ -105,6 +109,12 @@ struct X11Window : public WindowInterface
     ::Colormap cmap;
 
     Atom delete_message;
+
+    // Self-pipe used to interrupt WaitEvents()
+    int wake_fd[2];
+
+    // Set on expose, cleared by WaitEvents()
+    bool damaged;
 };
 
 }
@@ -116,6 +116,16 @@ public:
     /// and emit interaction callbacks (e.g. mouse, keyboard, resize)
     virtual void ProcessEvents() = 0;
 
+    /// Block until window events arrive, Wake() is called or
+    /// \param timeout_s seconds elapse (negative to wait indefinitely),
+    /// then process events as ProcessEvents(). Returns true if the window
+    /// contents were damaged (e.g. uncovered) and should be redrawn.
+    /// The default implementation just polls at a modest rate.
+    virtual bool WaitEvents(double timeout_s);
+
+    /// Interrupt a blocking WaitEvents(). Safe to call from any thread.
+    virtual void Wake() {}
+
     /// If double-buffered rendering is enabled, swap the
     /// front and back buffers revealing the recent renders
     /// to the back buffer.
@@ -39,6 +39,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cmath>
 #include <cstdarg>
 #include <unordered_map>
 
@@ -103,7 +106,7 @@ error_fatal(const char* format, ...) {
 std::mutex window_mutex;
 std::weak_ptr<X11GlContext> global_gl_context;
 
-const long EVENT_MASKS = ButtonPressMask|ButtonReleaseMask|StructureNotifyMask|ButtonMotionMask|PointerMotionMask|KeyPressMask|KeyReleaseMask|FocusChangeMask;
+const long EVENT_MASKS = ExposureMask|ButtonPressMask|ButtonReleaseMask|StructureNotifyMask|ButtonMotionMask|PointerMotionMask|KeyPressMask|KeyReleaseMask|FocusChangeMask;
 
 // Adapted from: http://www.opengl.org/resources/features/OGLextensions/
 bool isExtensionSupported(const char *extList, const char *extension)
@@ -251,7 +254,7 @@ X11GlContext::~X11GlContext()
 X11Window::X11Window(
     const std::string& title, int width, int height,
     std::shared_ptr<X11Display>& display, std::shared_ptr<X11GlContext> newglcontext
-) : display(display), glcontext(newglcontext), win(0), cmap(0)
+) : display(display), glcontext(newglcontext), win(0), cmap(0), wake_fd{-1,-1}, damaged(false)
 {
     // Get a visual
     EGLint vid;
@@ -324,10 +327,22 @@ X11Window::X11Window(
     if (!glcontext->egl_surface)
         error_fatal("eglCreateWindowSurface() failed: %s", getEGLErrorString().c_str());
     CheckEGLDieOnError();
+
+    if(pipe(wake_fd) == 0) {
+        for(int fd : wake_fd) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }else{
+        wake_fd[0] = wake_fd[1] = -1;
+    }
 }
 
 X11Window::~X11Window()
 {
+    for(int fd : wake_fd) {
+        if(fd >= 0) close(fd);
+    }
     XDestroyWindow( display->display, win );
     XFreeColormap( display->display, cmap );
 }
@@ -419,6 +434,9 @@ void X11Window::ProcessEvents()
 
 
         switch(ev.type){
+        case Expose:
+            damaged = true;
+            break;
         case ConfigureNotify:
             ResizeSignal(WindowResizeEvent{ev.xconfigure.width, ev.xconfigure.height});
             break;
@@ -510,6 +528,38 @@ void X11Window::ProcessEvents()
     }
 }
 
+bool X11Window::WaitEvents(double timeout_s)
+{
+    XFlush(display->display);
+
+    if(XPending(display->display) == 0) {
+        pollfd fds[2] = {
+            {ConnectionNumber(display->display), POLLIN, 0},
+            {wake_fd[0], POLLIN, 0}
+        };
+        const int timeout_ms = timeout_s < 0.0 ? -1 : (int)std::ceil(timeout_s * 1000.0);
+        if(poll(fds, wake_fd[0] >= 0 ? 2 : 1, timeout_ms) > 0 && (fds[1].revents & POLLIN)) {
+            char buffer[64];
+            while(read(wake_fd[0], buffer, sizeof(buffer)) > 0) {}
+        }
+    }
+
+    ProcessEvents();
+
+    const bool was_damaged = damaged;
+    damaged = false;
+    return was_damaged;
+}
+
+void X11Window::Wake()
+{
+    if(wake_fd[1] >= 0) {
+        const char c = 0;
+        // A full pipe already guarantees a wakeup
+        if(write(wake_fd[1], &c, 1) < 0) {}
+    }
+}
+
 void X11Window::SwapBuffers() {
     CheckEGLDieOnError();
     EGLBoolean suc = eglSwapBuffers(glcontext->egl_display, glcontext->egl_surface);
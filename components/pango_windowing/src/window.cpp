@@ -2,9 +2,22 @@
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/factory/RegisterFactoriesWindowInterface.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 namespace pangolin
 {
 
+bool WindowInterface::WaitEvents(double timeout_s)
+{
+    const double poll_interval_s = 0.01;
+    const double wait_s = timeout_s < 0.0 ? poll_interval_s : std::min(timeout_s, poll_interval_s);
+    std::this_thread::sleep_for(std::chrono::duration<double>(wait_s));
+    ProcessEvents();
+    return false;
+}
+
 std::unique_ptr<WindowInterface> ConstructWindow(const Uri& uri)
 {
     RegisterFactoriesWindowInterface();
@@ -0,0 +1,99 @@
+#include <pangolin/log/packetstream_edit.h>
+#include <pangolin/log/packetstream_reader.h>
+#include <pangolin/utils/argagg.hpp>
+#include <pangolin/utils/timer.h>
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+std::vector<pangolin::PacketStreamSourceId> ParseSourceList(const std::string& list)
+{
+    std::vector<pangolin::PacketStreamSourceId> ids;
+    std::stringstream ss(list);
+    std::string id;
+    while(std::getline(ss, id, ',')) {
+        ids.push_back(std::stoul(id));
+    }
+    return ids;
+}
+
+int64_t SecondsToMicroseconds(double s)
+{
+    return (int64_t)std::llround(s * 1e6);
+}
+
+void Usage(const argagg::parser& argparser)
+{
+    std::cerr << "Usage:\n";
+    std::cerr << "  PacketStreamEdit extract [options] in.pango out.pango\n";
+    std::cerr << "  PacketStreamEdit split in.pango out_prefix\n";
+    std::cerr << "  PacketStreamEdit merge out.pango in1.pango in2.pango ...\n";
+    std::cerr << "  PacketStreamEdit concat out.pango in1.pango in2.pango ...\n\n";
+    std::cerr << "Packets are copied verbatim, without decoding, and outputs are re-indexed.\n\n";
+    std::cerr << "Examples:\n";
+    std::cerr << "  PacketStreamEdit extract --start 60 --end 180 in.pango clip.pango   Keep two minutes, starting one minute in\n";
+    std::cerr << "  PacketStreamEdit extract --drop 1 in.pango out.pango                Remove source 1\n";
+    std::cerr << "  PacketStreamEdit split in.pango src                                 Write src_0.pango, src_1.pango, ...\n\n";
+    std::cerr << "Options for extract:\n";
+    std::cerr << argparser << std::endl;
+}
+
+int main( int argc, char* argv[] )
+{
+    argagg::parser argparser = {{
+        { "help", {"-h", "--help"}, "shows this help", 0},
+        { "sources", {"--sources"}, "comma separated list of source ids to keep, in output order (default all)", 1},
+        { "drop", {"--drop"}, "comma separated list of source ids to remove", 1},
+        { "first", {"--first"}, "first frame number to keep, per source", 1},
+        { "last", {"--last"}, "last frame number to keep, per source (inclusive)", 1},
+        { "start", {"--start"}, "start time in seconds from the first packet", 1},
+        { "end", {"--end"}, "end time in seconds from the first packet", 1}
+    }};
+
+    argagg::parser_results args = argparser.parse(argc, argv);
+    if( args["help"] || args.pos.size() < 3 ) {
+        Usage(argparser);
+        return args["help"] ? 0 : 1;
+    }
+
+    const std::string command = args.pos[0];
+    std::vector<std::string> files(args.pos.begin() + 1, args.pos.end());
+
+    try{
+        const pangolin::basetime start = pangolin::TimeNow();
+        size_t written = 0;
+
+        if(command == "extract" && files.size() == 2) {
+            pangolin::PacketStreamSelection selection;
+            if(args["sources"]) selection.sources = ParseSourceList(args["sources"].as<std::string>());
+            if(args["drop"]) selection.drop_sources = ParseSourceList(args["drop"].as<std::string>());
+            if(args["first"]) selection.frame_begin = args["first"].as<size_t>();
+            if(args["last"]) selection.frame_end = args["last"].as<size_t>() + 1;
+            if(args["start"]) selection.time_begin_us = SecondsToMicroseconds(args["start"].as<double>());
+            if(args["end"]) selection.time_end_us = SecondsToMicroseconds(args["end"].as<double>());
+            written = pangolin::ExtractPacketStream(files[0], files[1], selection);
+        }else if(command == "split" && files.size() == 2) {
+            const size_t num_sources = pangolin::PacketStreamReader(files[0]).Sources().size();
+            std::vector<std::string> fileouts;
+            for(size_t i=0; i < num_sources; ++i) {
+                fileouts.push_back(files[1] + "_" + std::to_string(i) + ".pango");
+            }
+            written = pangolin::SplitPacketStream(files[0], fileouts);
+        }else if(command == "merge") {
+            written = pangolin::MergePacketStreams(std::vector<std::string>(files.begin() + 1, files.end()), files[0]);
+        }else if(command == "concat") {
+            written = pangolin::ConcatPacketStreams(std::vector<std::string>(files.begin() + 1, files.end()), files[0]);
+        }else{
+            Usage(argparser);
+            return 1;
+        }
+
+        std::cout << "Wrote " << written << " packets in " << pangolin::TimeDiff_us(start, pangolin::TimeNow()) / 1e6 << "s" << std::endl;
+    }catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "allocation_counter.h"
+
+#include <pangolin/platform.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN_
+#  include <malloc.h>
+#endif
+
+// Replaces the global operator new and delete. This lives in a translation
+// unit of its own so that the compiler can't pair inlined calls to malloc and
+// free against other allocation functions.
+
+static std::atomic<size_t> num_allocations(0);
+static std::atomic<size_t> num_allocated_bytes(0);
+
+size_t NumAllocations()
+{
+    return num_allocations;
+}
+
+size_t NumAllocatedBytes()
+{
+    return num_allocated_bytes;
+}
+
+void* operator new(size_t size)
+{
+    ++num_allocations;
+    num_allocated_bytes += size;
+    if(void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    ++num_allocations;
+    num_allocated_bytes += size;
+    void* p = nullptr;
+#ifdef _WIN_
+    p = _aligned_malloc(size ? size : 1, (size_t)alignment);
+#else
+    if(posix_memalign(&p, std::max((size_t)alignment, sizeof(void*)), size ? size : 1) != 0) p = nullptr;
+#endif
+    if(p) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN_
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+// Number of allocations, and their total size, made through operator new
+// (aligned or not) so far, in any thread or library. Image buffers come from
+// pangolin::ImageMemoryPool, which allocates with posix_memalign rather than
+// new, so are counted through its statistics instead.
+size_t NumAllocations();
+size_t NumAllocatedBytes();
@@ -0,0 +1,457 @@
+#include <pangolin/image/image_memory_pool.h>
+#include <pangolin/video/video.h>
+#include <pangolin/video/video_output.h>
+#include <pangolin/video/drivers/fused.h>
+#include <pangolin/utils/argagg.hpp>
+#include <pangolin/utils/timer.h>
+#include <pangolin/utils/trace.h>
+#include <pangolin/utils/uri.h>
+
+#include "allocation_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+
+struct BenchmarkCase
+{
+    std::string name;
+    std::string uri;
+    std::string output_uri;   // Record to, if not empty
+    bool seek = false;        // Time random access rather than playback
+    std::string fixture_uri = "";         // Recorded to fixture_output_uri first, if not empty
+    std::string fixture_output_uri = "";
+};
+
+// Unlike TimeDiff_s / TimeDiff_us, keeps fractions of a microsecond
+double ElapsedUs(pangolin::basetime start)
+{
+    return std::chrono::duration<double, std::micro>(pangolin::TimeNow() - start).count();
+}
+
+// Latencies in microseconds of one stage of the pipeline, over all frames
+class StageTimes
+{
+public:
+    void Add(double us) { times.push_back(us); }
+
+    picojson::value Summary()
+    {
+        picojson::value s;
+        if(times.empty()) return s;
+        std::sort(times.begin(), times.end());
+        double sum = 0.0;
+        for(double t : times) sum += t;
+        s["mean_us"] = sum / times.size();
+        s["p50_us"] = Percentile(50);
+        s["p90_us"] = Percentile(90);
+        s["p99_us"] = Percentile(99);
+        s["max_us"] = times.back();
+        return s;
+    }
+
+private:
+    double Percentile(double p) const
+    {
+        const size_t rank = (size_t)std::ceil(p / 100.0 * times.size());
+        return times[std::max<size_t>(rank, 1) - 1];
+    }
+
+    std::vector<double> times;
+};
+
+// Schemes of the videos nested in uri, from the top down. fuse:// only
+// rearranges the filters below it, so has no video of its own.
+std::vector<std::string> UriSchemes(const std::string& uri)
+{
+    std::vector<std::string> schemes;
+    for(std::string s = uri; !s.empty(); ) {
+        const pangolin::Uri u = pangolin::ParseUri(s);
+        if(u.scheme != "fuse") schemes.push_back(u.scheme);
+        if(u.url.find("//") == std::string::npos) break;
+        s = u.url;
+    }
+    return schemes;
+}
+
+std::string JoinSchemes(const std::vector<std::string>& schemes, size_t begin, size_t end)
+{
+    std::string name;
+    for(size_t i = begin; i < std::min(end, schemes.size()); ++i) {
+        name += (name.empty() ? "" : "+") + schemes[i];
+    }
+    return name.empty() ? "filter" : name;
+}
+
+// Allocations made so far, through operator new and from the image pool
+struct AllocationCount
+{
+    static AllocationCount Now()
+    {
+        const pangolin::ImageMemoryPool::Stats pool = pangolin::ImageMemoryPool::Instance().GetStats();
+        return {NumAllocations(), NumAllocatedBytes(), pool.reuses, pool.allocations - pool.reuses};
+    }
+
+    size_t allocations;
+    size_t allocated_bytes;
+    size_t pool_hits;
+    size_t pool_misses;
+};
+
+void AddAllocationsPerFrame(const AllocationCount& start, size_t frames, picojson::value& result)
+{
+    const AllocationCount end = AllocationCount::Now();
+    auto per_frame = [&](size_t count) { return frames ? (double)count / frames : 0.0; };
+    result["allocations_per_frame"] = per_frame(end.allocations - start.allocations);
+    result["allocated_bytes_per_frame"] = per_frame(end.allocated_bytes - start.allocated_bytes);
+    result["pool_hits_per_frame"] = per_frame(end.pool_hits - start.pool_hits);
+    result["pool_misses_per_frame"] = per_frame(end.pool_misses - start.pool_misses);
+}
+
+int64_t FileSize(const std::string& filename)
+{
+    std::ifstream f(filename, std::ios::binary | std::ios::ate);
+    return f ? (int64_t)f.tellg() : -1;
+}
+
+// Grab frames from the whole pipeline, recording them if asked, and report
+// its throughput and the latency of each call.
+void RunPipeline(const BenchmarkCase& bc, size_t max_frames, picojson::value& result)
+{
+    std::unique_ptr<pangolin::VideoInterface> video = pangolin::OpenVideo(bc.uri);
+    std::unique_ptr<pangolin::VideoOutputInterface> output;
+    if(!bc.output_uri.empty()) {
+        output = pangolin::OpenVideoOutput(bc.output_uri);
+        output->SetStreams(video->Streams(), bc.uri, pangolin::GetVideoDeviceProperties(video.get()));
+    }
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    StageTimes grab_times, write_times;
+    size_t frames = 0;
+
+    video->Start();
+    const AllocationCount allocations = AllocationCount::Now();
+    const pangolin::basetime start = pangolin::TimeNow();
+
+    while(frames < max_frames) {
+        pangolin::basetime t = pangolin::TimeNow();
+        if(!video->GrabNext(image.data())) break;
+        grab_times.Add(ElapsedUs(t));
+
+        if(output) {
+            t = pangolin::TimeNow();
+            output->WriteStreams(image.data(), pangolin::GetVideoFrameProperties(video.get()));
+            write_times.Add(ElapsedUs(t));
+        }
+        ++frames;
+    }
+
+    const double grab_seconds = ElapsedUs(start) / 1e6;
+    AddAllocationsPerFrame(allocations, frames, result);
+
+    // Writes may be buffered, so flushing them counts towards throughput,
+    // though not towards the allocations made per frame
+    const pangolin::basetime flush_start = pangolin::TimeNow();
+    output.reset();
+    const double flush_seconds = ElapsedUs(flush_start) / 1e6;
+    const double seconds = grab_seconds + flush_seconds;
+    video->Stop();
+
+    const double bytes = (double)frames * video->SizeBytes();
+    result["frames"] = (int64_t)frames;
+    result["seconds"] = seconds;
+    result["frames_per_second"] = frames / seconds;
+    result["megabytes_per_second"] = bytes / seconds / 1e6;
+    result["stages"]["grab"] = grab_times.Summary();
+    if(!bc.output_uri.empty()) {
+        result["stages"]["write"] = write_times.Summary();
+        result["flush_seconds"] = flush_seconds;
+        const pangolin::Uri out = pangolin::ParseUri(bc.output_uri);
+        result["file_bytes"] = FileSize(out.url);
+    }
+}
+
+// Run the filters of the pipeline one after another on frames grabbed from
+// the video below them, timing each. Filters that can't be driven this way
+// (see FrameFilterInterface) are left in the pipeline and timed as part of
+// grabbing.
+void RunStages(const BenchmarkCase& bc, size_t max_frames, picojson::value& result)
+{
+    std::unique_ptr<pangolin::VideoInterface> video = pangolin::OpenVideo(bc.uri);
+    const std::vector<std::string> schemes = UriSchemes(bc.uri);
+
+    std::vector<pangolin::FrameFilterInterface*> stages;
+    std::vector<pangolin::VideoInterface*> stage_videos;
+    std::vector<std::string> names;
+    size_t scheme = 0;
+
+    pangolin::VideoInterface* base = video.get();
+    while(true) {
+        pangolin::FrameFilterInterface* stage = dynamic_cast<pangolin::FrameFilterInterface*>(base);
+        pangolin::VideoFilterInterface* filter = dynamic_cast<pangolin::VideoFilterInterface*>(base);
+        if(!stage || !filter || filter->InputStreams().size() != 1) break;
+
+        pangolin::FusedVideo* fused = dynamic_cast<pangolin::FusedVideo*>(base);
+        const size_t num_schemes = fused ? fused->Stages().size() : 1;
+        names.push_back(JoinSchemes(schemes, scheme, scheme + num_schemes));
+        scheme += num_schemes;
+
+        stages.push_back(stage);
+        stage_videos.push_back(base);
+        base = fused ? fused->Base() : filter->InputStreams()[0];
+    }
+    if(stages.empty()) return;
+
+    std::vector<std::vector<unsigned char>> buffers(stages.size() + 1);
+    buffers[stages.size()].resize(base->SizeBytes());
+    for(size_t i=0; i < stages.size(); ++i) {
+        buffers[i].resize(stage_videos[i]->SizeBytes());
+    }
+
+    std::vector<StageTimes> times(stages.size() + 1);
+    base->Start();
+    for(size_t frames = 0; frames < max_frames; ++frames) {
+        pangolin::basetime t = pangolin::TimeNow();
+        if(!base->GrabNext(buffers[stages.size()].data())) break;
+        times[stages.size()].Add(ElapsedUs(t));
+
+        const picojson::value& properties = pangolin::GetVideoFrameProperties(base);
+        for(size_t i = stages.size(); i-- > 0; ) {
+            t = pangolin::TimeNow();
+            stages[i]->ProcessFrame(buffers[i].data(), buffers[i+1].data(), properties);
+            times[i].Add(ElapsedUs(t));
+        }
+    }
+    base->Stop();
+
+    result["stages"][JoinSchemes(schemes, scheme, schemes.size())] = times[stages.size()].Summary();
+    for(size_t i = stages.size(); i-- > 0; ) {
+        result["stages"][names[i]] = times[i].Summary();
+    }
+}
+
+// Record the video a case plays back
+void RecordFixture(const BenchmarkCase& bc, size_t max_frames)
+{
+    std::unique_ptr<pangolin::VideoInterface> video = pangolin::OpenVideo(bc.fixture_uri);
+    std::unique_ptr<pangolin::VideoOutputInterface> output = pangolin::OpenVideoOutput(bc.fixture_output_uri);
+    output->SetStreams(video->Streams(), bc.fixture_uri, pangolin::GetVideoDeviceProperties(video.get()));
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    video->Start();
+    for(size_t frames = 0; frames < max_frames && video->GrabNext(image.data()); ++frames) {
+        output->WriteStreams(image.data(), pangolin::GetVideoFrameProperties(video.get()));
+    }
+    video->Stop();
+}
+
+// Seek to frames at random and grab them
+void RunSeek(const BenchmarkCase& bc, size_t num_seeks, picojson::value& result)
+{
+    std::unique_ptr<pangolin::VideoInterface> video = pangolin::OpenVideo(bc.uri);
+    pangolin::VideoPlaybackInterface* playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(*video);
+    if(!playback || playback->GetTotalFrames() == 0) {
+        throw std::runtime_error("Video doesn't support seeking");
+    }
+
+    std::vector<unsigned char> image(video->SizeBytes());
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<size_t> frame_dist(0, playback->GetTotalFrames() - 1);
+    StageTimes seek_times;
+    size_t seeks = 0;
+
+    video->Start();
+    const AllocationCount allocations = AllocationCount::Now();
+    const pangolin::basetime start = pangolin::TimeNow();
+    for(; seeks < num_seeks; ++seeks) {
+        const pangolin::basetime t = pangolin::TimeNow();
+        playback->Seek(frame_dist(rng));
+        if(!video->GrabNext(image.data())) break;
+        seek_times.Add(ElapsedUs(t));
+    }
+    const double seconds = ElapsedUs(start) / 1e6;
+    AddAllocationsPerFrame(allocations, seeks, result);
+    video->Stop();
+
+    result["frames"] = (int64_t)seeks;
+    result["seconds"] = seconds;
+    result["frames_per_second"] = seeks / seconds;
+    result["megabytes_per_second"] = (double)seeks * video->SizeBytes() / seconds / 1e6;
+    result["stages"]["seek"] = seek_times.Summary();
+}
+
+std::vector<BenchmarkCase> DefaultCases(const std::string& size, size_t frames, const std::string& dir)
+{
+    // Noise gives the encoders something realistic to compress, but costs
+    // more to generate than the filters do to run.
+    auto test = [&](const std::string& fmt, const std::string& pattern, const std::string& noise = "0") {
+        return "test:[size=" + size + ",fmt=" + fmt + ",pattern=" + pattern +
+               ",noise=" + noise + ",seed=1,frames=" + std::to_string(frames) + "]//";
+    };
+    auto file = [&](const std::string& name) {
+        return dir + "/bench_" + name + ".pango";
+    };
+    auto pango = [&](const std::string& encoder, const std::string& name) {
+        const std::string params = (encoder == "raw") ? "" : "[encoder=" + encoder + "]";
+        return "pango:" + params + "//" + file(name);
+    };
+
+    std::vector<BenchmarkCase> cases = {
+        {"source", test("RGB24", "gradient"), ""},
+        {"unpack", "unpack:[fmt=GRAY16LE]//" + test("GRAY12", "gradient"), ""},
+        {"debayer", "debayer:[tile=rggb,method=downsample]//" + test("GRAY8", "bayer"), ""},
+        {"gamma", "gamma:[gamma1=2.2]//" + test("RGB24", "gradient"), ""},
+        {"transform", "rotatecw://" + test("RGB24", "gradient"), ""},
+        {"unfused", "shift:[shift1=4]//unpack:[fmt=GRAY16LE]//" + test("GRAY12", "depth"), ""},
+        {"fused", "fuse://shift:[shift1=4]//unpack:[fmt=GRAY16LE]//" + test("GRAY12", "depth"), ""},
+        {"parallel", "parallel://debayer:[tile=rggb,method=downsample]//" + test("GRAY8", "bayer"), ""},
+    };
+
+    // Recording with each encoder, then playing back recordings of their own,
+    // so that they can be run alone
+    for(const std::string encoder : {"raw", "png", "jpg90", "ppm", "zstd", "lzf"}) {
+        cases.push_back({"record_" + encoder, test("RGB24", "gradient", "0.02"), pango(encoder, encoder)});
+    }
+    for(const std::string encoder : {"raw", "png", "jpg90"}) {
+        cases.push_back({"playback_" + encoder, "file://" + file("fixture_" + encoder), "", false,
+                         test("RGB24", "gradient", "0.02"), pango(encoder, "fixture_" + encoder)});
+    }
+    cases.push_back({"seek_raw", "file://" + file("fixture_raw"), "", true,
+                     test("RGB24", "gradient", "0.02"), pango("raw", "fixture_raw")});
+    return cases;
+}
+
+void Usage(const argagg::parser& argparser)
+{
+    std::cerr << "Usage:\n";
+    std::cerr << "  VideoBenchmark [options] [uri1 uri2 ...]\n\n";
+    std::cerr << "Runs video pipelines headlessly and reports their frame rate, throughput,\n";
+    std::cerr << "per stage latency percentiles, and heap allocations and image pool\n";
+    std::cerr << "hits / misses per frame as JSON. Without uris, a suite of synthetic\n";
+    std::cerr << "sources, filters, encoders and .pango playback is run.\n\n";
+    std::cerr << "Examples:\n";
+    std::cerr << "  VideoBenchmark --out bench.json\n";
+    std::cerr << "  VideoBenchmark --only record\n";
+    std::cerr << "  VideoBenchmark --only debayer --trace debayer.json\n";
+    std::cerr << "  VideoBenchmark \"debayer://file://video.pango\"\n\n";
+    std::cerr << "Options:\n";
+    std::cerr << argparser << std::endl;
+}
+
+int main( int argc, char* argv[] )
+{
+    argagg::parser argparser = {{
+        { "help", {"-h", "--help"}, "shows this help", 0},
+        { "frames", {"-n", "--frames"}, "number of frames per benchmark (default 100)", 1},
+        { "size", {"-s", "--size"}, "frame size of the synthetic source (default 1920x1080)", 1},
+        { "only", {"--only"}, "only run the benchmarks whose names contain this", 1},
+        { "record", {"-r", "--record"}, "record the given uris to this output uri", 1},
+        { "dir", {"--dir"}, "directory for the recordings made by the suite (default .)", 1},
+        { "keep", {"--keep"}, "keep the recordings made by the suite", 0},
+        { "out", {"-o", "--out"}, "write JSON results to this file rather than stdout", 1},
+        { "trace", {"--trace"}, "write a Chrome trace of the benchmark pipelines to this file", 1}
+    }};
+
+    argagg::parser_results args;
+    try{
+        args = argparser.parse(argc, argv);
+    }catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        Usage(argparser);
+        return 1;
+    }
+    if(args["help"]) {
+        Usage(argparser);
+        return 0;
+    }
+
+    const size_t frames = args["frames"].as<size_t>(100);
+    const std::string size = args["size"].as<std::string>("1920x1080");
+    const std::string dir = args["dir"].as<std::string>(".");
+    const std::string only = args["only"].as<std::string>("");
+
+    std::vector<BenchmarkCase> cases;
+    if(args.pos.empty()) {
+        cases = DefaultCases(size, frames, dir);
+    }else{
+        for(size_t i=0; i < args.pos.size(); ++i) {
+            cases.push_back({"uri" + std::to_string(i), args.pos[i], args["record"].as<std::string>("")});
+        }
+    }
+
+    picojson::value results;
+    results["frames"] = (int64_t)frames;
+    results["size"] = size;
+    results["benchmarks"] = picojson::value(picojson::array_type, false);
+
+    // Record what the selected cases play back first, outside of the trace. A
+    // case whose recording fails reports the error when opening it.
+    std::set<std::string> fixtures;
+    for(const BenchmarkCase& bc : cases) {
+        if(bc.name.find(only) == std::string::npos || bc.fixture_uri.empty()) continue;
+        if(!fixtures.insert(bc.fixture_output_uri).second) continue;
+        try{
+            RecordFixture(bc, frames);
+        }catch(const std::exception& e) {
+            std::cerr << "  Unable to record " << bc.fixture_output_uri << ": " << e.what() << std::endl;
+        }
+    }
+
+    if(args["trace"]) {
+        pangolin::Tracer::Instance().Start();
+    }
+
+    for(const BenchmarkCase& bc : cases) {
+        if(bc.name.find(only) == std::string::npos) continue;
+        std::cerr << "Running " << bc.name << "..." << std::endl;
+
+        picojson::value result;
+        result["name"] = bc.name;
+        result["uri"] = bc.uri;
+        if(!bc.output_uri.empty()) result["output_uri"] = bc.output_uri;
+
+        // A driver or encoder that isn't available fails its own benchmark only
+        try{
+            if(bc.seek) {
+                RunSeek(bc, frames, result);
+            }else{
+                RunPipeline(bc, frames, result);
+                RunStages(bc, frames, result);
+            }
+        }catch(const std::exception& e) {
+            result["error"] = std::string(e.what());
+            std::cerr << "  " << bc.name << " failed: " << e.what() << std::endl;
+        }
+        results["benchmarks"].push_back(result);
+    }
+
+    if(args["trace"]) {
+        pangolin::Tracer::Instance().Stop();
+        pangolin::Tracer::Instance().WriteChromeTrace(args["trace"].as<std::string>());
+    }
+
+    if(args.pos.empty() && !args["keep"]) {
+        for(const BenchmarkCase& bc : cases) {
+            if(!bc.output_uri.empty()) std::remove(pangolin::ParseUri(bc.output_uri).url.c_str());
+            if(!bc.fixture_output_uri.empty()) std::remove(pangolin::ParseUri(bc.fixture_output_uri).url.c_str());
+        }
+    }
+
+    const std::string json = results.serialize(true);
+    if(args["out"]) {
+        std::ofstream f(args["out"].as<std::string>());
+        f << json;
+        if(!f) {
+            std::cerr << "Unable to write " << args["out"].as<std::string>() << std::endl;
+            return 1;
+        }
+    }else{
+        std::cout << json;
+    }
+    return 0;
+}
@@ -2,19 +2,40 @@
 #include <pangolin/video/video_input.h>
 #include <pangolin/factory/factory_registry.h>
 #include <pangolin/utils/argagg.hpp>
+#include <pangolin/utils/bounded_queue.h>
+#include <pangolin/utils/reorder_queue.h>
 #include <pangolin/image/pixel_format.h>
 #include <pangolin/video/video_help.h>
+#include <pangolin/video/drivers/images_out.h>
+#include <pangolin/video/drivers/pango.h>
+#include <pangolin/video/drivers/pango_video_output.h>
 
-void VideoConvert(const std::string& input_uri, const std::string& output_uri)
+#include <thread>
+
+struct ConvertFrame
 {
-    pangolin::Var<bool> video_wait("video.wait", true);
-    pangolin::Var<bool> video_newest("video.newest", false);
+    size_t seq;
+    std::vector<char> packet;           // Undecoded input, when workers decode
+    std::vector<unsigned char> image;   // Decoded frame
+    std::vector<uint8_t> encoded;       // Encoded output, when workers encode
+    picojson::value properties;
+};
+
+using ConvertFramePtr = std::unique_ptr<ConvertFrame>;
 
+// Frames are read in order on one thread, decoded and encoded on num_workers
+// threads, and written in order on the calling thread. At most depth frames
+// are in flight at once. Decoding is only moved to the workers for .pango
+// input, and encoding only for .pango output; other drivers do this inside
+// GrabNext / WriteStreams.
+void VideoConvert(const std::string& input_uri, const std::string& output_uri, size_t num_workers, size_t depth)
+{
     // Open Video by URI
-    pangolin::VideoInput video(input_uri, output_uri);
+    pangolin::VideoInput video(input_uri);
     const size_t num_streams = video.Streams().size();
 
     pangolin::VideoPlaybackInterface* playback = pangolin::FindFirstMatchingVideoInterface<pangolin::VideoPlaybackInterface>(video);
+    pangolin::PangoVideo* pango_in = video.Cast<pangolin::PangoVideo>();
 
     // Output details of video stream
     for(size_t s = 0; s < num_streams; ++s)
@@ -24,25 +45,112 @@ void VideoConvert(const std::string& input_uri, const std::string& output_uri)
                   << " " << si.PixFormat().format << " (pitch: " << si.Pitch() << " bytes)" << std::endl;
     }
 
-    // Image buffers
-    std::vector<pangolin::Image<unsigned char> > images;
-    std::vector<unsigned char> buffer;
-    buffer.resize(video.SizeBytes()+1);
+    std::unique_ptr<pangolin::VideoOutputInterface> output = pangolin::OpenVideoOutput(output_uri);
+    output->SetStreams(video.Streams(), input_uri, pangolin::GetVideoDeviceProperties(&video));
+    pangolin::PangoVideoOutput* pango_out = dynamic_cast<pangolin::PangoVideoOutput*>(output.get());
+    const pangolin::ImagesVideoOutput* images_out = dynamic_cast<pangolin::ImagesVideoOutput*>(output.get());
 
-    // Record all frames
-    video.Record();
+    std::cout << "Converting with " << num_workers << " workers"
+              << (pango_in ? ", decoding in parallel" : "")
+              << (pango_out ? ", encoding in parallel" : "") << std::endl;
 
-    // Stream video
-    while(true)
-    {
-        if( !video.Grab(&buffer[0], images, video_wait, video_newest) ) {
-            break;
+    pangolin::BoundedQueue<ConvertFramePtr> free_frames(depth);
+    pangolin::BoundedQueue<ConvertFramePtr> todo(depth);
+    pangolin::ReorderQueue<ConvertFramePtr> done;
+
+    for(size_t i=0; i < depth; ++i) {
+        ConvertFramePtr frame(new ConvertFrame);
+        frame->image.resize(video.SizeBytes());
+        free_frames.Push(std::move(frame));
+    }
+
+    auto abort = [&](const std::exception& e){
+        std::cerr << std::endl << e.what() << std::endl;
+        free_frames.Close();
+        todo.Close();
+        done.Abort();
+    };
+
+    video.Start();
+
+    std::thread reader([&](){
+        try{
+            size_t seq = 0;
+            ConvertFramePtr frame;
+            while(free_frames.Pop(frame)) {
+                const bool grabbed = pango_in ?
+                    pango_in->GrabPacket(frame->packet) :
+                    video.GrabNext(frame->image.data(), true);
+                if(!grabbed) break;
+
+                frame->seq = seq++;
+                frame->properties = pangolin::GetVideoFrameProperties(&video);
+                todo.Push(std::move(frame));
+            }
+            todo.Close();
+            done.Finish(seq);
+        }catch(const std::exception& e) {
+            abort(e);
         }
-        if( playback ) {
-            std::cout << "Frames complete: " << playback->GetCurrentFrameId() << " / " << playback->GetTotalFrames() << '\r';
-            std::cout.flush();
+    });
+
+    std::vector<std::thread> workers;
+    for(size_t i=0; i < num_workers; ++i) {
+        workers.emplace_back([&](){
+            try{
+                ConvertFramePtr frame;
+                while(todo.Pop(frame)) {
+                    if(pango_in) pango_in->DecodePacket(frame->packet, frame->image.data());
+                    if(pango_out) pango_out->EncodeStreams(frame->image.data(), frame->encoded);
+                    const size_t seq = frame->seq;
+                    done.Put(seq, std::move(frame));
+                }
+            }catch(const std::exception& e) {
+                abort(e);
+            }
+        });
+    }
+
+    // Write frames in order, reporting progress
+    const pangolin::basetime start = pangolin::TimeNow();
+    pangolin::basetime last_report = start;
+    size_t written = 0;
+    try{
+        ConvertFramePtr frame;
+        while(done.Get(written, frame)) {
+            if(pango_out) {
+                pango_out->WriteEncoded(frame->encoded, frame->properties);
+            }else{
+                output->WriteStreams(frame->image.data(), frame->properties);
+            }
+            ++written;
+            free_frames.Push(std::move(frame));
+
+            const pangolin::basetime now = pangolin::TimeNow();
+            if(pangolin::TimeDiff_us(last_report, now) > 500000) {
+                last_report = now;
+                const double elapsed_s = pangolin::TimeDiff_us(start, now) / 1e6;
+                std::cout << "Frames complete: " << written;
+                if(playback) std::cout << " / " << playback->GetTotalFrames();
+                std::cout << " (" << written / elapsed_s << " fps, "
+                          << written * video.SizeBytes() / (elapsed_s * 1024 * 1024) << " MB/s)";
+                if(images_out) {
+                    std::cout << " (" << images_out->Backlog() << " writing)  ";
+                }
+                std::cout << '\r';
+                std::cout.flush();
+            }
         }
-   }
+    }catch(const std::exception& e) {
+        abort(e);
+    }
+
+    reader.join();
+    for(std::thread& w : workers) w.join();
+
+    const double elapsed_s = pangolin::TimeDiff_us(start, pangolin::TimeNow()) / 1e6;
+    std::cout << std::endl << "Wrote " << written << " frames in " << elapsed_s << "s ("
+              << written / elapsed_s << " fps)" << std::endl;
 }
 
 int main( int argc, char* argv[] )
@@ -50,15 +158,18 @@ int main( int argc, char* argv[] )
     argagg::parser argparser = {{
         { "help", {"-h", "--help"}, "shows this help! duh!", 0},
         { "scheme", {"-s", "--scheme"}, "filters the help message by scheme", 1},
-        { "verbose", {"-v","--verbose"}, "verbose level in number, 0=list of schemes(default),1=scheme parameters,2=parameter details", 1}
+        { "verbose", {"-v","--verbose"}, "verbose level in number, 0=list of schemes(default),1=scheme parameters,2=parameter details", 1},
+        { "threads", {"-j", "--threads"}, "number of decode / encode worker threads (default: number of cores)", 1},
+        { "depth", {"-d", "--depth"}, "maximum number of frames in flight (default: 2 x threads)", 1}
     }};
 
     argagg::parser_results args = argparser.parse(argc, argv);
     if( args["help"] || args.pos.size() == 0 ){
         std::cerr << "Usage:\n";
-        std::cerr << "  VideoConvert [options] VideoInputUri\n\n";
+        std::cerr << "  VideoConvert [options] VideoInputUri [VideoOutputUri]\n\n";
         std::cerr << "Examples:\n";
         std::cerr << "  VideoConvert test:[size=160x120,n=1,fmt=RGB24]//   Show the 'test' video driver with 160x120 resolution, 1 stream, RGB format.\n";
+        std::cerr << "  VideoConvert -j 8 raw.pango pango:[encoder=png]//compressed.pango   Compress a log on 8 threads\n";
         std::cerr << "  VideoConvert --help -s image                       Find out how to use the 'image' video driver\n\n";
         std::cerr << "Options:\n";
         std::cerr << argparser << std::endl;
@@ -73,8 +184,10 @@ int main( int argc, char* argv[] )
 
     const std::string input_uri = std::string(args.pos[0]);
     const std::string output_uri = ( args.pos.size() > 1) ? std::string(args.pos[1]) : dflt_output_uri;
+    const size_t threads = std::max<size_t>(1, args["threads"].as<size_t>(std::thread::hardware_concurrency()));
+    const size_t depth = std::max<size_t>(1, args["depth"].as<size_t>(2 * threads));
     try{
-        VideoConvert(input_uri, output_uri);
+        VideoConvert(input_uri, output_uri, threads, depth);
     } catch (const pangolin::VideoException& e) {
         std::cout << e.what() << std::endl;
     }
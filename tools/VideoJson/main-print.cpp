@@ -23,7 +23,7 @@ int main( int argc, char* argv[] )
             for(size_t framenum=0; framenum < src.index.size(); ++framenum) {
                 reader.Seek(src.id, framenum);
                 pangolin::Packet pkt = reader.NextFrame();
-                source_props["frame_properties"].push_back(pkt.meta);
+                source_props["frame_properties"].push_back(pkt.Meta());
             }
 
             all_properties.push_back(source_props);
@@ -10,7 +10,10 @@ int main( int argc, char* argv[] )
     argagg::parser argparser = {{
         { "help", {"-h", "--help"}, "shows this help message!", 0},
         { "scheme", {"-s", "--scheme"}, "filters the help message by scheme", 1},
-        { "verbose", {"-v","--verbose"}, "verbose level in number, 0=list of schemes(default),1=scheme parameters,2=parameter details", 1}
+        { "verbose", {"-v","--verbose"}, "verbose level in number, 0=list of schemes(default),1=scheme parameters,2=parameter details", 1},
+        { "threaded", {"-t", "--threaded"}, "grab and record on a dedicated thread, decoupled from rendering", 0},
+        { "thumbnails", {"--thumbnails"}, "build thumbnails in the background for fast scrubbing of recorded video", 0},
+        { "thumbnail_cache", {"--thumbnail-cache"}, "file to persist thumbnails to (implies --thumbnails)", 1}
     }};
 
     argagg::parser_results args = argparser.parse(argc, argv);
@@ -32,7 +35,11 @@ int main( int argc, char* argv[] )
     const std::string input_uri = std::string(args.pos[0]);
     const std::string output_uri = (args.pos.size() > 1 ) ? std::string(args.pos[1]) : dflt_output_uri;
     try{
-        pangolin::RunVideoViewerUI(input_uri, output_uri);
+        const std::string thumbnail_cache = args["thumbnail_cache"].as<std::string>("");
+        pangolin::RunVideoViewerUI(
+            input_uri, output_uri, args["threaded"],
+            args["thumbnails"] || !thumbnail_cache.empty(), thumbnail_cache
+        );
     } catch (const pangolin::VideoException& e) {
         std::cerr << e.what() << std::endl;
     }